@@ -17,6 +17,7 @@ var is_sprinting = false
 var npc_position = Vector2(1200, 600)
 var npc_interaction_range = 80.0
 var npc_name = "Fungal Merchant Morgrith"
+var npc_location = "fungal cavern"
 var is_near_npc = false
 
 #chest
@@ -76,6 +77,7 @@ var hurt_cooldown = 0.0
 #ai core
 var ai_core: Node
 var is_talking = false
+var dialog_streamed = false
 
 #ui references
 @onready var player_node: Node2D
@@ -253,10 +255,17 @@ func initialize_ai_async():
 	var api_key = load_api_key()
 	if api_key != "":
 		ai_core.set_api_key(api_key)
+		ai_core.set_dialog_streaming(true)
 		ai_core.initialize()
 		ai_core.dialog_ready.connect(_on_dialog_ready)
+		ai_core.dialog_chunk.connect(_on_dialog_chunk)
 		ai_core.request_failed.connect(_on_dialog_failed)
 		ai_core.item_pool_ready.connect(_on_items_preloaded)
+		
+		#generic merchant lines for both chest states, used when a live line fails
+		#(the state registered last is the one the merchant starts in)
+		ai_core.prepare_dialog_lines(npc_name, get_npc_dialog_setup(true)[0], [npc_location])
+		ai_core.prepare_dialog_lines(npc_name, get_npc_dialog_setup(false)[0], [npc_location])
 		print("AI Core initialized - preloading items in background...")
 		
 		#preload chest items
@@ -390,8 +399,14 @@ func _process(delta):
 	
 	#check distance to npc
 	var distance_to_npc = player_position.distance_to(npc_position)
+	var was_near_npc = is_near_npc
 	is_near_npc = distance_to_npc < npc_interaction_range
 	
+	#start on the greeting as the player walks up, it is ready by the time they press E
+	if is_near_npc and not was_near_npc and ai_core and ai_core.is_initialized():
+		var setup = get_npc_dialog_setup(chest_opened)
+		ai_core.prefetch_emotion_dialog(npc_name, setup[1], setup[0])
+	
 	#check distance to chest
 	var distance_to_chest = player_position.distance_to(chest_position)
 	is_near_chest = distance_to_chest < chest_interaction_range and not chest_opened
@@ -454,6 +469,7 @@ func interact_with_npc():
 	dialog_box.visible = true
 	dialog_text.clear()
 	dialog_text.append_text("[color=gray]Generating dialog...[/color]\n")
+	dialog_streamed = false
 	
 	if not ai_core or not ai_core.is_initialized():
 		#fallback if no ai
@@ -461,11 +477,15 @@ func interact_with_npc():
 		show_fallback_dialog()
 		return
 	
-	#different personality based on chest state
+	var setup = get_npc_dialog_setup(chest_opened)
+	ai_core.request_emotion_dialog(npc_name, setup[1], setup[0])
+
+#personality and context for the merchant, different based on chest state
+func get_npc_dialog_setup(after_chest: bool) -> Array:
 	var personality = {}
 	var context = ""
 	
-	if not chest_opened:
+	if not after_chest:
 		#before chest opened
 		personality = {
 			"npc_id": "merchant_morgrith",
@@ -520,13 +540,25 @@ func interact_with_npc():
 		}
 		context = "player returns after finding chest, merchant tells about secret door in brush"
 	
-	ai_core.request_emotion_dialog(npc_name, context, personality)
+	return [personality, context]
 
 func close_dialog():
 	is_talking = false
 	dialog_box.visible = false
 
+func _on_dialog_chunk(chunk: String):
+	#start typing as soon as the first words arrive
+	if not dialog_streamed:
+		dialog_streamed = true
+		dialog_text.clear()
+		dialog_text.append_text("[color=cyan]%s:[/color]\n" % npc_name)
+		dialog_text.push_color(Color.WHITE)
+		dialog_text.add_text('"')
+	dialog_text.add_text(chunk)
+
 func _on_dialog_ready(dialog: String):
+	#replace the streamed text with the final line
+	dialog_streamed = false
 	dialog_text.clear()
 	dialog_text.append_text("[color=cyan]%s:[/color]\n" % npc_name)
 	dialog_text.append_text('[color=white]"%s"[/color]\n\n' % dialog)
@@ -561,6 +593,12 @@ func show_fallback_dialog():
 			"Good job finding my chest! But there's a door... hidden where the mushrooms grow thick! Find it!"
 		]
 	
+	#a pregenerated line in the merchant's voice beats the canned ones
+	if ai_core and ai_core.is_initialized():
+		var banked = ai_core.get_dialog_line(npc_name, "greeting", npc_location)
+		if banked != "":
+			fallback_dialogs = [banked]
+	
 	var dialog = fallback_dialogs[randi() % fallback_dialogs.size()]
 	
 	dialog_text.clear()
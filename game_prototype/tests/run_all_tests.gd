@@ -19,6 +19,21 @@ var tests = [
 		"name": "Emotion Dialog Module (Alexandra's Module)",
 		"scene": "res://tests/test_dialog_module.tscn",
 		"wait_time": 15.0
+	},
+	{
+		"name": "HTTP Client Connection Reuse (local stand-in server)",
+		"scene": "res://tests/test_http_client.tscn",
+		"wait_time": 3.0
+	},
+	{
+		"name": "Response Cache (local stand-in server)",
+		"scene": "res://tests/test_response_cache.tscn",
+		"wait_time": 2.0
+	},
+	{
+		"name": "Native Benchmarks",
+		"scene": "res://tests/test_benchmarks.tscn",
+		"wait_time": 10.0
 	}
 ]
 
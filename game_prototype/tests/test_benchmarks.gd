@@ -0,0 +1,50 @@
+extends Node2D
+
+## Native Benchmarks Test
+## Runs the module's microbenchmarks and prints legacy vs native timings.
+## Timings depend on the machine, only the correctness checks and the 1 ms pool load budget can fail
+
+const BENCHMARKS = [
+	{"name": "request_body", "options": {"iterations": 2000, "sizes": [1024, 10240]}},
+	{"name": "response_parse", "options": {"iterations": 5000}},
+	{"name": "item_parse", "options": {"iterations": 200, "counts": [10, 100, 1000]}},
+	{"name": "pool_load", "options": {"iterations": 200, "counts": [10, 100, 1000]}},
+	{"name": "item_sample", "options": {"iterations": 1000000, "floor": 5}},
+	{"name": "pool_snapshot", "options": {"iterations": 200, "counts": [10, 100, 1000], "page_size": 20}},
+	{"name": "procedural_items", "options": {"iterations": 200, "counts": [10, 100, 1000]}},
+]
+
+func _ready():
+	print("=== Running Native Benchmarks ===\n")
+
+	var ai_core = NecronomiCore.new()
+	add_child(ai_core)
+
+	for benchmark in BENCHMARKS:
+		var result = ai_core.run_benchmark(benchmark["name"], benchmark["options"])
+		if result.has("error"):
+			print("❌ ", result["error"])
+			continue
+
+		print("--- ", result["name"], " ---")
+		for entry in result["cases"]:
+			print("%s: legacy %.0f ns, native %.0f ns (%.1fx, %d iterations)" % [
+				entry["label"], entry["legacy_ns"], entry["native_ns"], entry["speedup"], entry["iterations"]])
+			if entry.has("samples_per_second"):
+				print("   %.1f million samples per second" % (entry["samples_per_second"] / 1000000.0))
+			if entry.has("first_load_ns"):
+				check(entry["first_load_ns"] < 1000000.0, "Cold load under 1 ms", "Cold load took %.0f ns" % entry["first_load_ns"])
+			if entry.has("items_per_ms"):
+				check(entry["items_per_ms"] >= 1000.0, "%.0f procedural items per ms" % entry["items_per_ms"],
+					"Only %.0f procedural items per ms" % entry["items_per_ms"])
+			if entry.has("items_valid"):
+				check(entry["items_valid"], "Generated items named and within their rarity limits", "Generated item out of bounds")
+			if entry.has("outputs_match"):
+				check(entry["outputs_match"], "Same output as the legacy path", "Output differs from the legacy path")
+		print("")
+
+func check(condition: bool, ok_message: String, fail_message: String):
+	if condition:
+		print("✅ ", ok_message)
+	else:
+		print("❌ ", fail_message)
@@ -27,6 +27,8 @@ func _ready():
 	
 	# Connect signals
 	ai_core.item_pool_ready.connect(_on_items_ready)
+	ai_core.item_pool_updated.connect(_on_items_updated)
+	ai_core.item_generated.connect(_on_item_generated)
 	ai_core.request_failed.connect(_on_request_failed)
 	
 	# Test item generation
@@ -60,6 +62,16 @@ func _on_items_ready(items):
 		print("     Damage: ", item["damage"], " | Defense: ", item["defense"])
 		print("     Flavor: ", item["flavor_text"])
 		print("     ---")
+	var memory = get_child(0).get_item_pool_memory_stats()
+	print("🧠 Cached pools: ", memory.pools.size(), " using ", memory.used, " of ", memory.limit, " bytes")
+
+func _on_item_generated(item):
+	# each item as soon as it has streamed in, before the pool is ready
+	print("✨ Generated: ", item.name)
+
+func _on_items_updated(items):
+	# later items of the same pool, merged in as they arrive
+	print("🔄 Pool grew to ", items.size(), " items")
 
 func _on_request_failed(error):
 	print("\n❌ ERROR: ", error)
@@ -87,6 +87,61 @@ func _ready():
 		"Player asks about the ancient fungal ruins",
 		scholar_personality
 	)
+	
+	await get_tree().create_timer(5.0).timeout
+	
+	print("\n📝 Test 3: Long Conversation (bounded memory)")
+	print("============================================================")
+	
+	# only the last 2 turns are kept verbatim, older ones are summarized in the background
+	ai_core.set_dialog_history_length(2)
+	for i in range(4):
+		ai_core.request_emotion_dialog(
+			"Fungus Vendor Morgrith",
+			"Player keeps haggling over the price of spores",
+			merchant_personality
+		)
+		await ai_core.dialog_ready
+	
+	await get_tree().create_timer(3.0).timeout
+	var memory = ai_core.get_dialog_memory_stats()
+	print("🧠 Dialog memory: ", memory.used, " bytes, ", memory.summaries, " summaries")
+	for npc in memory.npcs:
+		print("  ", npc.npc_id, ": ", npc.turns, " turns kept, ", npc.pending, " pending, summary ", npc.summary_bytes, " bytes")
+	
+	print("\n📝 Test 4: Prefetched Greeting")
+	print("============================================================")
+	
+	# generated while the player walks up, the request itself then needs no round trip
+	ai_core.prefetch_emotion_dialog("Elder Mycologist", "Player approaches the scholar's desk", scholar_personality)
+	await get_tree().create_timer(4.0).timeout
+	var started = Time.get_ticks_msec()
+	ai_core.request_emotion_dialog("Elder Mycologist", "Player approaches the scholar's desk", scholar_personality)
+	await ai_core.dialog_ready
+	var prefetch = ai_core.get_dialog_prefetch_stats()
+	print("⚡ Line after ", Time.get_ticks_msec() - started, " ms, hit rate ", prefetch.hit_rate, ", wasted tokens ", prefetch.wasted_tokens)
+	
+	print("\n📝 Test 5: Line Banks")
+	print("============================================================")
+	
+	# one request fills greetings, farewells, barks and idle lines, served without a request
+	ai_core.prepare_dialog_lines("Fungus Vendor Morgrith", merchant_personality, ["dark fungal cavern"])
+	await get_tree().create_timer(6.0).timeout
+	for kind in ["greeting", "farewell", "bark", "idle"]:
+		print("  ", kind, ": ", ai_core.get_dialog_line("Fungus Vendor Morgrith", kind, "dark fungal cavern"))
+	var banks = ai_core.get_dialog_line_stats()
+	print("📚 ", banks.banks, " banks, ", banks.lines, " lines, ", banks.served, " served, ", banks.refills, " requests")
+	
+	print("\n📝 Test 6: Environmental Messages")
+	print("============================================================")
+	
+	# every call returns at once, the pool fills in the background
+	ai_core.prepare_environmental_messages("flooded crypt", 4)
+	await get_tree().create_timer(6.0).timeout
+	for i in range(3):
+		print("  🪨 ", ai_core.get_environmental_message("flooded crypt", 4))
+	var walls = ai_core.get_environmental_message_stats()
+	print("🧱 ", walls.queued, " queued, ", walls.served, " served, ", walls.fallbacks, " fallbacks, ", walls.refills, " requests")
 
 func load_api_key():
 	if FileAccess.file_exists("res://api_config.json"):
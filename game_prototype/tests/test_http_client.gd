@@ -0,0 +1,188 @@
+extends Node2D
+
+## HTTP Client Connection Reuse Test
+## Runs a local HTTP stand-in server and checks that NecronomiCore reuses
+## one keep-alive connection, then compares latency against forced reconnects
+
+const PORT = 18420
+const REQUESTS_PER_PHASE = 5
+const CANNED_BODY = '{"choices":[{"message":{"role":"assistant","content":"The spores remember your footsteps."}}]}'
+
+var ai_core
+var server_thread: Thread
+var server_mutex = Mutex.new()
+var server_running = true
+var keep_alive = true
+var accepted_connections = 0
+
+var phase = "keep-alive"
+var request_index = 0
+var request_started_usec = 0
+var latencies = {"keep-alive": [], "reconnect": []}
+
+func _ready():
+	print("=== Testing HTTP Client Connection Reuse ===\n")
+
+	server_thread = Thread.new()
+	server_thread.start(_run_server)
+
+	ai_core = NecronomiCore.new()
+	add_child(ai_core)
+
+	# No real API key needed, requests go to the local stand-in
+	ai_core.set_api_key("sk-local-stand-in")
+	ai_core.set_base_url("http://127.0.0.1:%d/v1" % PORT)
+	# Every request has to reach the server, cached answers would skip the connection
+	ai_core.set_response_cache_enabled(false)
+	ai_core.initialize()
+
+	ai_core.dialog_ready.connect(_on_dialog_ready)
+	ai_core.request_failed.connect(_on_error)
+
+	await get_tree().create_timer(0.2).timeout
+	send_next_request()
+
+func send_next_request():
+	request_started_usec = Time.get_ticks_usec()
+	ai_core.request_emotion_dialog(
+		"Stand-in Shade",
+		"Connection test %s #%d" % [phase, request_index],
+		{"archetype": "test echo", "current_mood": "patient"}
+	)
+
+func _on_dialog_ready(_dialog_text):
+	latencies[phase].append(Time.get_ticks_usec() - request_started_usec)
+	request_index += 1
+
+	if request_index < REQUESTS_PER_PHASE:
+		send_next_request()
+		return
+
+	if phase == "keep-alive":
+		report_keep_alive_phase()
+		# Second phase: server closes after every response
+		server_mutex.lock()
+		keep_alive = false
+		server_mutex.unlock()
+		phase = "reconnect"
+		request_index = 0
+		send_next_request()
+	else:
+		report_latency()
+
+func report_keep_alive_phase():
+	var stats = ai_core.get_network_stats()
+	server_mutex.lock()
+	var connections = accepted_connections
+	server_mutex.unlock()
+
+	print("Keep-alive phase: ", REQUESTS_PER_PHASE, " requests over ", connections, " connection(s)")
+	print("  Client stats: ", stats)
+
+	if connections == 1 and stats.get("connections_reused", 0) == REQUESTS_PER_PHASE - 1:
+		print("✅ Connection reused across requests")
+	else:
+		print("❌ Expected 1 connection and ", REQUESTS_PER_PHASE - 1, " reuses")
+
+func report_latency():
+	var warm = latencies["keep-alive"].slice(1)
+	var cold = latencies["reconnect"]
+	print("\nLatency (usec):")
+	print("  First request (connect):  ", latencies["keep-alive"][0])
+	print("  Reused connection (avg):  ", average(warm))
+	print("  New connection each (avg): ", average(cold))
+
+	if average(warm) <= average(cold):
+		print("✅ Reused connections are faster than reconnecting")
+	else:
+		print("⚠️  Reused connections were not faster on this run")
+
+func average(values: Array) -> float:
+	if values.is_empty():
+		return 0.0
+	var total = 0.0
+	for value in values:
+		total += value
+	return total / values.size()
+
+func _on_error(error):
+	print("\n❌ Error: ", error)
+
+func _exit_tree():
+	server_mutex.lock()
+	server_running = false
+	server_mutex.unlock()
+	if server_thread and server_thread.is_started():
+		server_thread.wait_to_finish()
+
+## Minimal HTTP/1.1 stand-in for the OpenAI endpoint
+func _run_server():
+	var server = TCPServer.new()
+	if server.listen(PORT, "127.0.0.1") != OK:
+		print("❌ Could not listen on port ", PORT)
+		return
+
+	var peers = []
+	while true:
+		server_mutex.lock()
+		var running = server_running
+		server_mutex.unlock()
+		if not running:
+			break
+
+		if server.is_connection_available():
+			peers.append({"stream": server.take_connection(), "buffer": PackedByteArray()})
+			server_mutex.lock()
+			accepted_connections += 1
+			server_mutex.unlock()
+
+		for peer in peers.duplicate():
+			var stream: StreamPeerTCP = peer["stream"]
+			stream.poll()
+			if stream.get_status() != StreamPeerTCP.STATUS_CONNECTED:
+				peers.erase(peer)
+				continue
+
+			var available = stream.get_available_bytes()
+			if available > 0:
+				peer["buffer"].append_array(stream.get_data(available)[1])
+
+			if _try_answer(peer):
+				peers.erase(peer)
+
+		OS.delay_msec(1)
+
+	server.stop()
+
+## Answers one complete request; returns true when the connection was closed
+func _try_answer(peer) -> bool:
+	var text = peer["buffer"].get_string_from_utf8()
+	var header_end = text.find("\r\n\r\n")
+	if header_end == -1:
+		return false
+
+	var content_length = 0
+	for line in text.substr(0, header_end).split("\r\n"):
+		if line.to_lower().begins_with("content-length:"):
+			content_length = int(line.split(":")[1].strip_edges())
+
+	var request_size = header_end + 4 + content_length
+	if peer["buffer"].size() < request_size:
+		return false
+	peer["buffer"] = peer["buffer"].slice(request_size)
+
+	server_mutex.lock()
+	var keep = keep_alive
+	server_mutex.unlock()
+
+	var body = CANNED_BODY.to_utf8_buffer()
+	var head = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: %s\r\n\r\n" % [body.size(), "keep-alive" if keep else "close"]
+	var stream: StreamPeerTCP = peer["stream"]
+	var response = head.to_utf8_buffer()
+	response.append_array(body)
+	stream.put_data(response)
+
+	if not keep:
+		stream.disconnect_from_host()
+		return true
+	return false
@@ -0,0 +1,149 @@
+extends Node2D
+
+## Response Cache Test
+## Sends the same dialog request twice against a local stand-in server and
+## checks that the repeat is answered from the cache without reaching the network
+
+const PORT = 18421
+const CANNED_BODY = '{"choices":[{"message":{"role":"assistant","content":"The mycelium already told me you would ask."}}]}'
+
+var ai_core
+var server_thread: Thread
+var server_mutex = Mutex.new()
+var server_running = true
+var served_requests = 0
+
+# Unique per run so the first request is never answered by an earlier run's disk cache
+var run_mood = "curious-%d" % Time.get_unix_time_from_system()
+var step = 0
+var stats_before = {}
+
+func _ready():
+	print("=== Testing Response Cache ===\n")
+
+	server_thread = Thread.new()
+	server_thread.start(_run_server)
+
+	ai_core = NecronomiCore.new()
+	add_child(ai_core)
+
+	ai_core.set_api_key("sk-local-stand-in")
+	ai_core.set_base_url("http://127.0.0.1:%d/v1" % PORT)
+	ai_core.initialize()
+
+	ai_core.dialog_ready.connect(_on_dialog_ready)
+	ai_core.request_failed.connect(_on_error)
+
+	await get_tree().create_timer(0.2).timeout
+	stats_before = ai_core.get_cache_stats()
+	send_request(run_mood)
+
+func send_request(mood: String):
+	ai_core.request_emotion_dialog(
+		"Cache Warden",
+		"Cache test",
+		{"archetype": "archivist", "current_mood": mood}
+	)
+
+func _on_dialog_ready(dialog_text):
+	var served = get_served_requests()
+	var stats = ai_core.get_cache_stats()
+
+	match step:
+		0:
+			print("First request: ", dialog_text)
+			check(served == 1, "First request went to the server", "Expected 1 server request, got %d" % served)
+			step = 1
+			send_request(run_mood)
+		1:
+			print("Repeated request: ", dialog_text)
+			check(served == 1, "Repeated request answered from cache", "Repeated request reached the server")
+			check(stats["hits"] - stats_before.get("hits", 0) == 1, "Cache hit counted", "Expected one new cache hit")
+			step = 2
+			send_request(run_mood + "-changed")
+		2:
+			check(served == 2, "Changed prompt bypassed the cache", "Changed prompt was served from cache")
+			print("\nCache stats: ", stats)
+
+func check(condition: bool, ok_message: String, fail_message: String):
+	if condition:
+		print("✅ ", ok_message)
+	else:
+		print("❌ ", fail_message)
+
+func get_served_requests() -> int:
+	server_mutex.lock()
+	var count = served_requests
+	server_mutex.unlock()
+	return count
+
+func _on_error(error):
+	print("\n❌ Error: ", error)
+
+func _exit_tree():
+	server_mutex.lock()
+	server_running = false
+	server_mutex.unlock()
+	if server_thread and server_thread.is_started():
+		server_thread.wait_to_finish()
+
+## Minimal HTTP/1.1 stand-in for the OpenAI endpoint, counts answered requests
+func _run_server():
+	var server = TCPServer.new()
+	if server.listen(PORT, "127.0.0.1") != OK:
+		print("❌ Could not listen on port ", PORT)
+		return
+
+	var peers = []
+	while true:
+		server_mutex.lock()
+		var running = server_running
+		server_mutex.unlock()
+		if not running:
+			break
+
+		if server.is_connection_available():
+			peers.append({"stream": server.take_connection(), "buffer": PackedByteArray()})
+
+		for peer in peers.duplicate():
+			var stream: StreamPeerTCP = peer["stream"]
+			stream.poll()
+			if stream.get_status() != StreamPeerTCP.STATUS_CONNECTED:
+				peers.erase(peer)
+				continue
+
+			var available = stream.get_available_bytes()
+			if available > 0:
+				peer["buffer"].append_array(stream.get_data(available)[1])
+
+			_try_answer(peer)
+
+		OS.delay_msec(1)
+
+	server.stop()
+
+func _try_answer(peer):
+	var text = peer["buffer"].get_string_from_utf8()
+	var header_end = text.find("\r\n\r\n")
+	if header_end == -1:
+		return
+
+	var content_length = 0
+	for line in text.substr(0, header_end).split("\r\n"):
+		if line.to_lower().begins_with("content-length:"):
+			content_length = int(line.split(":")[1].strip_edges())
+
+	var request_size = header_end + 4 + content_length
+	if peer["buffer"].size() < request_size:
+		return
+	peer["buffer"] = peer["buffer"].slice(request_size)
+
+	server_mutex.lock()
+	served_requests += 1
+	server_mutex.unlock()
+
+	var body = CANNED_BODY.to_utf8_buffer()
+	var head = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: keep-alive\r\n\r\n" % body.size()
+	var response = head.to_utf8_buffer()
+	response.append_array(body)
+	peer["stream"].put_data(response)
@@ -0,0 +1,42 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <string>
+#include <vector>
+#include <godot_cpp/variant/dictionary.hpp>
+
+namespace necronomicore {
+
+//microbenchmarks for the module's hot paths
+//each one times the previous implementation against the current one on the
+//same input and reports ns per operation, run through NecronomiCore::run_benchmark
+class Benchmarks {
+private:
+    //chat request body: Dictionary + JSON::stringify vs JSONWriter into a reused buffer
+    static godot::Dictionary request_body(const godot::Dictionary& options);
+    //response content and usage: JSON::parse + Dictionary lookups vs JSONReader path lookups
+    static godot::Dictionary response_parse(const godot::Dictionary& options);
+    //generated item content: JSON::parse + per-item stringify/parse vs the single-pass item parser
+    static godot::Dictionary item_parse(const godot::Dictionary& options);
+    //restart load of a generated pool: single-pass parse of the content vs the mapped pool store
+    static godot::Dictionary pool_load(const godot::Dictionary& options);
+    //item picks: rand() over rarity buckets vs alias tables over the columnar store,
+    //and per-item clamping vs the column clamp
+    static godot::Dictionary item_sample(const godot::Dictionary& options);
+    //pool queries: a Dictionary per item on every call vs the versioned snapshot cache,
+    //a page of it, and the packed export
+    static godot::Dictionary pool_snapshot(const godot::Dictionary& options);
+    //filling a pool: parsing the model's content (network time not counted) vs the
+    //procedural generator, with items_per_ms for the generator
+    static godot::Dictionary procedural_items(const godot::Dictionary& options);
+
+public:
+    //{"name", "cases": [{"label", "iterations", "bytes", "legacy_ns", "native_ns", "speedup", ...}]}
+    //or {"error"} for an unknown name
+    static godot::Dictionary run(const std::string& name, const godot::Dictionary& options);
+    static std::vector<std::string> get_names();
+};
+
+} // namespace necronomicore
+
+#endif // BENCHMARKS_H
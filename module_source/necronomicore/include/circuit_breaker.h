@@ -0,0 +1,73 @@
+#ifndef CIRCUIT_BREAKER_H
+#define CIRCUIT_BREAKER_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+namespace necronomicore {
+
+enum class CircuitState {
+    CLOSED,    //requests go out normally
+    OPEN,      //upstream considered down, requests fail fast
+    HALF_OPEN, //cooldown over, a probe is checking the upstream
+};
+
+//per-endpoint counters
+struct CircuitStats {
+    CircuitState state = CircuitState::CLOSED;
+    int consecutive_failures = 0;
+    uint64_t trips = 0;
+    uint64_t fast_failures = 0;
+    uint64_t probes = 0;
+};
+
+//per-endpoint circuit breaker
+//opens after repeated upstream failures so callers can serve fallback content
+//at once instead of waiting out timeouts. once the cooldown passes the owner
+//sends a probe, its result closes the circuit or reopens it with a longer cooldown.
+//main thread only
+class CircuitBreaker {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Circuit {
+        CircuitStats stats;
+        Clock::time_point open_until;
+        double cooldown_seconds = 0.0;
+    };
+
+    std::map<std::string, Circuit> circuits;
+    int failure_threshold;
+    double base_cooldown_seconds;
+    double max_cooldown_seconds;
+
+    void trip(Circuit& circuit);
+
+public:
+    CircuitBreaker();
+
+    void set_failure_threshold(int failures);
+    void set_cooldown(double base_seconds, double max_seconds);
+
+    //true while requests to the endpoint should fail fast
+    bool is_open(const std::string& endpoint) const;
+    //counts a request turned away by the open circuit
+    void record_fast_failure(const std::string& endpoint);
+
+    //upstream answered (any non-5xx status) / upstream failed (timeout, connection, 5xx)
+    void record_success(const std::string& endpoint);
+    void record_failure(const std::string& endpoint);
+
+    //endpoints whose cooldown is over, moved to HALF_OPEN (one probe each)
+    std::vector<std::string> take_due_probes();
+    void record_probe_result(const std::string& endpoint, bool healthy);
+
+    CircuitStats get_stats(const std::string& endpoint) const;
+};
+
+} // namespace necronomicore
+
+#endif // CIRCUIT_BREAKER_H
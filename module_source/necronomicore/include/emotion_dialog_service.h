@@ -6,7 +6,11 @@
 #include <godot_cpp/variant/string.hpp>
 #include <memory>
 #include <map>
+#include <set>
+#include <unordered_map>
 #include <vector>
+#include <random>
+#include <string_view>
 
 namespace necronomicore {
 
@@ -40,27 +44,168 @@ struct NPCPersonality {
 struct DialogContext {
     std::string location;
     std::string recent_player_action;
-    std::vector<std::string> previous_dialog_lines;
+    std::vector<std::string> previous_dialog_lines; //oldest first
+    std::string conversation_summary; //what was said before previous_dialog_lines
     std::map<std::string, bool> world_state_flags;
     int player_sanity;
     bool first_encounter;
 };
 
+//one exchange, player is empty when the npc spoke unprompted
+struct DialogTurn {
+    std::string player;
+    std::string npc;
+};
+
+//what an npc remembers of the conversation
+//the latest turns sit in a fixed ring, older ones are folded into a short summary by a
+//background request. the prompt and the memory per npc stay the same size however long
+//the conversation runs
+struct DialogMemory {
+    std::vector<DialogTurn> turns; //ring, sized to the history length
+    size_t head = 0;               //oldest turn
+    size_t count = 0;
+    std::string summary;
+    std::vector<DialogTurn> evicted; //pushed out of the ring, not summarized yet
+    bool summary_pending = false;
+    size_t summarizing = 0;          //evicted turns the pending summary covers
+    uint64_t generation = 0;         //a cleared history gets a new one, stale summaries are dropped
+    
+    const DialogTurn& turn(size_t i) const { return turns[(head + i) % turns.size()]; }
+    size_t memory_bytes() const;
+};
+
+//greeting generated ahead of the player talking to the npc
+//kept with the persona and context it was rendered from, it is only served to a request
+//whose prompt renders to the same text
+struct SpeculativeLine {
+    std::string persona;
+    std::string context;
+    std::string line;
+    bool ready = false;
+    int tokens = 0;      //prompt and completion tokens it cost
+    uint64_t ticket = 0; //a replaced or discarded prefetch no longer matches its entry
+};
+
+//generic lines that do not answer the player, pregenerated in banks
+enum class DialogLineKind {
+    GREETING = 0, //the player walks up
+    FAREWELL = 1, //the player leaves
+    BARK = 2,     //short outburst showing the mood
+    IDLE = 3,     //muttering to themself
+};
+const int DIALOG_LINE_KIND_COUNT = 4;
+
+//shuffle bag, lines [next, size) have not been served since the last shuffle
+struct LineBag {
+    std::vector<std::string> lines;
+    size_t next = 0;
+    
+    size_t remaining() const { return lines.size() - next; }
+};
+
+//lines of one npc in one mood and location bucket
+struct LineBank {
+    LineBag bags[DIALOG_LINE_KIND_COUNT];
+    bool refill_pending = false;
+};
+
+//fixed-capacity ring of environmental messages for one location bucket and danger level
+//messages are taken from the head and batches appended at the tail, each one is shown once
+struct MessageRing {
+    std::vector<std::string> slots; //sized to the capacity when first filled
+    size_t head = 0;
+    size_t count = 0;
+    bool refill_pending = false;
+    
+    //false when the ring is full
+    bool push(std::string_view message);
+    bool pop(std::string& message);
+};
+
+//prompt rendering counters
+struct DialogPromptStats {
+    uint64_t persona_renders = 0;
+    uint64_t persona_reuses = 0;
+    size_t cached_personas = 0;
+};
+
 //emotion dialog service
-//generates npc dialogue based on personality
+//generates npc dialogue based on personality, main thread only
 class EmotionDialogService {
 private:
     std::shared_ptr<OpenAIClient> client;
     std::map<std::string, NPCPersonality> npc_personalities;
-    std::map<std::string, std::vector<std::string>> dialog_history;
+    std::map<std::string, DialogMemory> dialog_history;
+    size_t history_length;
+    uint64_t next_history_generation;
+    uint64_t summaries_written;
+    uint64_t summary_failures;
+    
+    //speculative greetings, one per npc
+    std::map<std::string, SpeculativeLine> speculative_lines;
+    uint64_t next_speculative_ticket;
+    uint64_t prefetches_sent;
+    uint64_t prefetch_hits;
+    uint64_t prefetches_discarded; //context changed before the player spoke
+    uint64_t prefetches_late;      //player spoke while it was still generating
+    uint64_t prefetch_wasted_tokens;
+    //late prefetches a live request joined, their response went to that request
+    std::set<uint64_t> joined_prefetches;
+    
+    //line banks by npc id, mood and location bucket
+    std::unordered_map<std::string, LineBank> line_banks;
+    std::mt19937_64 line_rng;
+    uint64_t bank_lines_served;
+    uint64_t bank_misses;
+    uint64_t bank_refills;
+    uint64_t bank_refill_failures;
+    
+    //environmental messages by location bucket and danger level
+    std::map<std::string, MessageRing> message_rings;
+    uint64_t messages_served;
+    uint64_t message_fallbacks;
+    uint64_t message_refills;
+    uint64_t messages_generated;
+    
+    //rendered persona per npc, dropped when the npc's traits change
+    std::map<std::string, std::string> persona_blocks;
+    DialogPromptStats prompt_stats;
     
     //prompt construction
-    std::string build_dialog_prompt(const NPCPersonality& personality,
-                                   const DialogContext& context,
-                                   const std::string& player_input);
+    //every request is [rules, persona, context]: the rules are the same for every npc and
+    //the persona for every line of one npc, so consecutive prompts share a long prefix the
+    //provider can cache. the messages are reused, rendering only overwrites their contents
+    std::vector<ChatMessage> prompt_messages;
+    const std::vector<ChatMessage>& build_dialog_messages(const std::string& npc_id,
+                                                          const NPCPersonality& personality,
+                                                          const DialogContext& context,
+                                                          std::string_view player_input);
+    const std::string& get_persona_block(const std::string& npc_id, const NPCPersonality& personality);
+    
+    //conversation memory
+    void record_turn(const std::string& npc_id, std::string_view player_input, const std::string& dialog);
+    void request_summary(const std::string& npc_id, DialogMemory& memory);
+    void fill_history(const std::string& npc_id, DialogContext& context) const;
+    DialogContext read_context(const std::string& npc_id, const godot::Dictionary& context_dict) const;
+    
+    //speculation
+    //true with the prefetched line when it was rendered from the same messages, any other
+    //prefetch for the npc is discarded. joining says the caller's request is byte-identical
+    //to a prefetch still in flight and coalesces with it, so that one is not wasted
+    bool take_speculative_line(const std::string& npc_id, const std::vector<ChatMessage>& messages,
+                               bool joining, std::string& line);
+    void discard_speculative_line(std::map<std::string, SpeculativeLine>::iterator it);
+    
+    //line banks
+    void request_bank_lines(const std::string& npc_id, const std::string& mood, const char* bucket);
+    void add_bank_lines(LineBank& bank, const std::string& content);
+    
+    //environmental messages, key is the bucket and danger level
+    void request_messages(const std::string& key, const char* bucket, int danger_level);
     
     //response parsing
-    std::string extract_dialog_from_response(const std::string& response_json);
+    std::string extract_dialog_from_response(const HTTPResponse& response);
     
     //personality updates
     void update_npc_mood(const std::string& npc_id, const std::string& player_action);
@@ -69,17 +214,52 @@ public:
     EmotionDialogService(std::shared_ptr<OpenAIClient> openai_client);
     ~EmotionDialogService();
 
+    //prompt templates, static so the benchmarks can render them directly
+    //the system message: game rules and output constraints, identical for every request
+    static std::string_view get_dialog_rules();
+    //who the npc is: name, archetype, sanity, traits and background, appended to out
+    static void render_persona(const NPCPersonality& personality, std::string& out);
+    //what changes from line to line: mood, location, recent events, the player's words
+    static void render_context(const NPCPersonality& personality,
+                               const DialogContext& context,
+                               std::string_view player_input,
+                               std::string& out);
+
     //npc management
     void register_npc(const godot::String& npc_id, const godot::Dictionary& personality);
     void update_npc_trait(const godot::String& npc_id, const godot::String& trait, float intensity);
     godot::Dictionary get_npc_personality(const godot::String& npc_id);
 
     //dialog generation
+    //on_chunk streams the line as it is generated, on_success still gets the full text
     void generate_dialog(const godot::String& npc_id,
                         const godot::String& player_input,
                         const godot::Dictionary& context,
                         std::function<void(const std::string&)> on_success,
-                        std::function<void(const std::string&)> on_error);
+                        std::function<void(const std::string&)> on_error,
+                        std::function<void(const std::string&)> on_chunk = nullptr);
+
+    //generates the line generate_dialog would produce with no player input, at background
+    //priority, and holds it. a later generate_dialog for the npc gets it at once if nothing
+    //in the prompt changed in between (persona, mood, context, history), otherwise it is dropped
+    void prefetch_dialog(const godot::String& npc_id, const godot::Dictionary& context);
+    //prefetches, hits, discarded, late, hit_rate, wasted_tokens and ready lines
+    godot::Dictionary get_prefetch_stats() const;
+
+    //line banks
+    //one request fills every kind for the npc's current mood and the location's bucket,
+    //called at run start for the places the npc will be met
+    void fill_line_bank(const godot::String& npc_id, const godot::String& location);
+    //a line from the bank in O(1), no line repeats until the bag has been served through.
+    //false when the bank is empty, which starts filling it. a bank running low refills
+    //itself in the background
+    bool get_bank_line(const godot::String& npc_id, DialogLineKind kind, const godot::String& location, std::string& line);
+    //banks, lines, unserved, served, misses, refills and failed refills
+    godot::Dictionary get_line_bank_stats() const;
+    //"greeting", "farewell", "bark" or "idle", any case
+    static bool parse_line_kind(std::string_view name, DialogLineKind& kind);
+    //coarse place a location falls into, banks are shared by every location in a bucket
+    static const char* location_bucket(std::string_view location);
 
     //sync version
     std::string generate_dialog_sync(const godot::String& npc_id,
@@ -91,12 +271,28 @@ public:
     int get_relationship_score(const godot::String& npc_id);
     
     //dialog history
+    //the npc's lines still in the ring, oldest first
     godot::Array get_dialog_history(const godot::String& npc_id);
     void clear_dialog_history(const godot::String& npc_id);
+    //turns kept verbatim per npc, at least 1, older turns survive only in the summary
+    void set_history_length(int turns);
+    int get_history_length() const;
+    //history_length, used bytes, summaries and failures, and per npc turns, pending turns,
+    //summary bytes and bytes
+    godot::Dictionary get_history_memory_stats() const;
+    
+    DialogPromptStats get_prompt_stats() const;
     
     //environmental messages
+    //context has location and danger_level (1 to 5). the callback runs before this returns,
+    //with a pooled message or a canned one while the pool is empty. pools are filled in
+    //batches in the background and refilled when they run low
     void generate_environmental_message(const godot::Dictionary& context,
                                        std::function<void(const std::string&)> callback);
+    //starts filling the pool for a context ahead of time, e.g. for the next floor's rooms
+    void fill_environmental_messages(const godot::Dictionary& context);
+    //rings, queued, served, fallbacks, refills and generated messages
+    godot::Dictionary get_environmental_message_stats() const;
 };
 
 } // namespace necronomicore
@@ -3,6 +3,8 @@
 
 #include <string>
 #include <map>
+#include <cstdint>
+#include <functional>
 
 namespace necronomicore {
 
@@ -15,18 +17,43 @@ struct SimpleHTTPResponse {
     std::string error;
 };
 
+/// Connection reuse counters for one HTTPClient
+struct HTTPClientStats {
+    uint64_t requests = 0;
+    uint64_t connections_opened = 0;
+    uint64_t connections_reused = 0;
+    uint64_t tls_handshakes = 0;
+    uint64_t tls_sessions_resumed = 0;
+};
+
 /// Minimal HTTP client for OpenAI API calls
-/// Platform-specific implementation (uses WinHTTP on Windows)
+/// Platform-specific implementation (WinHTTP on Windows, sockets + OpenSSL elsewhere)
+/// Keeps a per-host pool of keep-alive connections, so one client instance
+/// should be kept alive and shared instead of created per request.
+/// Safe to call from multiple threads.
 class HTTPClient {
 public:
+    // Receives body bytes of a successful response as they arrive
+    using BodyCallback = std::function<void(const char* data, size_t size)>;
+
     HTTPClient();
     ~HTTPClient();
 
+    HTTPClient(const HTTPClient&) = delete;
+    HTTPClient& operator=(const HTTPClient&) = delete;
+
     // POST request (primary method for OpenAI)
     SimpleHTTPResponse post(const std::string& url,
                           const std::map<std::string, std::string>& headers,
                           const std::string& body);
 
+    // Streaming POST: a 2xx body goes to on_data instead of response.body
+    // (error bodies are still buffered so they can be reported)
+    SimpleHTTPResponse post_stream(const std::string& url,
+                                 const std::map<std::string, std::string>& headers,
+                                 const std::string& body,
+                                 const BodyCallback& on_data);
+
     // GET request (for downloading images, etc.)
     SimpleHTTPResponse get(const std::string& url,
                          const std::map<std::string, std::string>& headers);
@@ -35,20 +62,27 @@ public:
     void set_timeout(int seconds);
     int get_timeout() const;
 
+    // Keep-alive pool configuration
+    void set_max_idle_connections_per_host(int count);
+    void set_idle_timeout(int seconds);
+    void close_idle_connections();
+
+    HTTPClientStats get_stats() const;
+
 private:
     int timeout_seconds;
-    
+
     // Platform-specific implementation details
-    void* platform_data; // Will hold WinHTTP handles on Windows
-    
+    void* platform_data; // WinHTTP session on Windows, connection pool elsewhere
+
     // Helper methods
     SimpleHTTPResponse make_request(const std::string& method,
                                    const std::string& url,
                                    const std::map<std::string, std::string>& headers,
-                                   const std::string& body);
+                                   const std::string& body,
+                                   const BodyCallback* on_data);
 };
 
 } // namespace necronomicore
 
 #endif // HTTP_CLIENT_H
-
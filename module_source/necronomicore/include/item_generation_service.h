@@ -2,11 +2,16 @@
 #define ITEM_GENERATION_SERVICE_H
 
 #include "openai_client.h"
+#include "item_pool_store.h"
+#include "item_store.h"
 #include <godot_cpp/variant/dictionary.hpp>
 #include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
 #include <vector>
 #include <string>
 #include <memory>
+#include <set>
+#include <random>
 
 namespace necronomicore {
 
@@ -33,14 +38,14 @@ enum class ItemType {
 struct ItemDefinition {
     std::string name;
     std::string description;
-    ItemType type;
-    ItemRarity rarity;
+    ItemType type = ItemType::WEAPON;
+    ItemRarity rarity = ItemRarity::COMMON;
     
     //stats
-    int damage;
-    int defense;
-    int healing;
-    float cooldown;
+    int damage = 0;
+    int defense = 0;
+    int healing = 0;
+    float cooldown = 0.0f;
     
     //special properties
     std::vector<std::string> effects;
@@ -53,44 +58,185 @@ struct ItemDefinition {
     //convert to godot dictionary
     godot::Dictionary to_dictionary() const;
     
-    //parse from json
+    //parse from json (a single item object)
     static ItemDefinition from_json(const std::string& json);
 };
 
 //item pool for run
+//the items live only in the store's arena, grouped by rarity, so dropping the pool frees
+//them in one step
 struct ItemPool {
     std::string pool_id;
-    int difficulty_level;
-    int floor_number;
-    
-    std::vector<ItemDefinition> common_items;
-    std::vector<ItemDefinition> uncommon_items;
-    std::vector<ItemDefinition> rare_items;
-    std::vector<ItemDefinition> epic_items;
-    std::vector<ItemDefinition> legendary_items;
-    std::vector<ItemDefinition> cursed_items;
+    int difficulty_level = 1;
+    int floor_number = 1;
     
     //metadata
     std::string theme;
     std::map<std::string, std::string> run_params;
+    
+    //every item, what sampling, listing and the pool store read
+    ItemStore store;
+    
+    //arena plus the pool's own strings
+    size_t memory_bytes() const { return sizeof(ItemPool) + pool_id.capacity() + theme.capacity() + store.memory_bytes(); }
+};
+
+//incremental parser for an item array that arrives as streamed text
+//feed() takes each delta and returns every item object whose closing brace has now
+//arrived, parsed and clamped, so items can be used while the rest is still generating.
+//items are the objects directly inside the first array, like parse_item_array
+class ItemStreamParser {
+private:
+    std::string content;
+    size_t scan_pos = 0;
+    int depth = 0;
+    int array_depth = -1; //depth inside the items array, -1 until it opens
+    bool in_string = false;
+    bool escaped = false;
+    bool finished = false;
+    size_t object_start = std::string::npos;
+    int item_count = 0;
+    int skipped_count = 0;
+    std::string key;
+    std::string text;
+
+public:
+    //appends new complete items to out, returns how many
+    size_t feed(std::string_view delta, std::vector<ItemDefinition>& out);
+    int get_item_count() const { return item_count; }
+    int get_skipped_count() const { return skipped_count; }
 };
 
+//godot-side views of published pools, main thread only
+//built once per pool version and handed out as read-only Arrays, so repeat queries and
+//signals share one array instead of building a Dictionary per item every time
+class PoolSnapshotCache {
+private:
+    struct Snapshot {
+        uint64_t version = 0;
+        godot::Array items;            //empty until the whole pool is asked for
+        godot::PackedByteArray packed; //empty until exported
+        bool has_items = false;
+        bool has_packed = false;
+    };
+
+    std::map<std::string, Snapshot> snapshots;
+
+    Snapshot& snapshot_of(const ItemPool& pool);
+
+public:
+    godot::Array get_items(const ItemPool& pool);
+    //a page of up to count items from offset, without building the rest of the pool
+    godot::Array get_range(const ItemPool& pool, int64_t offset, int64_t count);
+    //the pool in the pool store's binary layout (see item_pool_store.cpp), rows in the
+    //same order as get_items
+    godot::PackedByteArray get_packed(const ItemPool& pool);
+
+    void erase(const std::string& pool_id) { snapshots.erase(pool_id); }
+    void clear() { snapshots.clear(); }
+};
+
+//one request's share of a pool
+struct PoolShard {
+    std::vector<ItemRarity> rarities; //empty for any rarity
+    int item_count = 10;
+};
+
+//delivers a pool that grows as its items land: first with update false once enough items
+//are in (or every shard has answered), then with update true each time more items arrive.
+//nullptr and the error only when no shard produced an item
+using PoolCallback = std::function<void(std::shared_ptr<const ItemPool>, const std::string&, bool update)>;
+
 //item generation service
-//pregenerates item pools at run start
+//pregenerates item pools at run start, and the next floors' pools while a floor is played
 class ItemGenerationService {
 private:
+    struct PoolAssembly;
+    
+    //last_used is a tick of pool_clock, bumped by every read so eviction drops the pool
+    //read least recently
+    struct CachedPool {
+        std::shared_ptr<const ItemPool> pool;
+        mutable uint64_t last_used = 0;
+    };
+    
     std::shared_ptr<OpenAIClient> client;
-    std::map<std::string, ItemPool> cached_pools;
+    //pools are immutable once published, so a shared_ptr handed out stays valid after a swap
+    //or an eviction; the arena is freed when its last holder lets go
+    std::map<std::string, CachedPool> cached_pools;
+    uint64_t next_pool_id;
+    mutable uint64_t pool_clock;
+    size_t pool_memory_limit; //bytes, 0 for no cap
+    uint64_t pool_evictions;
     ItemPool fallback_pool;
+    PoolSnapshotCache snapshots;
+    
+    //generated pools by run config, reloaded across restarts instead of regenerated
+    ItemPoolStore pool_store;
+    bool pool_store_enabled;
+    
+    //floor prefetch, main thread only
+    godot::Dictionary run_config;
+    int current_floor;
+    int prefetch_depth;
+    uint64_t run_generation; //bumped by start_run, stale prefetches are dropped on arrival
+    std::shared_ptr<const ItemPool> current_pool; //front buffer, read by get_random_item
+    int current_pool_floor;                       //floor current_pool was generated for, 0 for none
+    std::map<int, std::shared_ptr<const ItemPool>> prefetched_pools; //back buffers by floor
+    std::set<int> pending_floors;
+    
+    mutable std::mt19937_64 rng;
     
-    //prompt construction
-    std::string build_item_generation_prompt(const godot::Dictionary& run_config);
+    //sharded generation
+    int shard_count;
+    int min_ready_items;
     
-    //json parsing
-    std::vector<ItemDefinition> parse_item_array(const std::string& json);
+    //rarity top-ups, one small request for the buckets a finished pool is short of
+    bool top_up_enabled;
+    uint64_t top_up_requests;
+    uint64_t top_up_items;
     
-    //validation
-    void validate_and_clamp_item(ItemDefinition& item);
+    //procedural stand-ins, published at once and replaced as the model's items arrive
+    bool procedural_fill_enabled;
+    uint64_t procedural_items;
+    
+    //prompt construction, the default shard is the whole pool in one request
+    std::string build_item_generation_prompt(const godot::Dictionary& run_config, const PoolShard& shard = PoolShard());
+    std::vector<PoolShard> plan_shards() const;
+    
+    //request one pool as shard_count concurrent streamed requests and merge items in as
+    //their closing braces arrive, on_item sees each item once
+    void request_pool(const godot::Dictionary& run_config,
+                      const std::string& pool_id,
+                      PoolCallback on_pool,
+                      std::function<void(const ItemDefinition&)> on_item = nullptr);
+    void request_shard(const std::shared_ptr<PoolAssembly>& assembly, const PoolShard& shard);
+    void request_top_up(const std::shared_ptr<PoolAssembly>& assembly, const PoolShard& shard);
+    //the rarities below their target and how many items they are short, empty when stocked
+    static PoolShard plan_top_up(const ItemPool& pool);
+    static PoolShard plan_top_up(const std::vector<ItemDefinition>& items);
+    void on_shard_done(const std::shared_ptr<PoolAssembly>& assembly,
+                       const ItemStreamParser& parser,
+                       const HTTPResponse& response);
+    void add_pool_items(const std::shared_ptr<PoolAssembly>& assembly, std::vector<ItemDefinition>& items);
+    void publish_pool(const std::shared_ptr<PoolAssembly>& assembly);
+    bool has_stored_pool(const godot::Dictionary& run_config);
+    static std::shared_ptr<ItemPool> build_pool(const std::string& pool_id,
+                                                const godot::Dictionary& run_config,
+                                                const std::vector<ItemDefinition>& items);
+    //a full pool of procedural items for the run config's difficulty, floor and theme
+    void generate_procedural_items(const godot::Dictionary& run_config, std::vector<ItemDefinition>& out);
+    std::shared_ptr<ItemPool> build_procedural_pool(const std::string& pool_id, const godot::Dictionary& run_config);
+    
+    //caches the pool under its id, then evicts least recently used pools until the cache
+    //fits the cap again. the pool just cached is never evicted
+    void cache_pool(const std::string& pool_id, std::shared_ptr<const ItemPool> pool);
+    void evict_pools(const std::string& keep_id);
+    
+    void prefetch_ahead();
+    void on_floor_pool_ready(int floor, std::shared_ptr<const ItemPool> pool);
+    const ItemPool& find_pool(const std::string& pool_id) const;
+    godot::Dictionary random_item_from(const ItemPool& pool, int rarity, int type) const;
     
     //fallback items
     void initialize_fallback_pool();
@@ -99,24 +245,96 @@ public:
     ItemGenerationService(std::shared_ptr<OpenAIClient> openai_client);
     ~ItemGenerationService();
 
+    //one pass over the model's content (a json array or {"items": [...]}, code fences
+    //and surrounding prose ignored) straight into clamped items. malformed elements are
+    //skipped and counted in skipped_count, a truncated array keeps the items before the cut
+    static std::vector<ItemDefinition> parse_item_array(std::string_view content, int* skipped_count = nullptr);
+    static void validate_and_clamp_item(ItemDefinition& item);
+
     //pregeneration at run start
+    //on_success fires once min_ready_items are in, on_update again as more items land,
+    //on_item for every item the moment it has been streamed
     void generate_item_pool(const godot::Dictionary& run_config,
                            std::function<void(const std::string&)> on_success,
-                           std::function<void(const std::string&)> on_error);
+                           std::function<void(const std::string&)> on_error,
+                           std::function<void(const std::string&)> on_update = nullptr,
+                           std::function<void(const ItemDefinition&)> on_item = nullptr);
 
     //sync version
     std::string generate_item_pool_sync(const godot::Dictionary& run_config);
 
+    //persistent pools, keyed by the run config's prompt
+    //a stored pool is served instead of a request, enabled once a directory is open
+    bool open_pool_store(const std::string& directory);
+    void set_pool_store_enabled(bool enabled) { pool_store_enabled = enabled; }
+    bool is_pool_store_enabled() const { return pool_store_enabled; }
+    void clear_pool_store() { pool_store.clear(); }
+    ItemPoolStoreStats get_pool_store_stats() const { return pool_store.get_stats(); }
+
+    //a pool is split by rarity into up to 6 concurrent requests, so a slow or malformed
+    //response only costs its own shard; 1 sends the whole pool as one request
+    void set_shard_count(int shards);
+    int get_shard_count() const { return shard_count; }
+    void set_min_ready_items(int items);
+    int get_min_ready_items() const { return min_ready_items; }
+
+    //once a pool has every shard in, rarities left below their target (the model often
+    //returns no legendary or cursed) get one request sized to the shortfall, merged into
+    //the pool as it streams. stored pools that are short are topped up on load
+    void set_top_up_enabled(bool enabled);
+    bool is_top_up_enabled() const { return top_up_enabled; }
+    
+    //a new pool is published at once with procedural items, and each rarity's stand-ins
+    //are dropped as the model's items of that rarity arrive; rarities the model never
+    //supplies stay filled procedurally. with the circuit open or a failed sync request the
+    //pool is entirely procedural. stored pools hold only the model's items
+    void set_procedural_fill_enabled(bool enabled) { procedural_fill_enabled = enabled; }
+    bool is_procedural_fill_enabled() const { return procedural_fill_enabled; }
+
+    //floor prefetch
+    //start_run generates the starting floor ("floor" in run_config, default 1) and the
+    //prefetch_depth floors after it at background priority. advance_to_floor swaps the
+    //prefetched pool in and requests the next ones; until a floor's own pool has arrived
+    //the previous pool (or the fallback pool) keeps serving, so picks never wait
+    void start_run(const godot::Dictionary& run_config);
+    void advance_to_floor(int floor);
+    void set_prefetch_depth(int floors);
+    int get_prefetch_depth() const { return prefetch_depth; }
+    int get_current_floor() const { return current_floor; }
+    bool is_floor_pool_ready() const { return current_pool_floor == current_floor; }
+    godot::Dictionary get_prefetch_status() const;
+
+    //item retrieval from the current floor's pool
+    //any rarity follows the pool floor's rarity odds, type is an ItemType or ItemStore::ANY
+    godot::Dictionary get_random_item(ItemRarity rarity, int type = ItemStore::ANY) const;
+    godot::Dictionary get_random_item_any_rarity(int type = ItemStore::ANY) const;
+
     //item retrieval from cached pool
     godot::Dictionary get_random_item(const std::string& pool_id, ItemRarity rarity);
     godot::Dictionary get_random_item_any_rarity(const std::string& pool_id);
+    
+    //reseeds item picks, a fixed seed replays the same picks from the same pools
+    void set_random_seed(uint64_t seed) { rng.seed(seed); }
+
+    //pool queries, an empty pool_id means the current floor's pool
+    //arrays are cached per pool version and read-only, duplicate() one to edit it
     godot::Array get_all_items_in_pool(const std::string& pool_id);
+    godot::Array get_items_range(const std::string& pool_id, int64_t offset, int64_t count);
+    godot::PackedByteArray export_pool(const std::string& pool_id);
+    uint64_t get_pool_version(const std::string& pool_id) const { return find_pool(pool_id).store.get_version(); }
     
     //pool management
     bool has_pool(const std::string& pool_id) const;
     void clear_pool(const std::string& pool_id);
     void clear_all_pools();
     
+    //memory cap for cached pools, least recently used pools are dropped past it
+    void set_pool_memory_limit(size_t bytes);
+    size_t get_pool_memory_limit() const { return pool_memory_limit; }
+    size_t get_pool_memory_used() const;
+    //limit, used, evictions and per pool {pool_id, bytes, items}, most recently used first
+    godot::Dictionary get_pool_memory_stats() const;
+    
     //metadata
     godot::Dictionary get_pool_metadata(const std::string& pool_id);
 };
@@ -0,0 +1,78 @@
+#ifndef ITEM_POOL_STORE_H
+#define ITEM_POOL_STORE_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+
+namespace necronomicore {
+
+struct ItemPool;
+
+//pool store counters
+struct ItemPoolStoreStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t rejected = 0; //files that failed validation (old version, truncated, foreign)
+    uint64_t stores = 0;
+    size_t mapped_files = 0;
+    size_t mapped_bytes = 0;
+};
+
+//persistent item pools, one file per run config under a directory
+//a file is a fixed header, fixed-size item records, an effect table and one string
+//table, so loading is a read-only mapping, bounds checks and string copies with no
+//text parsing. files are written to a temp name and renamed into place, and mapped
+//read-only, so several game processes can share one catalog directory.
+//not thread-safe, the item service uses it from the main thread.
+class ItemPoolStore {
+private:
+    struct Mapping {
+        const char* data = nullptr;
+        size_t size = 0;
+    };
+
+    std::string directory;
+    //mappings stay open for the store's lifetime, repeat loads skip the open and map
+    std::unordered_map<uint64_t, Mapping> mappings;
+    ItemPoolStoreStats stats;
+
+    std::string path_for(uint64_t key) const;
+    const Mapping* map_pool(uint64_t key);
+    void unmap(uint64_t key);
+    void unmap_all();
+
+public:
+    ItemPoolStore();
+    ~ItemPoolStore();
+
+    ItemPoolStore(const ItemPoolStore&) = delete;
+    ItemPoolStore& operator=(const ItemPoolStore&) = delete;
+
+    //fnv-1a 64 of the canonical run config (the rendered generation prompt)
+    static uint64_t config_key(std::string_view canonical);
+
+    //creates the directory if needed, false if it can't
+    bool open(const std::string& path);
+    void close();
+    bool is_open() const { return !directory.empty(); }
+
+    //nullptr on a miss or a file that fails validation
+    std::shared_ptr<ItemPool> load(uint64_t key);
+    bool contains(uint64_t key) const;
+    bool save(uint64_t key, const ItemPool& pool);
+    //unmaps and deletes every stored pool
+    void clear();
+
+    ItemPoolStoreStats get_stats() const;
+
+    //the file format on its own, for the benchmarks
+    static void serialize(uint64_t key, const ItemPool& pool, std::string& out);
+    static std::shared_ptr<ItemPool> deserialize(uint64_t key, const char* data, size_t size);
+};
+
+} // namespace necronomicore
+
+#endif // ITEM_POOL_STORE_H
@@ -0,0 +1,167 @@
+#ifndef ITEM_STORE_H
+#define ITEM_STORE_H
+
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <vector>
+#include <string>
+#include <random>
+#include <memory>
+#include <cstdint>
+
+namespace necronomicore {
+
+struct ItemDefinition;
+enum class ItemRarity;
+enum class ItemType;
+
+//one heap block carved into a store's columns and tables
+//build() sizes it exactly before filling it, so a whole pool is a single allocation
+//that is freed in one step with the store
+class PoolArena {
+private:
+    std::unique_ptr<uint64_t[]> block;
+    size_t capacity = 0;
+    size_t used = 0;
+
+public:
+    //every column starts on an 8-byte boundary
+    template <typename T>
+    static size_t bytes_for(size_t count) {
+        return (count * sizeof(T) + 7) & ~static_cast<size_t>(7);
+    }
+
+    //drops the old block and allocates a new one of at least bytes
+    void reset(size_t bytes);
+
+    template <typename T>
+    T* allocate(size_t count) {
+        size_t bytes = bytes_for<T>(count);
+        if (bytes == 0 || used + bytes > capacity) {
+            return nullptr;
+        }
+        T* data = reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(block.get()) + used);
+        used += bytes;
+        return data;
+    }
+
+    size_t get_capacity() const { return capacity; }
+};
+
+//fixed-length array inside a PoolArena
+template <typename T>
+struct Column {
+    T* data = nullptr;
+    uint32_t count = 0;
+
+    T& operator[](size_t i) { return data[i]; }
+    const T& operator[](size_t i) const { return data[i]; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T* begin() { return data; }
+    T* end() { return data + count; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + count; }
+};
+
+//struct-of-arrays copy of a pool's items, the form every read goes through
+//each stat is its own array and strings are interned once per pool, so a pick touches
+//a couple of cache lines instead of a whole ItemDefinition. alias tables built for the
+//pool's floor make weighted sampling O(1) whatever the rarity and type filters.
+//everything lives in one arena block. immutable after build(), safe to read from
+//several threads with separate rngs.
+class ItemStore {
+public:
+    static constexpr int RARITY_COUNT = 6;
+    static constexpr int TYPE_COUNT = 5;
+    static constexpr int ANY = -1;
+
+private:
+    //Vose alias table over a subset of rows: pick a slot uniformly, keep it if the low
+    //32 bits of the draw fall under its threshold, otherwise take its alias
+    struct AliasTable {
+        Column<uint32_t> rows;
+        Column<uint32_t> threshold;
+        Column<uint32_t> alias;
+    };
+
+    PoolArena arena;
+    int floor_number = 1;
+    uint64_t version = 0;
+
+    //stat columns, rows in rarity order
+    Column<int32_t> damage;
+    Column<int32_t> defense;
+    Column<int32_t> healing;
+    Column<float> cooldown;
+    Column<uint8_t> rarity;
+    Column<uint8_t> type;
+
+    //string columns, ids into the string table (0 is "")
+    Column<uint32_t> name;
+    Column<uint32_t> description;
+    Column<uint32_t> flavor_text;
+    Column<uint32_t> sprite_hint;
+    Column<uint32_t> first_effect;
+    Column<uint32_t> effect_count;
+    Column<uint32_t> effects;
+
+    //modifiers as flat (key, value) pairs per row
+    Column<uint32_t> first_modifier;
+    Column<uint32_t> modifier_count;
+    Column<uint32_t> modifier_keys;
+    Column<float> modifier_values;
+
+    //string table: offset and length of each id in text, every string null-terminated
+    Column<uint32_t> string_offset;
+    Column<uint32_t> string_length;
+    Column<char> text;
+
+    //floor-weighted tables, [type] with TYPE_COUNT meaning any type
+    AliasTable weighted[TYPE_COUNT + 1];
+    //rows of one rarity, [rarity][type], for uniform picks within a rarity
+    Column<uint32_t> by_rarity[RARITY_COUNT][TYPE_COUNT + 1];
+
+    const char* string_at(uint32_t id) const { return text.data + string_offset[id]; }
+    std::string string_of(uint32_t id) const { return std::string(string_at(id), string_length[id]); }
+    godot::String utf8_string(uint32_t id) const { return godot::String::utf8(string_at(id), string_length[id]); }
+    void build_tables();
+
+public:
+    //replaces the contents with the items (grouped by rarity, stats clamped) and builds
+    //the tables for the floor
+    void build(const std::vector<ItemDefinition>& items, int floor);
+
+    size_t size() const { return damage.size(); }
+    bool empty() const { return damage.empty(); }
+    int get_floor() const { return floor_number; }
+    //unique per build(), a pool with a new version has new contents
+    uint64_t get_version() const { return version; }
+    int get_rarity(size_t row) const { return rarity[row]; }
+    int get_type(size_t row) const { return type[row]; }
+    //items of one rarity
+    size_t count(int rarity_filter) const { return by_rarity[rarity_filter][TYPE_COUNT].size(); }
+    //bytes held by the arena
+    size_t memory_bytes() const { return arena.get_capacity(); }
+
+    //row of a sampled item, -1 when no item has the type
+    //rarity ANY draws the rarity by the floor's odds and then an item uniformly within it;
+    //a rarity with no items falls back to the nearest one below it, then above it
+    int64_t sample(std::mt19937_64& rng, int rarity_filter = ANY, int type_filter = ANY) const;
+
+    ItemDefinition get_item(size_t row) const;
+    godot::Dictionary to_dictionary(size_t row) const;
+    //dictionaries for rows [begin, end), read-only like the array itself
+    godot::Array to_array(size_t begin, size_t end) const;
+
+    //clamps every stat column to its row's rarity limits in branch-free passes
+    void clamp_stats();
+
+    //rarity odds on a floor, deeper floors shift weight from common toward epic and legendary
+    static double rarity_weight(ItemRarity item_rarity, int floor);
+    static int max_stat(ItemRarity item_rarity);
+};
+
+} // namespace necronomicore
+
+#endif // ITEM_STORE_H
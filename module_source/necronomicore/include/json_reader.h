@@ -0,0 +1,52 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace necronomicore {
+
+//on-demand json reader over a borrowed buffer
+//nothing is parsed up front: a lookup walks the path and skips every value it
+//doesn't need, so pulling choices[0].message.content out of a response costs one
+//scan and one copy of the content. no godot types, safe on any thread.
+//the buffer must outlive the reader and any views it hands out.
+//
+//paths are '/'-separated, numeric segments index arrays:
+//  JSONReader reader(response.body);
+//  std::string content;
+//  reader.get_string("choices/0/message/content", content);
+class JSONReader {
+private:
+    std::string_view json;
+
+public:
+    explicit JSONReader(std::string_view buffer);
+
+    //raw json text of the value at path (strings keep their quotes)
+    //false if the path is missing or the document is malformed on the way there
+    bool find(std::string_view path, std::string_view& raw) const;
+
+    bool has(std::string_view path) const;
+    //getters leave out untouched on a miss (get_string clears it)
+    bool get_string(std::string_view path, std::string& out) const;
+    bool get_int(std::string_view path, int64_t& out) const;
+    bool get_double(std::string_view path, double& out) const;
+    bool get_bool(std::string_view path, bool& out) const;
+
+    //decodes a quoted json string (as returned by find) into utf-8
+    //\u escapes are converted, surrogate pairs joined, lone surrogates become U+FFFD
+    static bool decode_string(std::string_view raw, std::string& out);
+
+    //cursor helpers for callers that walk a document in one pass themselves
+    //each skips leading whitespace at pos and leaves pos just past what it read
+    static void skip_whitespace(std::string_view json, size_t& pos);
+    static bool skip_value(std::string_view json, size_t& pos); //false on malformed input
+    static bool read_string(std::string_view json, size_t& pos, std::string& out);
+    static bool read_number(std::string_view json, size_t& pos, double& out);
+};
+
+} // namespace necronomicore
+
+#endif // JSON_READER_H
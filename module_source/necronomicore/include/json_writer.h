@@ -0,0 +1,51 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace necronomicore {
+
+//streaming json writer that appends to a caller-owned buffer
+//no godot types involved, so it is safe on any thread. commas are
+//inserted automatically, callers only need to balance begin/end calls.
+//
+//  std::string body;
+//  JSONWriter writer(body);
+//  writer.begin_object();
+//  writer.key("model"); writer.value(model);
+//  writer.end_object();
+class JSONWriter {
+private:
+    std::string& out;
+    bool need_comma;
+
+    void separate();
+
+public:
+    explicit JSONWriter(std::string& buffer);
+
+    void begin_object();
+    void end_object();
+    void begin_array();
+    void end_array();
+
+    void key(std::string_view name);
+
+    void value(std::string_view text);
+    void value(const char* text);
+    void value(int64_t number);
+    void value(int number);
+    void value(double number);
+    void value(float number);
+    void value(bool flag);
+    void null_value();
+
+    //appends text as a quoted, escaped json string
+    static void write_string(std::string& out, std::string_view text);
+};
+
+} // namespace necronomicore
+
+#endif // JSON_WRITER_H
@@ -4,6 +4,7 @@
 #include <godot_cpp/classes/node.hpp>
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
 #include <string>
 #include <memory>
 
@@ -27,6 +28,25 @@ private:
     std::shared_ptr<RandomRollService> roll_service;
     
     godot::String api_key;
+    godot::String base_url;
+    int network_worker_count;
+    int max_in_flight_requests;
+    bool dialog_streaming;
+    int dialog_history_length; //turns each npc keeps verbatim
+    bool response_cache_enabled;
+    int response_cache_ttl;
+    double requests_per_minute;
+    double tokens_per_minute;
+    int max_request_retries;
+    int item_prefetch_depth;
+    bool item_pool_store_enabled;
+    int64_t item_random_seed; //-1 for a random seed
+    int item_generation_shards;
+    int item_pool_min_ready;
+    bool item_pool_top_up;
+    bool item_pool_procedural_fill;
+    int64_t item_pool_memory_limit; //bytes of cached pools, 0 for no cap
+    std::string item_query_pool; //pool the item queries read, empty for the current floor's
     bool initialized;
 
 protected:
@@ -42,17 +62,82 @@ public:
     //init
     void set_api_key(const godot::String& key);
     godot::String get_api_key() const;
+    void set_base_url(const godot::String& url);
+    godot::String get_base_url() const;
+    void set_network_worker_count(int count);
+    int get_network_worker_count() const;
+    void set_max_in_flight_requests(int count);
+    int get_max_in_flight_requests() const;
+    void set_dialog_streaming(bool enabled);
+    bool is_dialog_streaming() const;
+    void set_dialog_history_length(int turns);
+    int get_dialog_history_length() const;
+    void set_response_cache_enabled(bool enabled);
+    bool is_response_cache_enabled() const;
+    void set_response_cache_ttl(int seconds);
+    int get_response_cache_ttl() const;
+    void set_rate_limits(double requests_per_minute, double tokens_per_minute);
+    void set_max_request_retries(int retries);
+    int get_max_request_retries() const;
+    void set_item_prefetch_depth(int floors);
+    int get_item_prefetch_depth() const;
+    void set_item_pool_store_enabled(bool enabled);
+    bool is_item_pool_store_enabled() const;
+    void set_item_random_seed(int64_t seed);
+    int64_t get_item_random_seed() const;
+    void set_item_generation_shards(int shards);
+    int get_item_generation_shards() const;
+    void set_item_pool_min_ready(int items);
+    int get_item_pool_min_ready() const;
+    void set_item_pool_top_up_enabled(bool enabled);
+    bool is_item_pool_top_up_enabled() const;
+    void set_item_pool_procedural_fill_enabled(bool enabled);
+    bool is_item_pool_procedural_fill_enabled() const;
+    void set_item_pool_memory_limit(int64_t bytes);
+    int64_t get_item_pool_memory_limit() const;
     bool is_initialized() const;
     void initialize();
 
     //service methods
     void request_item_generation(const godot::Dictionary& config);
+    void start_item_run(const godot::Dictionary& config);
+    void advance_to_floor(int floor);
+    godot::Dictionary get_random_item(int rarity, int type);
+    godot::Array get_item_pool_items(int64_t offset, int64_t count);
+    godot::PackedByteArray export_item_pool();
+    int64_t get_item_pool_version() const;
     void request_emotion_dialog(const godot::String& npc_name, const godot::String& context, const godot::Dictionary& personality);
+    //generates the line request_emotion_dialog would get, ahead of time at background priority
+    void prefetch_emotion_dialog(const godot::String& npc_name, const godot::String& context, const godot::Dictionary& personality);
+    //fills the npc's line banks for its mood in each location, at run start
+    void prepare_dialog_lines(const godot::String& npc_name, const godot::Dictionary& personality, const godot::Array& locations);
+    //a pregenerated "greeting", "farewell", "bark" or "idle" line, empty while the bank has none
+    godot::String get_dialog_line(const godot::String& npc_name, const godot::String& kind, const godot::String& location);
+    //wall text for a room, returns at once from a pool refilled in the background
+    godot::String get_environmental_message(const godot::String& location, int danger_level);
+    void prepare_environmental_messages(const godot::String& location, int danger_level);
     int generate_random_roll(int min_value, int max_value, const godot::String& context);
 
+    //diagnostics
+    godot::Dictionary get_network_stats() const;
+    godot::Dictionary get_queue_stats() const;
+    godot::Dictionary get_cache_stats() const;
+    godot::Dictionary get_item_prefetch_status() const;
+    godot::Dictionary get_item_pool_memory_stats() const;
+    godot::Dictionary get_dialog_memory_stats() const;
+    godot::Dictionary get_dialog_prefetch_stats() const;
+    godot::Dictionary get_dialog_line_stats() const;
+    godot::Dictionary get_environmental_message_stats() const;
+    void clear_response_cache();
+    void clear_item_pool_store();
+    godot::Dictionary run_benchmark(const godot::String& name, const godot::Dictionary& options);
+
     //signals
     void emit_item_pool_ready(const godot::Array& items);
+    void emit_item_pool_updated(const godot::Array& items);
+    void emit_item_generated(const godot::Dictionary& item);
     void emit_dialog_ready(const godot::String& dialog_text);
+    void emit_dialog_chunk(const godot::String& chunk_text);
     void emit_request_failed(const godot::String& error_message);
 
     //godot lifecycle
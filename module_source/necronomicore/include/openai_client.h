@@ -4,12 +4,29 @@
 #include <string>
 #include <functional>
 #include <map>
-#include <queue>
+#include <chrono>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <string_view>
+#include "rate_limiter.h"
+#include "circuit_breaker.h"
 #include <godot_cpp/variant/string.hpp>
 #include <godot_cpp/variant/dictionary.hpp>
 
 namespace necronomicore {
 
+class HTTPClient;
+class ResponseCache;
+struct HTTPClientStats;
+struct ResponseCacheStats;
+
 //http response
 struct HTTPResponse {
     int status_code;
@@ -17,6 +34,46 @@ struct HTTPResponse {
     std::map<std::string, std::string> headers;
     bool success;
     std::string error_message;
+    std::string content; //choices[0].message.content, extracted on the worker thread
+                         //(assembled from the deltas for streamed requests)
+    int prompt_tokens = 0;     //usage reported by the api, 0 when absent
+    int completion_tokens = 0;
+    int cached_prompt_tokens = 0; //prompt tokens served from the provider's prefix cache
+};
+
+//scheduling class, a lower class is always dispatched first
+enum class RequestPriority {
+    INTERACTIVE = 0, //the player is waiting on it (npc dialog)
+    GAMEPLAY = 1,    //rolls, flavor text
+    BACKGROUND = 2,  //pregeneration (item pools)
+};
+const int REQUEST_PRIORITY_COUNT = 3;
+
+using RequestClock = std::chrono::steady_clock;
+
+//one chat message, content is utf-8
+struct ChatMessage {
+    std::string role;
+    std::string content;
+};
+
+const char* const CHAT_COMPLETIONS_ENDPOINT = "/chat/completions";
+
+//per-request options
+struct RequestOptions {
+    RequestPriority priority = RequestPriority::GAMEPLAY;
+    //seconds from now after which the request is dropped unsent, <= 0 means no deadline
+    double deadline_seconds = 0.0;
+    //stream the completion as server-sent events
+    bool stream = false;
+    //called on the main thread with each content delta of a streamed request
+    std::function<void(const std::string&)> on_chunk;
+    //skip the response cache for both lookup and store
+    bool bypass_cache = false;
+    //how long a stored response stays valid, <= 0 uses the cache default
+    int cache_ttl_seconds = 0;
+    //share the response of an identical request that is already queued or in flight
+    bool coalesce = true;
 };
 
 //openai api request
@@ -26,6 +83,58 @@ struct OpenAIRequest {
     std::map<std::string, std::string> headers;
     std::string body;
     std::function<void(const HTTPResponse&)> callback;
+    std::string url; //resolved on the main thread at dispatch
+    bool extract_content = false;
+    bool stream = false;
+    std::function<void(const std::string&)> on_chunk;
+    uint64_t content_key = 0; //hash of method, endpoint and body (cache and coalescing key)
+    bool cacheable = false; //store a successful response under content_key
+    int cache_ttl_seconds = 0;
+    int estimated_tokens = 0; //charged against the token budget at dispatch
+    RequestPriority priority = RequestPriority::GAMEPLAY;
+    RequestClock::time_point enqueued_at;
+    RequestClock::time_point deadline = RequestClock::time_point::max();
+    uint64_t sequence = 0; //fifo order among equal deadlines
+    int attempts = 0; //retries already made
+    RequestClock::time_point not_before; //backoff of a scheduled retry
+    bool probe = false; //circuit breaker health check, never retried or failed fast
+};
+
+//finished request waiting for its callback on the main thread
+struct CompletedRequest {
+    std::function<void(const HTTPResponse&)> callback;
+    HTTPResponse response;
+    RequestPriority priority = RequestPriority::GAMEPLAY;
+    bool expired = false; //deadline passed before a worker sent it
+    bool from_worker = false; //went over the network (not a cache hit or fast failure)
+    bool retryable = false; //transient failure, request kept for another attempt
+    OpenAIRequest request; //endpoint always set, the rest only when retryable
+};
+
+//callers sharing one queued or in-flight request
+struct CoalescedGroup {
+    struct ChunkSubscriber {
+        std::function<void(const std::string&)> on_chunk;
+        size_t delivered; //bytes of streamed already passed to this subscriber
+    };
+    std::vector<std::function<void(const HTTPResponse&)>> callbacks;
+    std::vector<ChunkSubscriber> chunk_subscribers;
+    std::string streamed; //content streamed so far, replayed to late subscribers
+};
+
+//per-class queue counters
+struct QueueClassStats {
+    int queued = 0;
+    uint64_t dispatched = 0;
+    uint64_t expired = 0;
+    double total_wait_seconds = 0.0; //enqueue to dispatch
+    double max_wait_seconds = 0.0;
+};
+
+//streamed delta waiting for its chunk callback on the main thread
+struct StreamChunk {
+    std::function<void(const std::string&)> on_chunk;
+    std::string text;
 };
 
 //openai http client
@@ -34,20 +143,92 @@ class OpenAIClient {
 private:
     std::string api_key;
     std::string base_url;
-    std::queue<OpenAIRequest> request_queue;
-    bool processing;
-    
+    std::unique_ptr<HTTPClient> http_client; //shared so keep-alive connections are reused
+
+    //one earliest-deadline-first heap per priority class, main thread only
+    std::vector<OpenAIRequest> request_queues[REQUEST_PRIORITY_COUNT];
+    QueueClassStats queue_stats[REQUEST_PRIORITY_COUNT];
+    uint64_t next_sequence;
+
+    //io worker pool
+    //workers only run http + parsing, callbacks always fire from process_queue
+    std::vector<std::thread> workers;
+    std::mutex worker_mutex;
+    std::condition_variable worker_cv;
+    std::deque<OpenAIRequest> dispatched_requests;
+    std::deque<CompletedRequest> completed_requests;
+    std::deque<StreamChunk> stream_chunks;
+    bool workers_stopping;
+    int workers_retiring; //surplus workers still to exit after their current request
+    std::vector<std::thread::id> retired_workers; //exited, waiting to be joined
+    int worker_count;
+    int max_in_flight;
+    int in_flight; //main thread only
+
+    //response cache, hits complete on the main thread without a worker
+    std::unique_ptr<ResponseCache> response_cache;
+    bool cache_enabled;
+    std::deque<StreamChunk> cached_chunks; //main thread only
+    std::deque<CompletedRequest> cached_completions; //main thread only
+
     //rate limiting
-    int max_requests_per_minute;
-    int current_request_count;
-    double last_reset_time;
+    RateLimiter rate_limiter; //main thread only
+
+    //identical requests waiting on the same call, main thread only
+    std::unordered_map<uint64_t, CoalescedGroup> coalesced_groups;
+    uint64_t coalesced_requests;
+
+    //retries and circuit breaking, main thread only
+    CircuitBreaker circuit_breaker;
+    std::vector<OpenAIRequest> delayed_retries;
+    int max_retries;
+    double retry_base_delay;
+    double retry_max_delay;
+    std::mt19937 retry_rng;
+    uint64_t retried_requests;
+
+    //usage reported by finished requests, main thread only
+    uint64_t prompt_tokens_used;
+    uint64_t completion_tokens_used;
+    uint64_t cached_prompt_tokens_used;
+
+    //worker management
+    void start_workers();
+    void stop_workers();
+    void reap_retired_workers();
+    void worker_loop();
+
+    //scheduling
+    void enqueue_request(OpenAIRequest& request, const RequestOptions& options);
+    void drop_expired_requests(RequestClock::time_point now);
+    static bool scheduled_after(const OpenAIRequest& a, const OpenAIRequest& b);
+    static HTTPResponse make_expired_response();
+    static HTTPResponse make_circuit_open_response();
+
+    //retries and circuit breaking
+    static bool is_transient_status(int status_code);
+    static bool is_upstream_up(int status_code);
+    static bool parse_retry_after(const std::map<std::string, std::string>& headers, double& seconds);
+    bool schedule_retry(CompletedRequest& done);
+    void release_due_retries(RequestClock::time_point now);
+    void record_upstream_result(const CompletedRequest& done);
+    void send_due_probes();
 
     //internal http methods
+    void prepare_request(OpenAIRequest& request) const;
     HTTPResponse send_http_request(const OpenAIRequest& request);
-    std::string build_chat_completion_body(const godot::Array& messages, 
-                                           const godot::String& model,
-                                           float temperature,
-                                           int max_tokens);
+    HTTPResponse send_streaming_request(const OpenAIRequest& request);
+    bool try_cached_response(OpenAIRequest& request, const RequestOptions& options, HTTPResponse& response);
+    bool join_coalesced_request(const OpenAIRequest& request, const RequestOptions& options);
+    void promote_queued_request(uint64_t key, RequestPriority priority, RequestClock::time_point deadline);
+    static RequestClock::time_point deadline_from(const RequestOptions& options, RequestClock::time_point now);
+    void begin_coalesced_request(OpenAIRequest& request);
+    void deliver_coalesced_chunk(uint64_t key, const std::string& text);
+    void finish_coalesced_request(uint64_t key, const HTTPResponse& response);
+    void store_cached_response(const OpenAIRequest& request, const HTTPResponse& response);
+    static void extract_completion(HTTPResponse& response);
+    static void extract_delta(const std::string& event_json, std::string& delta, HTTPResponse& response);
+    static void read_usage(std::string_view usage_json, HTTPResponse& response);
     std::string build_image_generation_body(const godot::String& prompt,
                                            const godot::String& model,
                                            const godot::String& size,
@@ -61,33 +242,85 @@ public:
     void set_api_key(const std::string& key);
     void set_base_url(const std::string& url);
     std::string get_api_key() const { return api_key; }
+    std::string get_base_url() const { return base_url; }
+
+    //connection pool stats
+    HTTPClientStats get_http_stats() const;
+
+    //response cache
+    void set_cache_enabled(bool enabled);
+    bool is_cache_enabled() const { return cache_enabled; }
+    bool open_cache_file(const std::string& path);
+    void set_cache_ttl(int seconds);
+    int get_cache_ttl() const;
+    void set_cache_capacity(size_t max_entries, size_t max_bytes);
+    void clear_cache();
+    ResponseCacheStats get_cache_stats() const;
+
+    //writes the chat completion body into out (cleared first, capacity kept)
+    static void build_chat_completion_body(std::string& out,
+                                           const std::vector<ChatMessage>& messages,
+                                           std::string_view model,
+                                           float temperature,
+                                           int max_tokens,
+                                           bool stream);
 
     //api methods
-    void chat_completion(const godot::Array& messages,
-                        const godot::String& model,
+    void chat_completion(const std::vector<ChatMessage>& messages,
+                        std::string_view model,
                         float temperature,
                         int max_tokens,
-                        std::function<void(const HTTPResponse&)> callback);
+                        std::function<void(const HTTPResponse&)> callback,
+                        const RequestOptions& options = RequestOptions());
 
     void image_generation(const godot::String& prompt,
                          const godot::String& model,
                          const godot::String& size,
                          int n,
-                         std::function<void(const HTTPResponse&)> callback);
+                         std::function<void(const HTTPResponse&)> callback,
+                         const RequestOptions& options = RequestOptions());
 
     //sync versions
-    HTTPResponse chat_completion_sync(const godot::Array& messages,
-                                     const godot::String& model,
+    HTTPResponse chat_completion_sync(const std::vector<ChatMessage>& messages,
+                                     std::string_view model,
                                      float temperature,
-                                     int max_tokens);
+                                     int max_tokens,
+                                     const RequestOptions& options = RequestOptions());
+
+    //worker pool config
+    void set_worker_count(int count);
+    int get_worker_count() const { return worker_count; }
+    void set_max_in_flight(int count);
+    int get_max_in_flight() const { return max_in_flight; }
 
     //queue management
+    //call from the main thread: dispatches queued requests and fires finished callbacks
     void process_queue();
     bool has_pending_requests() const;
+    int get_in_flight_count() const { return in_flight; }
+    int get_queued_count() const;
+    QueueClassStats get_queue_stats(RequestPriority priority) const;
     void clear_queue();
+    uint64_t get_coalesced_count() const { return coalesced_requests; }
+
+    //retry and circuit breaker config
+    void set_max_retries(int retries);
+    int get_max_retries() const { return max_retries; }
+    void set_retry_delay(double base_seconds, double max_seconds);
+    //open circuits fail fast, services check this to serve fallback content right away
+    bool is_circuit_open(const std::string& endpoint) const;
+    CircuitStats get_circuit_stats(const std::string& endpoint) const;
+    uint64_t get_retried_count() const { return retried_requests; }
+
+    //token usage reported by the api (cache hits cost nothing and add nothing)
+    uint64_t get_prompt_tokens_used() const { return prompt_tokens_used; }
+    uint64_t get_completion_tokens_used() const { return completion_tokens_used; }
+    //part of the prompt tokens the provider matched against a cached prompt prefix
+    uint64_t get_cached_prompt_tokens_used() const { return cached_prompt_tokens_used; }
 
     //rate limiting
-    bool can_make_request() const;
+    void set_rate_limits(double requests_per_minute, double tokens_per_minute);
+    RateLimiterStats get_rate_limit_stats() const;
     void update_rate_limit(double delta_time);
 };
 
@@ -0,0 +1,42 @@
+#ifndef PROCEDURAL_ITEM_GENERATOR_H
+#define PROCEDURAL_ITEM_GENERATOR_H
+
+#include <vector>
+#include <string_view>
+#include <random>
+
+namespace necronomicore {
+
+struct ItemDefinition;
+enum class ItemRarity;
+enum class ItemType;
+
+//local item generator, the tier under the model: no request, no parsing, well under a
+//microsecond per item
+//names, affixes, effects and flavor text are drawn from weighted grammars keyed by type
+//and rarity, stats scale with difficulty and floor and are clamped like a model's items.
+//no godot types and no shared state, safe on any thread with its own rng
+class ProceduralItemGenerator {
+public:
+    static constexpr int ANY_TYPE = -1;
+
+    //one item of the rarity, type ANY_TYPE picks one
+    static ItemDefinition generate(std::mt19937_64& rng,
+                                   ItemRarity rarity,
+                                   int type,
+                                   int difficulty,
+                                   int floor,
+                                   std::string_view theme = std::string_view());
+
+    //counts[r] items of each rarity, appended to out in rarity order
+    static void generate_pool(std::mt19937_64& rng,
+                              const int* counts,
+                              int difficulty,
+                              int floor,
+                              std::string_view theme,
+                              std::vector<ItemDefinition>& out);
+};
+
+} // namespace necronomicore
+
+#endif // PROCEDURAL_ITEM_GENERATOR_H
@@ -0,0 +1,72 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <string>
+#include <map>
+#include <cstdint>
+
+namespace necronomicore {
+
+//rate limiter counters
+struct RateLimiterStats {
+    double requests_available = 0.0;
+    double tokens_available = 0.0;
+    double requests_per_second = 0.0;
+    double tokens_per_second = 0.0;
+    double paused_seconds = 0.0; //remaining retry-after pause
+    uint64_t throttled_responses = 0; //429s seen
+};
+
+//token bucket with separate request and token budgets
+//refill rates start from the configured per-minute limits and then follow
+//the server's x-ratelimit-* headers, retry-after pauses dispatch entirely.
+//main thread only (driven from process_queue / update_rate_limit)
+class RateLimiter {
+private:
+    struct Bucket {
+        double level;
+        double capacity;
+        double rate; //per second
+
+        void refill(double seconds);
+        bool has(double amount) const;
+        void set_rate(double per_second, double burst_seconds);
+    };
+
+    Bucket requests;
+    Bucket tokens;
+    double burst_seconds;
+    double pause_remaining;
+    uint64_t throttled_responses;
+
+    static double parse_duration(const std::string& value);
+    static bool read_number(const std::map<std::string, std::string>& headers, const std::string& key, double& out);
+    static void adapt_bucket(Bucket& bucket, double burst_seconds,
+                             bool has_limit, double limit,
+                             bool has_remaining, double remaining,
+                             double reset_seconds);
+
+public:
+    RateLimiter();
+
+    //per-minute budgets, used until the server reports its own
+    void set_limits(double requests_per_minute, double tokens_per_minute);
+    //how much of the budget may be spent at once, in seconds of refill
+    void set_burst_seconds(double seconds);
+
+    void update(double delta_seconds);
+
+    //consumes one request and the estimated tokens when both budgets allow it
+    //(a request bigger than the token bucket goes once the bucket is full)
+    bool try_acquire(int estimated_tokens);
+
+    //feed every response back so the budgets track the server's view
+    void on_response(int status_code, const std::map<std::string, std::string>& headers);
+
+    bool is_paused() const { return pause_remaining > 0.0; }
+    RateLimiterStats get_stats() const;
+};
+
+} // namespace necronomicore
+
+#endif // RATE_LIMITER_H
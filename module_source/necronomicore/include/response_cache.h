@@ -0,0 +1,107 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+
+namespace necronomicore {
+
+//cached api response
+struct CachedResponse {
+    int status_code;
+    std::string body;
+    std::string content;
+};
+
+//cache counters
+struct ResponseCacheStats {
+    uint64_t memory_hits = 0;
+    uint64_t disk_hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t stores = 0;
+    size_t memory_entries = 0;
+    size_t memory_bytes = 0;
+    size_t disk_entries = 0;
+};
+
+//content-addressed response cache
+//bounded in-memory lru in front of an append-only disk file
+//that survives restarts, safe to use from the io workers
+class ResponseCache {
+private:
+    struct MemoryEntry {
+        uint64_t key;
+        CachedResponse response;
+        int64_t expires_at; //unix seconds
+        size_t bytes;
+    };
+
+    struct DiskEntry {
+        uint64_t offset;
+        uint32_t size;
+        int64_t expires_at;
+    };
+
+    mutable std::mutex mutex;
+
+    //memory tier
+    std::list<MemoryEntry> lru; //front = most recently used
+    std::unordered_map<uint64_t, std::list<MemoryEntry>::iterator> memory_index;
+    size_t max_memory_entries;
+    size_t max_memory_bytes;
+    size_t memory_bytes;
+
+    //disk tier
+    std::FILE* disk_file;
+    std::string disk_path;
+    std::unordered_map<uint64_t, DiskEntry> disk_index;
+    uint64_t disk_live_bytes;
+    uint64_t disk_file_bytes;
+
+    int default_ttl_seconds;
+    ResponseCacheStats stats;
+
+    void insert_memory(uint64_t key, const CachedResponse& response, int64_t expires_at);
+    void evict_to_capacity();
+    bool read_disk_entry(const DiskEntry& entry, uint64_t key, CachedResponse& out);
+    void append_disk_entry(uint64_t key, const CachedResponse& response, int64_t expires_at);
+    bool load_disk_index();
+    void compact_disk_file();
+
+public:
+    ResponseCache();
+    ~ResponseCache();
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    //hash of everything that determines the response
+    static uint64_t compute_key(const std::string& method,
+                                const std::string& endpoint,
+                                const std::string& body);
+
+    //memory first, then disk (disk hits are promoted to memory)
+    bool lookup(uint64_t key, CachedResponse& out);
+
+    //ttl_seconds <= 0 uses the default ttl
+    void store(uint64_t key, const CachedResponse& response, int ttl_seconds);
+
+    //config
+    void set_memory_capacity(size_t max_entries, size_t max_bytes);
+    void set_default_ttl(int seconds);
+    int get_default_ttl() const;
+    bool open_disk_tier(const std::string& path);
+    void close_disk_tier();
+    void clear();
+
+    ResponseCacheStats get_stats() const;
+};
+
+} // namespace necronomicore
+
+#endif // RESPONSE_CACHE_H
@@ -0,0 +1,32 @@
+#ifndef SSE_PARSER_H
+#define SSE_PARSER_H
+
+#include <string>
+#include <functional>
+#include <cstddef>
+
+namespace necronomicore {
+
+//incremental server-sent-events parser
+//fed raw body bytes as they arrive, emits the data payload of each complete event
+class SSEParser {
+private:
+    std::string line_buffer;
+    std::string event_data;
+    bool has_data;
+
+    void handle_line(const std::string& line, const std::function<void(const std::string&)>& on_event);
+
+public:
+    SSEParser();
+
+    void feed(const char* data, size_t size, const std::function<void(const std::string&)>& on_event);
+
+    //flushes an event left open when the stream ends without a blank line
+    void finish(const std::function<void(const std::string&)>& on_event);
+    void reset();
+};
+
+} // namespace necronomicore
+
+#endif // SSE_PARSER_H
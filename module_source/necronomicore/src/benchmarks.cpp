@@ -0,0 +1,925 @@
+#include "benchmarks.h"
+#include "openai_client.h"
+#include "json_utils.h"
+#include "json_writer.h"
+#include "json_reader.h"
+#include "item_generation_service.h"
+#include "item_pool_store.h"
+#include "procedural_item_generator.h"
+#include <godot_cpp/classes/json.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/variant.hpp>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+
+using namespace godot;
+
+namespace necronomicore {
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+//keeps the optimizer from dropping the work being measured
+volatile size_t benchmark_sink = 0;
+
+//mean ns per call over iterations, after a short warmup
+template <typename Fn>
+double time_per_op(int iterations, Fn&& fn) {
+    for (int i = 0; i < iterations / 10 + 1; i++) {
+        benchmark_sink = benchmark_sink + fn();
+    }
+    BenchClock::time_point start = BenchClock::now();
+    for (int i = 0; i < iterations; i++) {
+        benchmark_sink = benchmark_sink + fn();
+    }
+    std::chrono::duration<double, std::nano> elapsed = BenchClock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+//prompt text shaped like the real ones: quotes, newlines and the odd backslash to escape
+std::string make_prompt(size_t bytes) {
+    static const char* const paragraph =
+        "You are \"The Archivist\", a scholar who read too far into the Pnakotic fragments.\n"
+        "Location: flooded reading room.\tMood: anxious.\n"
+        "The player said: \"What is behind the door marked C:\\ELDER\\SIGN?\"\n"
+        "Respond in character in at most two sentences.\n";
+
+    std::string prompt;
+    prompt.reserve(bytes + 256);
+    while (prompt.size() < bytes) {
+        prompt += paragraph;
+    }
+    prompt.resize(bytes);
+    return prompt;
+}
+
+//recorded chat completion responses, ids and fingerprints replaced
+const char* const RECORDED_DIALOG_RESPONSE = R"({
+  "id": "chatcmpl-9xQv2LrT0aKp4mWcY8nZbE1sDfGh",
+  "object": "chat.completion",
+  "created": 1723985301,
+  "model": "gpt-3.5-turbo-0125",
+  "choices": [
+    {
+      "index": 0,
+      "message": {
+        "role": "assistant",
+        "content": "*The Archivist's fingers tremble over the ledger.* \"You shouldn't have come down here\u2014not after the water started singing. Turn back before the pages learn your name.\"",
+        "refusal": null
+      },
+      "logprobs": null,
+      "finish_reason": "stop"
+    }
+  ],
+  "usage": {
+    "prompt_tokens": 187,
+    "completion_tokens": 41,
+    "total_tokens": 228,
+    "prompt_tokens_details": {
+      "cached_tokens": 0
+    },
+    "completion_tokens_details": {
+      "reasoning_tokens": 0
+    }
+  },
+  "system_fingerprint": null
+})";
+
+const char* const RECORDED_STREAM_EVENT =
+    R"({"id":"chatcmpl-9xQv7NcH2pLs8TaQ0bVwXk3yJmRe","object":"chat.completion.chunk","created":1723985344,)"
+    R"("model":"gpt-3.5-turbo-0125","system_fingerprint":null,"choices":[{"index":0,"delta":{"content":" the pages"},)"
+    R"("logprobs":null,"finish_reason":null}]})";
+
+//one generated item as the model writes them, the pool response holds eighteen
+const char* const RECORDED_ITEM_TEMPLATES[] = {
+    R"(  {
+    "name": "Lantern of the Drowned Choir",
+    "description": "A brass lantern whose flame burns green and hums a hymn no living throat could sing.",
+    "type": "accessory",
+    "rarity": "rare",
+    "damage": 0,
+    "defense": 2,
+    "healing": 0,
+    "cooldown": 0.0,
+    "flavor_text": "\"Follow the light,\" they said. None of them said where it went.",
+    "sprite_hint": "lantern_green"
+  })",
+    R"(  {
+    "name": "Rusted Sacrificial Dagger",
+    "description": "Its edge is pitted and flaking, yet wounds it opens refuse to close.",
+    "type": "weapon",
+    "rarity": "common",
+    "damage": 7,
+    "defense": 0,
+    "healing": 0,
+    "cooldown": 0.4,
+    "flavor_text": "The rust tastes of copper, and of something older.",
+    "sprite_hint": "dagger_rust"
+  })",
+    R"(  {
+    "name": "Vial of Black Ichor",
+    "description": "Restores flesh by replacing it. Do not look closely at the new skin.",
+    "type": "consumable",
+    "rarity": "uncommon",
+    "damage": 0,
+    "defense": 0,
+    "healing": 35,
+    "cooldown": 12.0,
+    "flavor_text": "It moves when you are not watching it.",
+    "sprite_hint": "vial_black"
+  })",
+};
+
+//item array content as the model returns it, fences included
+std::string make_item_content(int count) {
+    std::string content = "```json\n[\n";
+    for (int i = 0; i < count; i++) {
+        if (i > 0) {
+            content += ",\n";
+        }
+        content += RECORDED_ITEM_TEMPLATES[i % 3];
+    }
+    content += "\n]\n```";
+    return content;
+}
+
+std::string make_item_pool_response() {
+    std::string content = make_item_content(18);
+
+    std::string body;
+    JSONWriter writer(body);
+    writer.begin_object();
+    writer.key("id");
+    writer.value("chatcmpl-9xQuZ4hV6bRk1TnM3qLc8wYpGs2D");
+    writer.key("object");
+    writer.value("chat.completion");
+    writer.key("created");
+    writer.value(int64_t(1723985112));
+    writer.key("model");
+    writer.value("gpt-3.5-turbo-0125");
+    writer.key("choices");
+    writer.begin_array();
+    writer.begin_object();
+    writer.key("index");
+    writer.value(0);
+    writer.key("message");
+    writer.begin_object();
+    writer.key("role");
+    writer.value("assistant");
+    writer.key("content");
+    writer.value(content);
+    writer.key("refusal");
+    writer.null_value();
+    writer.end_object();
+    writer.key("logprobs");
+    writer.null_value();
+    writer.key("finish_reason");
+    writer.value("stop");
+    writer.end_object();
+    writer.end_array();
+    writer.key("usage");
+    writer.begin_object();
+    writer.key("prompt_tokens");
+    writer.value(412);
+    writer.key("completion_tokens");
+    writer.value(1893);
+    writer.key("total_tokens");
+    writer.value(2305);
+    writer.end_object();
+    writer.key("system_fingerprint");
+    writer.null_value();
+    writer.end_object();
+    return body;
+}
+
+//the parse before single-pass parsing: content parsed into a Variant tree, then each
+//item stringified and parsed again by the old ItemDefinition::from_json
+ItemDefinition legacy_item_from_json(const std::string& json) {
+    ItemDefinition item;
+    Dictionary dict = JSONUtils::parse_json(json);
+    item.name = JSONUtils::get_string(dict, "name", "Unknown Item");
+    item.description = JSONUtils::get_string(dict, "description", "");
+    item.damage = JSONUtils::get_int(dict, "damage", 0);
+    item.defense = JSONUtils::get_int(dict, "defense", 0);
+    item.healing = JSONUtils::get_int(dict, "healing", 0);
+    item.cooldown = JSONUtils::get_float(dict, "cooldown", 0.0f);
+    item.flavor_text = JSONUtils::get_string(dict, "flavor_text", "");
+    item.sprite_hint = JSONUtils::get_string(dict, "sprite_hint", "");
+
+    std::string rarity_str = JSONUtils::get_string(dict, "rarity", "common");
+    std::transform(rarity_str.begin(), rarity_str.end(), rarity_str.begin(), ::tolower);
+    if (rarity_str == "uncommon") item.rarity = ItemRarity::UNCOMMON;
+    else if (rarity_str == "rare") item.rarity = ItemRarity::RARE;
+    else if (rarity_str == "epic") item.rarity = ItemRarity::EPIC;
+    else if (rarity_str == "legendary") item.rarity = ItemRarity::LEGENDARY;
+    else if (rarity_str == "cursed") item.rarity = ItemRarity::CURSED;
+    else item.rarity = ItemRarity::COMMON;
+
+    std::string type_str = JSONUtils::get_string(dict, "type", "weapon");
+    std::transform(type_str.begin(), type_str.end(), type_str.begin(), ::tolower);
+    if (type_str == "armor") item.type = ItemType::ARMOR;
+    else if (type_str == "consumable") item.type = ItemType::CONSUMABLE;
+    else if (type_str == "relic") item.type = ItemType::RELIC;
+    else if (type_str == "artifact") item.type = ItemType::ARTIFACT;
+    else item.type = ItemType::WEAPON;
+    return item;
+}
+
+std::vector<ItemDefinition> legacy_parse_item_array(const std::string& content) {
+    std::vector<ItemDefinition> items;
+    Ref<JSON> json_parser;
+    json_parser.instantiate();
+    if (json_parser->parse(String(content.c_str())) != OK) {
+        return items;
+    }
+    Variant content_data = json_parser->get_data();
+    if (content_data.get_type() == Variant::ARRAY) {
+        Array items_array = content_data;
+        for (int i = 0; i < items_array.size(); i++) {
+            if (items_array[i].get_type() == Variant::DICTIONARY) {
+                Dictionary item_dict = items_array[i];
+                ItemDefinition item = legacy_item_from_json(JSONUtils::stringify_json(item_dict));
+                ItemGenerationService::validate_and_clamp_item(item);
+                items.push_back(item);
+            }
+        }
+    }
+    return items;
+}
+
+ItemPool make_pool(const std::vector<ItemDefinition>& items, int floor = 1) {
+    ItemPool pool;
+    pool.pool_id = "bench";
+    pool.theme = "lovecraftian fungal dungeon";
+    pool.floor_number = floor;
+    pool.store.build(items, floor);
+    return pool;
+}
+
+bool same_items(const std::vector<ItemDefinition>& a, const std::vector<ItemDefinition>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].name != b[i].name || a[i].description != b[i].description ||
+            a[i].flavor_text != b[i].flavor_text || a[i].sprite_hint != b[i].sprite_hint ||
+            a[i].effects != b[i].effects || a[i].type != b[i].type || a[i].rarity != b[i].rarity ||
+            a[i].damage != b[i].damage || a[i].defense != b[i].defense ||
+            a[i].healing != b[i].healing || a[i].cooldown != b[i].cooldown) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<ItemDefinition> pool_items(const ItemPool& pool) {
+    std::vector<ItemDefinition> items;
+    for (size_t row = 0; row < pool.store.size(); row++) {
+        items.push_back(pool.store.get_item(row));
+    }
+    return items;
+}
+
+bool same_pool(const ItemPool& a, const ItemPool& b) {
+    return same_items(pool_items(a), pool_items(b));
+}
+
+} // anonymous namespace
+
+std::vector<std::string> Benchmarks::get_names() {
+    return {"request_body", "response_parse", "item_parse", "pool_load", "item_sample", "pool_snapshot", "procedural_items"};
+}
+
+Dictionary Benchmarks::run(const std::string& name, const Dictionary& options) {
+    if (name == "request_body") {
+        return request_body(options);
+    }
+    if (name == "response_parse") {
+        return response_parse(options);
+    }
+    if (name == "item_parse") {
+        return item_parse(options);
+    }
+    if (name == "pool_load") {
+        return pool_load(options);
+    }
+    if (name == "item_sample") {
+        return item_sample(options);
+    }
+    if (name == "pool_snapshot") {
+        return pool_snapshot(options);
+    }
+    if (name == "procedural_items") {
+        return procedural_items(options);
+    }
+
+    Dictionary result;
+    result["error"] = String(("Unknown benchmark: " + name).c_str());
+    return result;
+}
+
+Dictionary Benchmarks::request_body(const Dictionary& options) {
+    int iterations = JSONUtils::get_int(options, "iterations", 2000);
+    if (iterations < 1) {
+        iterations = 1;
+    }
+    Array sizes = JSONUtils::get_array(options, "sizes");
+    if (sizes.is_empty()) {
+        sizes.append(1024);
+        sizes.append(10 * 1024);
+    }
+
+    Array cases;
+    for (int64_t i = 0; i < sizes.size(); i++) {
+        int64_t size = sizes[i];
+        std::string prompt = make_prompt(static_cast<size_t>(size > 0 ? size : 1));
+
+        //what the services did before: Array of Dictionaries, then Dictionary + stringify
+        auto legacy = [&prompt]() {
+            Array messages;
+            Dictionary user_message;
+            user_message[Variant("role")] = Variant("user");
+            user_message[Variant("content")] = Variant(String(prompt.c_str()));
+            messages.append(user_message);
+
+            Dictionary body;
+            body[Variant("model")] = Variant("gpt-3.5-turbo");
+            body[Variant("messages")] = Variant(messages);
+            body[Variant("temperature")] = Variant(0.9f);
+            body[Variant("max_tokens")] = Variant(150);
+            return JSONUtils::stringify_json(body).size();
+        };
+
+        //current path, buffer reused across calls the way a request body is rebuilt per call
+        std::string buffer;
+        auto native = [&prompt, &buffer]() {
+            std::vector<ChatMessage> messages = {{"user", prompt}};
+            OpenAIClient::build_chat_completion_body(buffer, messages, "gpt-3.5-turbo", 0.9f, 150, false);
+            return buffer.size();
+        };
+
+        double legacy_ns = time_per_op(iterations, legacy);
+        double native_ns = time_per_op(iterations, native);
+
+        //both bodies must carry the same prompt back out of a json parser
+        std::string legacy_body;
+        {
+            Array messages;
+            Dictionary user_message;
+            user_message[Variant("role")] = Variant("user");
+            user_message[Variant("content")] = Variant(String(prompt.c_str()));
+            messages.append(user_message);
+            Dictionary body;
+            body[Variant("messages")] = Variant(messages);
+            legacy_body = JSONUtils::stringify_json(body);
+        }
+        Array legacy_messages = JSONUtils::get_array(JSONUtils::parse_json(legacy_body), "messages");
+        Array native_messages = JSONUtils::get_array(JSONUtils::parse_json(buffer), "messages");
+        bool outputs_match = legacy_messages.size() == 1 && native_messages.size() == 1 &&
+            JSONUtils::get_string(legacy_messages[0], "content") == JSONUtils::get_string(native_messages[0], "content");
+
+        Dictionary entry;
+        std::string label = size % 1024 == 0 ? std::to_string(size / 1024) + " KB prompt"
+                                              : std::to_string(size) + " byte prompt";
+        entry["label"] = String(label.c_str());
+        entry["iterations"] = iterations;
+        entry["bytes"] = static_cast<int64_t>(buffer.size());
+        entry["legacy_ns"] = legacy_ns;
+        entry["native_ns"] = native_ns;
+        entry["speedup"] = native_ns > 0.0 ? legacy_ns / native_ns : 0.0;
+        entry["outputs_match"] = outputs_match;
+        cases.append(entry);
+    }
+
+    Dictionary result;
+    result["name"] = "request_body";
+    result["cases"] = cases;
+    return result;
+}
+
+Dictionary Benchmarks::response_parse(const Dictionary& options) {
+    int iterations = JSONUtils::get_int(options, "iterations", 5000);
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    struct Recording {
+        const char* label;
+        std::string body;
+        const char* parent; //"message" for completions, "delta" for stream events
+    };
+    std::vector<Recording> recordings = {
+        {"dialog response", RECORDED_DIALOG_RESPONSE, "message"},
+        {"item pool response", make_item_pool_response(), "message"},
+        {"stream event", RECORDED_STREAM_EVENT, "delta"},
+    };
+
+    Array cases;
+    for (const Recording& recording : recordings) {
+        const std::string& body = recording.body;
+        std::string parent = recording.parent;
+        std::string content_path = "choices/0/" + parent + "/content";
+
+        //what extract_message_content did before: a full Variant tree, then keyed lookups
+        std::string legacy_content;
+        int legacy_tokens = 0;
+        auto legacy = [&]() {
+            Dictionary response = JSONUtils::parse_json(body);
+            Array choices = JSONUtils::get_array(response, "choices");
+            legacy_content.clear();
+            if (choices.size() > 0) {
+                Dictionary first_choice = choices[0];
+                legacy_content = JSONUtils::get_string(JSONUtils::get_dict(first_choice, parent), "content");
+            }
+            Dictionary usage = JSONUtils::get_dict(response, "usage");
+            legacy_tokens = JSONUtils::get_int(usage, "prompt_tokens") + JSONUtils::get_int(usage, "completion_tokens");
+            return legacy_content.size();
+        };
+
+        std::string native_content;
+        int native_tokens = 0;
+        auto native = [&]() {
+            JSONReader reader(body);
+            reader.get_string(content_path, native_content);
+            //same lookups as OpenAIClient::extract_completion
+            int64_t prompt_tokens = 0;
+            int64_t completion_tokens = 0;
+            std::string_view usage_json;
+            if (reader.find("usage", usage_json)) {
+                JSONReader usage(usage_json);
+                usage.get_int("prompt_tokens", prompt_tokens);
+                usage.get_int("completion_tokens", completion_tokens);
+            }
+            native_tokens = static_cast<int>(prompt_tokens + completion_tokens);
+            return native_content.size();
+        };
+
+        double legacy_ns = time_per_op(iterations, legacy);
+        double native_ns = time_per_op(iterations, native);
+
+        Dictionary entry;
+        entry["label"] = recording.label;
+        entry["iterations"] = iterations;
+        entry["bytes"] = static_cast<int64_t>(body.size());
+        entry["legacy_ns"] = legacy_ns;
+        entry["native_ns"] = native_ns;
+        entry["speedup"] = native_ns > 0.0 ? legacy_ns / native_ns : 0.0;
+        entry["outputs_match"] = legacy_content == native_content && legacy_tokens == native_tokens;
+        cases.append(entry);
+    }
+
+    Dictionary result;
+    result["name"] = "response_parse";
+    result["cases"] = cases;
+    return result;
+}
+
+Dictionary Benchmarks::item_parse(const Dictionary& options) {
+    int iterations = JSONUtils::get_int(options, "iterations", 200);
+    if (iterations < 1) {
+        iterations = 1;
+    }
+    Array counts = JSONUtils::get_array(options, "counts");
+    if (counts.is_empty()) {
+        counts.append(10);
+        counts.append(100);
+        counts.append(1000);
+    }
+
+    Array cases;
+    for (int64_t i = 0; i < counts.size(); i++) {
+        int count = counts[i];
+        std::string content = make_item_content(count > 0 ? count : 1);
+        //the old parser had no fence handling, give it the bare array so both do the same work
+        std::string bare = content.substr(content.find('['), content.rfind(']') - content.find('[') + 1);
+
+        std::vector<ItemDefinition> legacy_items;
+        auto legacy = [&]() {
+            legacy_items = legacy_parse_item_array(bare);
+            return legacy_items.size();
+        };
+
+        std::vector<ItemDefinition> native_items;
+        auto native = [&]() {
+            native_items = ItemGenerationService::parse_item_array(content);
+            return native_items.size();
+        };
+
+        //"iterations" is the round count for 10 items, scaled down for bigger payloads
+        //since the legacy path takes milliseconds there
+        int rounds = std::max(1, iterations * 10 / std::max(count, 10));
+        double legacy_ns = time_per_op(rounds, legacy);
+        double native_ns = time_per_op(rounds, native);
+
+        bool outputs_match = legacy_items.size() == native_items.size();
+        for (size_t item = 0; outputs_match && item < native_items.size(); item++) {
+            const ItemDefinition& a = legacy_items[item];
+            const ItemDefinition& b = native_items[item];
+            outputs_match = a.name == b.name && a.description == b.description &&
+                a.rarity == b.rarity && a.type == b.type &&
+                a.flavor_text == b.flavor_text && a.damage == b.damage &&
+                a.defense == b.defense && a.healing == b.healing && a.cooldown == b.cooldown;
+        }
+
+        Dictionary entry;
+        entry["label"] = String((std::to_string(count) + " items").c_str());
+        entry["iterations"] = rounds;
+        entry["bytes"] = static_cast<int64_t>(content.size());
+        entry["legacy_ns"] = legacy_ns;
+        entry["native_ns"] = native_ns;
+        entry["speedup"] = native_ns > 0.0 ? legacy_ns / native_ns : 0.0;
+        entry["outputs_match"] = outputs_match;
+        cases.append(entry);
+    }
+
+    Dictionary result;
+    result["name"] = "item_parse";
+    result["cases"] = cases;
+    return result;
+}
+
+Dictionary Benchmarks::pool_load(const Dictionary& options) {
+    int iterations = JSONUtils::get_int(options, "iterations", 200);
+    if (iterations < 1) {
+        iterations = 1;
+    }
+    Array counts = JSONUtils::get_array(options, "counts");
+    if (counts.is_empty()) {
+        counts.append(10);
+        counts.append(100);
+        counts.append(1000);
+    }
+
+    //scratch store, removed again below
+    std::error_code ec;
+    std::filesystem::path directory = std::filesystem::temp_directory_path(ec) / "necronomicore_pool_bench";
+    ItemPoolStore store;
+    if (ec || !store.open(directory.string())) {
+        Dictionary result;
+        result["error"] = "Could not create a scratch pool store";
+        return result;
+    }
+
+    Array cases;
+    for (int64_t i = 0; i < counts.size(); i++) {
+        int count = counts[i];
+        std::string content = make_item_content(count > 0 ? count : 1);
+        std::vector<ItemDefinition> parsed = ItemGenerationService::parse_item_array(content);
+        ItemPool expected = make_pool(parsed);
+        uint64_t key = ItemPoolStore::config_key(content);
+        store.save(key, expected);
+
+        //before the store a restart rebuilt the pool from the cached response text
+        ItemPool legacy_pool;
+        auto legacy = [&]() {
+            std::vector<ItemDefinition> items = ItemGenerationService::parse_item_array(content);
+            legacy_pool = make_pool(items);
+            return legacy_pool.store.size() + items.size();
+        };
+
+        //first load opens and maps the file, later loads read the existing mapping
+        BenchClock::time_point first_start = BenchClock::now();
+        std::shared_ptr<ItemPool> native_pool = store.load(key);
+        std::chrono::duration<double, std::nano> first_load = BenchClock::now() - first_start;
+        auto native = [&]() {
+            native_pool = store.load(key);
+            return native_pool ? native_pool->store.size() + 1 : 0;
+        };
+
+        int rounds = std::max(1, iterations * 10 / std::max(count, 10));
+        double legacy_ns = time_per_op(rounds, legacy);
+        double native_ns = time_per_op(rounds, native);
+
+        Dictionary entry;
+        entry["label"] = String((std::to_string(count) + " items").c_str());
+        entry["iterations"] = rounds;
+        entry["bytes"] = static_cast<int64_t>(content.size());
+        entry["legacy_ns"] = legacy_ns;
+        entry["native_ns"] = native_ns;
+        entry["first_load_ns"] = first_load.count();
+        entry["speedup"] = native_ns > 0.0 ? legacy_ns / native_ns : 0.0;
+        entry["outputs_match"] = native_pool != nullptr && same_pool(legacy_pool, *native_pool) && same_pool(expected, *native_pool);
+        cases.append(entry);
+    }
+
+    store.clear();
+    store.close();
+    std::filesystem::remove(directory, ec);
+
+    Dictionary result;
+    result["name"] = "pool_load";
+    result["cases"] = cases;
+    return result;
+}
+
+Dictionary Benchmarks::item_sample(const Dictionary& options) {
+    int iterations = JSONUtils::get_int(options, "iterations", 1000000);
+    if (iterations < 1) {
+        iterations = 1;
+    }
+    int floor = JSONUtils::get_int(options, "floor", 5);
+    int count = JSONUtils::get_int(options, "count", 100);
+
+    //the recorded items spread over every rarity and type, like a varied generated pool
+    std::vector<ItemDefinition> items = ItemGenerationService::parse_item_array(make_item_content(count > 0 ? count : 1));
+    for (size_t i = 0; i < items.size(); i++) {
+        items[i].rarity = static_cast<ItemRarity>(i % ItemStore::RARITY_COUNT);
+        items[i].type = static_cast<ItemType>(i % ItemStore::TYPE_COUNT);
+        items[i].damage = static_cast<int>(i * 7 % 200) - 20;
+    }
+    ItemPool pool = make_pool(items, floor);
+    const ItemStore& store = pool.store;
+
+    //the old per-rarity vectors
+    std::vector<ItemDefinition> buckets[ItemStore::RARITY_COUNT];
+    for (const ItemDefinition& item : items) {
+        buckets[static_cast<int>(item.rarity)].push_back(item);
+    }
+    std::mt19937_64 rng(12345);
+    std::srand(12345);
+
+    //the old pick: rand() % 6 for the rarity, rand() % size within it
+    auto legacy_pick = [&](int rarity) -> const ItemDefinition* {
+        const std::vector<ItemDefinition>& bucket = buckets[rarity];
+        if (bucket.empty()) {
+            return nullptr;
+        }
+        return &bucket[std::rand() % bucket.size()];
+    };
+
+    Array cases;
+    auto add_case = [&cases](const char* label, int rounds, double legacy_ns, double native_ns, bool outputs_match) {
+        Dictionary entry;
+        entry["label"] = label;
+        entry["iterations"] = rounds;
+        entry["bytes"] = 0;
+        entry["legacy_ns"] = legacy_ns;
+        entry["native_ns"] = native_ns;
+        entry["speedup"] = native_ns > 0.0 ? legacy_ns / native_ns : 0.0;
+        entry["samples_per_second"] = native_ns > 0.0 ? 1e9 / native_ns : 0.0;
+        entry["outputs_match"] = outputs_match;
+        cases.append(entry);
+    };
+
+    //any rarity: the old path was uniform over rarities, the store follows the floor's odds
+    {
+        double legacy_ns = time_per_op(iterations, [&]() {
+            const ItemDefinition* item = legacy_pick(std::rand() % ItemStore::RARITY_COUNT);
+            return item ? item->name.size() : 0;
+        });
+        int64_t rarity_counts[ItemStore::RARITY_COUNT] = {};
+        double native_ns = time_per_op(iterations, [&]() {
+            int64_t row = store.sample(rng);
+            rarity_counts[store.get_rarity(row)]++;
+            return static_cast<size_t>(row);
+        });
+
+        //observed rarity frequencies against the floor's odds
+        double total_weight = 0.0;
+        int64_t total_samples = 0;
+        for (int r = 0; r < ItemStore::RARITY_COUNT; r++) {
+            total_weight += ItemStore::rarity_weight(static_cast<ItemRarity>(r), floor);
+            total_samples += rarity_counts[r];
+        }
+        bool matches = true;
+        for (int r = 0; r < ItemStore::RARITY_COUNT; r++) {
+            double expected = ItemStore::rarity_weight(static_cast<ItemRarity>(r), floor) / total_weight;
+            double observed = static_cast<double>(rarity_counts[r]) / total_samples;
+            matches = matches && std::abs(observed - expected) < 0.01 + 5.0 / std::sqrt(static_cast<double>(total_samples));
+        }
+        add_case("any rarity", iterations, legacy_ns, native_ns, matches);
+    }
+
+    //one rarity
+    {
+        int rare = static_cast<int>(ItemRarity::RARE);
+        double legacy_ns = time_per_op(iterations, [&]() {
+            const ItemDefinition* item = legacy_pick(rare);
+            return item ? item->name.size() : 0;
+        });
+        bool matches = true;
+        double native_ns = time_per_op(iterations, [&]() {
+            int64_t row = store.sample(rng, rare);
+            matches = matches && store.get_rarity(row) == rare;
+            return static_cast<size_t>(row);
+        });
+        add_case("rare only", iterations, legacy_ns, native_ns, matches);
+    }
+
+    //type filter: the old buckets could only redraw until the type matched
+    {
+        int armor = static_cast<int>(ItemType::ARMOR);
+        double legacy_ns = time_per_op(iterations, [&]() {
+            for (int attempt = 0; attempt < 64; attempt++) {
+                const ItemDefinition* item = legacy_pick(std::rand() % ItemStore::RARITY_COUNT);
+                if (item && item->type == ItemType::ARMOR) {
+                    return item->name.size();
+                }
+            }
+            return size_t(0);
+        });
+        bool matches = true;
+        double native_ns = time_per_op(iterations, [&]() {
+            int64_t row = store.sample(rng, ItemStore::ANY, armor);
+            matches = matches && row >= 0 && store.get_type(row) == armor;
+            return static_cast<size_t>(row);
+        });
+        add_case("armor only", iterations, legacy_ns, native_ns, matches);
+    }
+
+    //clamping a whole pool
+    {
+        int rounds = std::max(1, iterations / 1000);
+        std::vector<ItemDefinition> legacy_items;
+        for (const auto& bucket : buckets) {
+            legacy_items.insert(legacy_items.end(), bucket.begin(), bucket.end());
+        }
+        double legacy_ns = time_per_op(rounds, [&]() {
+            for (ItemDefinition& item : legacy_items) {
+                ItemGenerationService::validate_and_clamp_item(item);
+            }
+            return legacy_items.size();
+        });
+        ItemStore columns;
+        columns.build(items, floor);
+        double native_ns = time_per_op(rounds, [&]() {
+            columns.clamp_stats();
+            return columns.size();
+        });
+
+        bool matches = legacy_items.size() == columns.size();
+        for (size_t row = 0; matches && row < columns.size(); row++) {
+            ItemDefinition item = columns.get_item(row);
+            matches = item.damage == legacy_items[row].damage && item.defense == legacy_items[row].defense &&
+                item.healing == legacy_items[row].healing && item.cooldown == legacy_items[row].cooldown;
+        }
+        add_case("clamp pool", rounds, legacy_ns, native_ns, matches);
+    }
+
+    Dictionary result;
+    result["name"] = "item_sample";
+    result["cases"] = cases;
+    return result;
+}
+
+Dictionary Benchmarks::pool_snapshot(const Dictionary& options) {
+    int iterations = JSONUtils::get_int(options, "iterations", 200);
+    if (iterations < 1) {
+        iterations = 1;
+    }
+    int page_size = JSONUtils::get_int(options, "page_size", 20);
+    Array counts = JSONUtils::get_array(options, "counts");
+    if (counts.is_empty()) {
+        counts.append(10);
+        counts.append(100);
+        counts.append(1000);
+    }
+
+    Array cases;
+    for (int64_t i = 0; i < counts.size(); i++) {
+        int count = counts[i];
+        std::vector<ItemDefinition> items = ItemGenerationService::parse_item_array(make_item_content(count > 0 ? count : 1));
+        ItemPool pool = make_pool(items);
+        int rounds = std::max(1, iterations * 10 / std::max(count, 10));
+
+        //before the cache every query built a Dictionary per item
+        Array legacy_items;
+        auto legacy = [&]() {
+            legacy_items = Array();
+            for (size_t row = 0; row < pool.store.size(); row++) {
+                legacy_items.append(pool.store.to_dictionary(row));
+            }
+            return static_cast<size_t>(legacy_items.size());
+        };
+        double legacy_ns = time_per_op(rounds, legacy);
+
+        auto add_case = [&](const std::string& label, double native_ns, bool outputs_match) {
+            Dictionary entry;
+            entry["label"] = String((std::to_string(count) + " items, " + label).c_str());
+            entry["iterations"] = rounds;
+            entry["bytes"] = 0;
+            entry["legacy_ns"] = legacy_ns;
+            entry["native_ns"] = native_ns;
+            entry["speedup"] = native_ns > 0.0 ? legacy_ns / native_ns : 0.0;
+            entry["outputs_match"] = outputs_match;
+            cases.append(entry);
+        };
+
+        //whole pool: built on the first query, the same array after that
+        {
+            PoolSnapshotCache cache;
+            Array native_items;
+            double native_ns = time_per_op(rounds, [&]() {
+                native_items = cache.get_items(pool);
+                return static_cast<size_t>(native_items.size());
+            });
+            add_case("whole pool", native_ns, native_items == legacy_items && native_items.is_read_only());
+        }
+
+        //one page, only its rows are built when the pool hasn't been asked for whole
+        {
+            PoolSnapshotCache cache;
+            Array page;
+            double native_ns = time_per_op(rounds, [&]() {
+                page = cache.get_range(pool, 0, page_size);
+                return static_cast<size_t>(page.size());
+            });
+            int64_t expected = std::min<int64_t>(page_size, legacy_items.size());
+            add_case("page of " + std::to_string(page_size), native_ns,
+                     page == legacy_items.slice(0, expected));
+        }
+
+        //packed export, decoded with the pool store's reader to check it
+        {
+            PoolSnapshotCache cache;
+            PackedByteArray packed;
+            double native_ns = time_per_op(rounds, [&]() {
+                packed = cache.get_packed(pool);
+                return static_cast<size_t>(packed.size());
+            });
+            std::shared_ptr<ItemPool> decoded = ItemPoolStore::deserialize(0, reinterpret_cast<const char*>(packed.ptr()), packed.size());
+            add_case("packed export", native_ns, decoded != nullptr && same_pool(pool, *decoded));
+        }
+    }
+
+    Dictionary result;
+    result["name"] = "pool_snapshot";
+    result["cases"] = cases;
+    return result;
+}
+
+Dictionary Benchmarks::procedural_items(const Dictionary& options) {
+    int iterations = JSONUtils::get_int(options, "iterations", 200);
+    if (iterations < 1) {
+        iterations = 1;
+    }
+    Array counts = JSONUtils::get_array(options, "counts");
+    if (counts.is_empty()) {
+        counts.append(10);
+        counts.append(100);
+        counts.append(1000);
+    }
+
+    Array cases;
+    for (int64_t i = 0; i < counts.size(); i++) {
+        int count = counts[i];
+        count = std::max(count, 1);
+        std::string content = make_item_content(count);
+
+        //without the generator every item came from the model's reply
+        std::vector<ItemDefinition> legacy_items;
+        auto legacy = [&]() {
+            legacy_items = ItemGenerationService::parse_item_array(content);
+            return legacy_items.size();
+        };
+
+        //the same number of items spread over the rarities, as a pool would ask for them
+        int per_rarity[ItemStore::RARITY_COUNT];
+        for (int r = 0; r < ItemStore::RARITY_COUNT; r++) {
+            per_rarity[r] = count / ItemStore::RARITY_COUNT + (r < count % ItemStore::RARITY_COUNT ? 1 : 0);
+        }
+        std::mt19937_64 rng(12345);
+        std::vector<ItemDefinition> native_items;
+        auto native = [&]() {
+            native_items.clear();
+            ProceduralItemGenerator::generate_pool(rng, per_rarity, 3, 4, "lovecraftian fungal dungeon", native_items);
+            return native_items.size();
+        };
+
+        int rounds = std::max(1, iterations * 10 / std::max(count, 10));
+        double legacy_ns = time_per_op(rounds, legacy);
+        double native_ns = time_per_op(rounds, native);
+
+        //every item named, described and within its rarity's limits
+        bool valid = static_cast<int>(native_items.size()) == count;
+        for (const ItemDefinition& item : native_items) {
+            int max_stat = ItemStore::max_stat(item.rarity);
+            valid = valid && !item.name.empty() && !item.description.empty() && !item.flavor_text.empty() &&
+                item.damage >= 0 && item.damage <= max_stat && item.defense >= 0 && item.defense <= max_stat &&
+                item.healing >= 0 && item.healing <= max_stat * 2;
+        }
+
+        Dictionary entry;
+        entry["label"] = String((std::to_string(count) + " items").c_str());
+        entry["iterations"] = rounds;
+        entry["bytes"] = static_cast<int64_t>(content.size());
+        entry["legacy_ns"] = legacy_ns;
+        entry["native_ns"] = native_ns;
+        entry["speedup"] = native_ns > 0.0 ? legacy_ns / native_ns : 0.0;
+        entry["items_per_ms"] = native_ns > 0.0 ? count * 1e6 / native_ns : 0.0;
+        entry["items_valid"] = valid;
+        cases.append(entry);
+    }
+
+    Dictionary result;
+    result["name"] = "procedural_items";
+    result["cases"] = cases;
+    return result;
+}
+
+} // namespace necronomicore
@@ -0,0 +1,98 @@
+#include "circuit_breaker.h"
+#include <algorithm>
+
+namespace necronomicore {
+
+CircuitBreaker::CircuitBreaker()
+    : failure_threshold(5),
+      base_cooldown_seconds(5.0),
+      max_cooldown_seconds(60.0) {
+}
+
+void CircuitBreaker::set_failure_threshold(int failures) {
+    failure_threshold = failures > 0 ? failures : 1;
+}
+
+void CircuitBreaker::set_cooldown(double base_seconds, double max_seconds) {
+    base_cooldown_seconds = std::max(base_seconds, 0.1);
+    max_cooldown_seconds = std::max(max_seconds, base_cooldown_seconds);
+}
+
+void CircuitBreaker::trip(Circuit& circuit) {
+    //each failed probe doubles the wait before the next one
+    circuit.cooldown_seconds = circuit.stats.state == CircuitState::CLOSED
+        ? base_cooldown_seconds
+        : std::min(circuit.cooldown_seconds * 2.0, max_cooldown_seconds);
+    circuit.open_until = Clock::now() +
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(circuit.cooldown_seconds));
+    if (circuit.stats.state == CircuitState::CLOSED) {
+        circuit.stats.trips++;
+    }
+    circuit.stats.state = CircuitState::OPEN;
+}
+
+bool CircuitBreaker::is_open(const std::string& endpoint) const {
+    auto it = circuits.find(endpoint);
+    return it != circuits.end() && it->second.stats.state != CircuitState::CLOSED;
+}
+
+void CircuitBreaker::record_fast_failure(const std::string& endpoint) {
+    circuits[endpoint].stats.fast_failures++;
+}
+
+void CircuitBreaker::record_success(const std::string& endpoint) {
+    auto it = circuits.find(endpoint);
+    if (it == circuits.end()) {
+        return;
+    }
+    //a late success from before the trip doesn't close the circuit, only the probe does
+    if (it->second.stats.state == CircuitState::CLOSED) {
+        it->second.stats.consecutive_failures = 0;
+    }
+}
+
+void CircuitBreaker::record_failure(const std::string& endpoint) {
+    Circuit& circuit = circuits[endpoint];
+    circuit.stats.consecutive_failures++;
+    if (circuit.stats.state == CircuitState::CLOSED &&
+        circuit.stats.consecutive_failures >= failure_threshold) {
+        trip(circuit);
+    }
+}
+
+std::vector<std::string> CircuitBreaker::take_due_probes() {
+    std::vector<std::string> due;
+    Clock::time_point now = Clock::now();
+    for (auto& pair : circuits) {
+        Circuit& circuit = pair.second;
+        if (circuit.stats.state == CircuitState::OPEN && circuit.open_until <= now) {
+            circuit.stats.state = CircuitState::HALF_OPEN;
+            circuit.stats.probes++;
+            due.push_back(pair.first);
+        }
+    }
+    return due;
+}
+
+void CircuitBreaker::record_probe_result(const std::string& endpoint, bool healthy) {
+    auto it = circuits.find(endpoint);
+    if (it == circuits.end() || it->second.stats.state != CircuitState::HALF_OPEN) {
+        return;
+    }
+
+    Circuit& circuit = it->second;
+    if (healthy) {
+        circuit.stats.state = CircuitState::CLOSED;
+        circuit.stats.consecutive_failures = 0;
+        circuit.cooldown_seconds = 0.0;
+    } else {
+        trip(circuit);
+    }
+}
+
+CircuitStats CircuitBreaker::get_stats(const std::string& endpoint) const {
+    auto it = circuits.find(endpoint);
+    return it != circuits.end() ? it->second.stats : CircuitStats();
+}
+
+} // namespace necronomicore
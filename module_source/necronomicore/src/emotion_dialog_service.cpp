@@ -2,12 +2,178 @@
 #include "json_utils.h"
 #include <godot_cpp/variant/utility_functions.hpp>
 #include <godot_cpp/variant/variant.hpp>
-#include <sstream>
+#include <charconv>
+#include <algorithm>
+#include <cctype>
 
 using namespace godot;
 
 namespace necronomicore {
 
+namespace {
+
+const char* const DIALOG_RULES =
+    "You are roleplaying as an NPC in a Lovecraftian horror dungeon crawler game.\n"
+    "The next message describes the NPC you are playing, the last one the current moment.\n\n"
+    "Rules:\n"
+    "- Reply with a single line of dialog that this NPC would say.\n"
+    "- Stay in character. Use atmosphere and horror elements.\n"
+    "- Keep the response under 100 words.\n"
+    "- Do not include quotation marks or the character's name in the response.\n";
+
+const char* const SUMMARY_RULES =
+    "You keep notes for an NPC in a Lovecraftian horror dungeon crawler game.\n"
+    "Merge the new lines into the summary of the conversation so far.\n"
+    "Reply with the updated summary only, in the third person, at most 60 words.\n";
+
+const char* const BANK_RULES =
+    "You write reusable lines for an NPC in a Lovecraftian horror dungeon crawler game.\n"
+    "The next message describes the NPC, the last one their mood and surroundings.\n\n"
+    "Rules:\n"
+    "- Put every line on its own line, starting with its kind and a colon, e.g. GREETING: ...\n"
+    "- Kinds: GREETING (the player walks up), FAREWELL (the player leaves), "
+    "BARK (a short outburst showing the mood), IDLE (muttering to themself).\n"
+    "- Stay in character. Under 25 words per line.\n"
+    "- No quotation marks, names or numbering.\n";
+
+const char* const LINE_KIND_NAMES[DIALOG_LINE_KIND_COUNT] = {"greeting", "farewell", "bark", "idle"};
+
+//lines asked for per kind in one request, a bag holds at most two requests' worth
+const int BANK_LINES_PER_KIND = 6;
+const size_t BANK_MAX_LINES = 12;
+//a bag with fewer unserved lines than this refills its bank
+const size_t BANK_LOW_WATER = 2;
+const size_t MAX_BANK_LINE_BYTES = 300;
+
+//first keyword found in the lowercased location picks the bucket
+struct LocationBucket {
+    const char* name;
+    const char* keywords[6];
+};
+const LocationBucket LOCATION_BUCKETS[] = {
+    {"cavern", {"cave", "cavern", "grotto", "tunnel", "mine", nullptr}},
+    {"crypt", {"crypt", "tomb", "catacomb", "ossuary", "grave", nullptr}},
+    {"shrine", {"shrine", "temple", "altar", "chapel", "sanctum", nullptr}},
+    {"market", {"shop", "stall", "market", "merchant", "camp", nullptr}},
+    {"flooded", {"lake", "river", "sewer", "flood", "pool", nullptr}},
+};
+const char* const DEFAULT_LOCATION_BUCKET = "dungeon";
+
+std::string bank_key(const std::string& npc_id, const std::string& mood, const char* bucket) {
+    std::string key = npc_id;
+    key += '\n';
+    key += mood;
+    key += '\n';
+    key += bucket;
+    return key;
+}
+
+std::string_view trim(std::string_view text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) {
+        begin++;
+    }
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+        end--;
+    }
+    return text.substr(begin, end - begin);
+}
+
+const char* const MESSAGE_RULES =
+    "You write environmental messages for a Lovecraftian horror dungeon crawler game: "
+    "words scrawled on a wall, carved into stone or written in fungal growth.\n\n"
+    "Rules:\n"
+    "- One message per line and nothing else.\n"
+    "- Each message is cryptic, unsettling and atmospheric, at most 20 words.\n"
+    "- No numbering or quotation marks.\n";
+
+const char* const FALLBACK_MESSAGE = "The walls whisper secrets best left forgotten...";
+
+//messages asked for in one request, a ring holds two batches and refills below the watermark
+const int MESSAGE_BATCH = 24;
+const size_t MESSAGE_RING_CAPACITY = 2 * MESSAGE_BATCH;
+const size_t MESSAGE_LOW_WATER = MESSAGE_BATCH / 2;
+const size_t MAX_MESSAGE_BYTES = 200;
+const int MAX_DANGER_LEVEL = 5;
+
+struct MessageTag {
+    const char* bucket;
+    int danger_level;
+    std::string key;
+};
+
+MessageTag read_message_tag(const Dictionary& context) {
+    MessageTag tag;
+    std::string location = JSONUtils::get_string(context, "location", "dungeon room");
+    tag.bucket = EmotionDialogService::location_bucket(location);
+    tag.danger_level = std::clamp(JSONUtils::get_int(context, "danger_level", 1), 1, MAX_DANGER_LEVEL);
+    tag.key = tag.bucket;
+    tag.key += '/';
+    tag.key += std::to_string(tag.danger_level);
+    return tag;
+}
+
+//live and prefetched lines are requested with the same parameters, so a live request that
+//catches its prefetch still in flight has the same body and shares that call
+const char* const DIALOG_MODEL = "gpt-3.5-turbo";
+const float DIALOG_TEMPERATURE = 0.9f;
+const int DIALOG_MAX_TOKENS = 150;
+
+const size_t DEFAULT_HISTORY_LENGTH = 4;
+//a dialog line is capped at 150 tokens, these keep a runaway reply or player input
+//from growing the prompt
+const size_t MAX_TURN_BYTES = 768;
+const size_t MAX_SUMMARY_BYTES = 512;
+
+//copies at most max_bytes of text, backing off to a utf-8 boundary
+void assign_clamped(std::string& out, std::string_view text, size_t max_bytes) {
+    size_t length = text.size();
+    if (length > max_bytes) {
+        length = max_bytes;
+        while (length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80) {
+            length--;
+        }
+    }
+    out.assign(text.data(), length);
+}
+
+void append_turn(std::string& out, const DialogTurn& turn) {
+    if (!turn.player.empty()) {
+        out += "- Player: ";
+        out += turn.player;
+        out += '\n';
+    }
+    out += "- NPC: ";
+    out += turn.npc;
+    out += '\n';
+}
+
+//the fields render_persona reads
+bool same_persona(const NPCPersonality& a, const NPCPersonality& b) {
+    if (a.npc_name != b.npc_name || a.archetype != b.archetype || a.sanity_level != b.sanity_level ||
+        a.background_info != b.background_info || a.traits.size() != b.traits.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.traits.size(); i++) {
+        const PersonalityTrait& x = a.traits[i];
+        const PersonalityTrait& y = b.traits[i];
+        if (x.trait_name != y.trait_name || x.intensity != y.intensity || x.description != y.description) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//shortest text that round-trips, 0.7f is "0.7"
+void append_number(std::string& out, float number) {
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+}
+
+} // anonymous namespace
+
 Dictionary NPCPersonality::to_dictionary() const {
     Dictionary dict;
     dict["npc_id"] = String(npc_id.c_str());
@@ -53,7 +219,27 @@ NPCPersonality NPCPersonality::from_dictionary(const Dictionary& dict) {
 }
 
 EmotionDialogService::EmotionDialogService(std::shared_ptr<OpenAIClient> openai_client)
-    : client(openai_client) {
+    : client(openai_client),
+      history_length(DEFAULT_HISTORY_LENGTH),
+      next_history_generation(1),
+      summaries_written(0),
+      summary_failures(0),
+      next_speculative_ticket(1),
+      prefetches_sent(0),
+      prefetch_hits(0),
+      prefetches_discarded(0),
+      prefetches_late(0),
+      prefetch_wasted_tokens(0),
+      line_rng(std::random_device{}()),
+      bank_lines_served(0),
+      bank_misses(0),
+      bank_refills(0),
+      bank_refill_failures(0),
+      messages_served(0),
+      message_fallbacks(0),
+      message_refills(0),
+      messages_generated(0),
+      prompt_messages({{"system", DIALOG_RULES}, {"system", ""}, {"user", ""}}) {
 }
 
 EmotionDialogService::~EmotionDialogService() {
@@ -63,6 +249,13 @@ void EmotionDialogService::register_npc(const String& npc_id, const Dictionary&
     std::string id = npc_id.utf8().get_data();
     NPCPersonality npc = NPCPersonality::from_dictionary(personality);
     npc.npc_id = id;
+    
+    //the game registers the npc again before every line, the persona only has to be
+    //rendered again when it actually changed
+    auto existing = npc_personalities.find(id);
+    if (existing == npc_personalities.end() || !same_persona(existing->second, npc)) {
+        persona_blocks.erase(id);
+    }
     npc_personalities[id] = npc;
 }
 
@@ -75,6 +268,7 @@ void EmotionDialogService::update_npc_trait(const String& npc_id, const String&
     
     NPCPersonality& personality = npc_personalities[id];
     std::string trait_name = trait.utf8().get_data();
+    persona_blocks.erase(id);
     
     //find and update trait
     for (auto& t : personality.traits) {
@@ -101,64 +295,554 @@ Dictionary EmotionDialogService::get_npc_personality(const String& npc_id) {
     return npc_personalities[id].to_dictionary();
 }
 
-std::string EmotionDialogService::build_dialog_prompt(const NPCPersonality& personality,
-                                                      const DialogContext& context,
-                                                      const std::string& player_input) {
-    std::ostringstream prompt;
-    
-    prompt << "You are roleplaying as an NPC in a Lovecraftian horror dungeon crawler game.\n\n";
-    prompt << "NPC Name: " << personality.npc_name << "\n";
-    prompt << "Archetype: " << personality.archetype << "\n";
-    prompt << "Current Mood: " << personality.current_mood << "\n";
-    prompt << "Sanity Level: " << (personality.sanity_level * 100) << "%\n\n";
-    
-    prompt << "Personality Traits:\n";
+std::string_view EmotionDialogService::get_dialog_rules() {
+    return DIALOG_RULES;
+}
+
+void EmotionDialogService::render_persona(const NPCPersonality& personality, std::string& out) {
+    out += "NPC Name: ";
+    out += personality.npc_name;
+    out += "\nArchetype: ";
+    out += personality.archetype;
+    out += "\nSanity Level: ";
+    append_number(out, personality.sanity_level * 100);
+    out += "%\n\nPersonality Traits:\n";
     for (const auto& trait : personality.traits) {
-        prompt << "- " << trait.trait_name << " (intensity: " << trait.intensity << "): " 
-               << trait.description << "\n";
+        out += "- ";
+        out += trait.trait_name;
+        out += " (intensity: ";
+        append_number(out, trait.intensity);
+        out += "): ";
+        out += trait.description;
+        out += '\n';
     }
-    
-    prompt << "\nContext:\n";
-    prompt << "Location: " << context.location << "\n";
+    if (!personality.background_info.empty()) {
+        out += "\nBackground:\n";
+        for (const auto& pair : personality.background_info) {
+            out += "- ";
+            out += pair.first;
+            out += ": ";
+            out += pair.second;
+            out += '\n';
+        }
+    }
+}
+
+void EmotionDialogService::render_context(const NPCPersonality& personality,
+                                          const DialogContext& context,
+                                          std::string_view player_input,
+                                          std::string& out) {
+    //mood changes with what the player does, so it lives here and not in the persona
+    out += "Current Mood: ";
+    out += personality.current_mood;
+    out += "\nLocation: ";
+    out += context.location;
+    out += '\n';
     if (!context.recent_player_action.empty()) {
-        prompt << "Player recently: " << context.recent_player_action << "\n";
+        out += "Player recently: ";
+        out += context.recent_player_action;
+        out += '\n';
     }
     if (context.first_encounter) {
-        prompt << "This is your first time meeting the player.\n";
+        out += "This is your first time meeting the player.\n";
     }
     
+    //both are bounded by the history length, so this part does not grow with the conversation
+    if (!context.conversation_summary.empty()) {
+        out += "\nEarlier in the conversation: ";
+        out += context.conversation_summary;
+        out += '\n';
+    }
     if (!context.previous_dialog_lines.empty()) {
-        prompt << "\nPrevious dialog:\n";
-        for (size_t i = 0; i < context.previous_dialog_lines.size() && i < 3; i++) {
-            prompt << "- " << context.previous_dialog_lines[i] << "\n";
+        out += "\nPrevious dialog:\n";
+        for (const auto& line : context.previous_dialog_lines) {
+            out += "- ";
+            out += line;
+            out += '\n';
         }
     }
     
-    prompt << "\nGenerate a single line of dialog that this NPC would say. ";
-    prompt << "Stay in character. Use atmosphere and horror elements. ";
-    prompt << "Keep response under 100 words. ";
-    prompt << "Do not include quotation marks or character name in the response.\n";
-    
     if (!player_input.empty()) {
-        prompt << "\nPlayer said: \"" << player_input << "\"\n";
+        out += "\nPlayer said: \"";
+        out.append(player_input.data(), player_input.size());
+        out += "\"\n";
     }
+    out += "\nWhat does the NPC say?";
+}
+
+const std::string& EmotionDialogService::get_persona_block(const std::string& npc_id, const NPCPersonality& personality) {
+    auto it = persona_blocks.find(npc_id);
+    if (it != persona_blocks.end()) {
+        prompt_stats.persona_reuses++;
+        return it->second;
+    }
+    prompt_stats.persona_renders++;
+    std::string& block = persona_blocks[npc_id];
+    render_persona(personality, block);
+    return block;
+}
+
+const std::vector<ChatMessage>& EmotionDialogService::build_dialog_messages(const std::string& npc_id,
+                                                                            const NPCPersonality& personality,
+                                                                            const DialogContext& context,
+                                                                            std::string_view player_input) {
+    //assign and clear keep each message's capacity, so after the first few lines
+    //rendering a prompt allocates nothing
+    prompt_messages[1].content.assign(get_persona_block(npc_id, personality));
+    std::string& volatile_part = prompt_messages[2].content;
+    volatile_part.clear();
+    render_context(personality, context, player_input, volatile_part);
+    return prompt_messages;
+}
+
+size_t DialogMemory::memory_bytes() const {
+    size_t bytes = sizeof(DialogMemory) + summary.capacity();
+    bytes += (turns.capacity() + evicted.capacity()) * sizeof(DialogTurn);
+    for (const auto& turn : turns) {
+        bytes += turn.player.capacity() + turn.npc.capacity();
+    }
+    for (const auto& turn : evicted) {
+        bytes += turn.player.capacity() + turn.npc.capacity();
+    }
+    return bytes;
+}
+
+void EmotionDialogService::record_turn(const std::string& npc_id, std::string_view player_input, const std::string& dialog) {
+    auto it = dialog_history.find(npc_id);
+    if (it == dialog_history.end()) {
+        it = dialog_history.emplace(npc_id, DialogMemory()).first;
+        it->second.turns.resize(history_length);
+        it->second.generation = next_history_generation++;
+    }
+    DialogMemory& memory = it->second;
+    
+    DialogTurn* slot;
+    if (memory.count == memory.turns.size()) {
+        //ring is full, the oldest turn moves out to be summarized and its slot takes the new one
+        memory.evicted.emplace_back();
+        std::swap(memory.evicted.back(), memory.turns[memory.head]);
+        slot = &memory.turns[memory.head];
+        memory.head = (memory.head + 1) % memory.turns.size();
+        
+        //summaries keep failing, forget the oldest rather than grow
+        if (memory.evicted.size() > memory.turns.size()) {
+            memory.evicted.erase(memory.evicted.begin());
+            if (memory.summarizing > 0) {
+                memory.summarizing--;
+            }
+        }
+    } else {
+        slot = &memory.turns[(memory.head + memory.count) % memory.turns.size()];
+        memory.count++;
+    }
+    assign_clamped(slot->player, player_input, MAX_TURN_BYTES);
+    assign_clamped(slot->npc, dialog, MAX_TURN_BYTES);
     
-    return prompt.str();
+    if (!memory.evicted.empty() && !memory.summary_pending) {
+        request_summary(npc_id, memory);
+    }
 }
 
-std::string EmotionDialogService::extract_dialog_from_response(const std::string& response_json) {
-    Dictionary response = JSONUtils::parse_json(response_json);
+void EmotionDialogService::request_summary(const std::string& npc_id, DialogMemory& memory) {
+    //the turns wait in evicted and the next eviction tries again
+    if (client->is_circuit_open(CHAT_COMPLETIONS_ENDPOINT)) {
+        return;
+    }
+    
+    std::string request = "Summary so far: ";
+    request += memory.summary.empty() ? "(none)" : memory.summary;
+    request += "\n\nNew lines:\n";
+    for (const auto& turn : memory.evicted) {
+        append_turn(request, turn);
+    }
+    std::vector<ChatMessage> messages = {{"system", SUMMARY_RULES}, {"user", std::move(request)}};
+    
+    memory.summary_pending = true;
+    memory.summarizing = memory.evicted.size();
+    
+    //nobody waits on it, the ring still has the latest turns until it lands
+    RequestOptions options;
+    options.priority = RequestPriority::BACKGROUND;
+    
+    uint64_t generation = memory.generation;
+    client->chat_completion(messages, "gpt-3.5-turbo", 0.3, 100,
+        [this, npc_id, generation](const HTTPResponse& response) {
+            auto it = dialog_history.find(npc_id);
+            if (it == dialog_history.end() || it->second.generation != generation) {
+                return;
+            }
+            DialogMemory& memory = it->second;
+            memory.summary_pending = false;
+            
+            if (!response.success || response.content.empty()) {
+                summary_failures++;
+                memory.summarizing = 0;
+                return;
+            }
+            
+            assign_clamped(memory.summary, response.content, MAX_SUMMARY_BYTES);
+            size_t summarized = std::min(memory.summarizing, memory.evicted.size());
+            memory.evicted.erase(memory.evicted.begin(), memory.evicted.begin() + summarized);
+            memory.summarizing = 0;
+            summaries_written++;
+            
+            //turns evicted while this one was in flight
+            if (!memory.evicted.empty()) {
+                request_summary(npc_id, memory);
+            }
+        },
+        options
+    );
+}
+
+void EmotionDialogService::fill_history(const std::string& npc_id, DialogContext& context) const {
+    auto it = dialog_history.find(npc_id);
+    if (it == dialog_history.end()) {
+        return;
+    }
+    const DialogMemory& memory = it->second;
+    context.conversation_summary = memory.summary;
+    for (size_t i = 0; i < memory.count; i++) {
+        const DialogTurn& turn = memory.turn(i);
+        if (!turn.player.empty()) {
+            context.previous_dialog_lines.push_back("Player: " + turn.player);
+        }
+        context.previous_dialog_lines.push_back("NPC: " + turn.npc);
+    }
+}
+
+DialogContext EmotionDialogService::read_context(const std::string& npc_id, const Dictionary& context_dict) const {
+    DialogContext context;
+    context.location = JSONUtils::get_string(context_dict, "location", "unknown");
+    context.recent_player_action = JSONUtils::get_string(context_dict, "recent_action", "");
+    context.first_encounter = JSONUtils::get_bool(context_dict, "first_encounter", false);
+    context.player_sanity = JSONUtils::get_int(context_dict, "player_sanity", 100);
+    fill_history(npc_id, context);
+    return context;
+}
+
+void EmotionDialogService::discard_speculative_line(std::map<std::string, SpeculativeLine>::iterator it) {
+    //a line still generating is charged when it lands and finds its entry gone
+    if (it->second.ready) {
+        prefetch_wasted_tokens += it->second.tokens;
+    }
+    speculative_lines.erase(it);
+}
+
+bool EmotionDialogService::take_speculative_line(const std::string& npc_id,
+                                                 const std::vector<ChatMessage>& messages,
+                                                 bool joining,
+                                                 std::string& line) {
+    auto it = speculative_lines.find(npc_id);
+    if (it == speculative_lines.end()) {
+        return false;
+    }
+    SpeculativeLine& speculative = it->second;
+    bool matches = speculative.persona == messages[1].content && speculative.context == messages[2].content;
+    
+    if (matches && speculative.ready) {
+        prefetch_hits++;
+        line = std::move(speculative.line);
+        speculative_lines.erase(it);
+        return true;
+    }
+    
+    //the caller's identical request coalesces with the prefetch, which the client promotes to
+    //the caller's class. its response goes to the caller, so it is neither held nor wasted
+    if (matches && joining) {
+        prefetches_late++;
+        joined_prefetches.insert(speculative.ticket);
+        speculative_lines.erase(it);
+        return false;
+    }
+    
+    //the caller sends a request of its own (streamed or sync), the prefetch lands unused
+    if (matches) {
+        prefetches_late++;
+    } else {
+        prefetches_discarded++;
+    }
+    discard_speculative_line(it);
+    return false;
+}
+
+void EmotionDialogService::prefetch_dialog(const String& npc_id, const Dictionary& context_dict) {
+    std::string id = npc_id.utf8().get_data();
+    
+    if (npc_personalities.find(id) == npc_personalities.end() ||
+        client->is_circuit_open(CHAT_COMPLETIONS_ENDPOINT)) {
+        return;
+    }
     
-    if (JSONUtils::has_key(response, "choices")) {
-        Array choices = JSONUtils::get_array(response, "choices");
-        if (choices.size() > 0) {
-            Dictionary first_choice = choices[0];
-            Dictionary message = JSONUtils::get_dict(first_choice, "message");
-            return JSONUtils::get_string(message, "content");
+    const NPCPersonality& personality = npc_personalities[id];
+    DialogContext context = read_context(id, context_dict);
+    const std::vector<ChatMessage>& messages = build_dialog_messages(id, personality, context, std::string_view());
+    
+    //the same greeting is already held or on its way
+    auto existing = speculative_lines.find(id);
+    if (existing != speculative_lines.end()) {
+        if (existing->second.persona == messages[1].content && existing->second.context == messages[2].content) {
+            return;
         }
+        prefetches_discarded++;
+        discard_speculative_line(existing);
     }
     
-    return "...";
+    SpeculativeLine& speculative = speculative_lines[id];
+    speculative.persona = messages[1].content;
+    speculative.context = messages[2].content;
+    speculative.ticket = next_speculative_ticket++;
+    prefetches_sent++;
+    
+    //same model and parameters as generate_dialog, so a hit reads like any other line
+    RequestOptions options;
+    options.priority = RequestPriority::BACKGROUND;
+    
+    uint64_t ticket = speculative.ticket;
+    client->chat_completion(messages, DIALOG_MODEL, DIALOG_TEMPERATURE, DIALOG_MAX_TOKENS,
+        [this, id, ticket](const HTTPResponse& response) {
+            int tokens = response.prompt_tokens + response.completion_tokens;
+            if (joined_prefetches.erase(ticket) > 0) {
+                return;
+            }
+            auto it = speculative_lines.find(id);
+            if (it == speculative_lines.end() || it->second.ticket != ticket) {
+                prefetch_wasted_tokens += tokens;
+                return;
+            }
+            if (!response.success) {
+                speculative_lines.erase(it);
+                return;
+            }
+            it->second.line = extract_dialog_from_response(response);
+            it->second.tokens = tokens;
+            it->second.ready = true;
+        },
+        options
+    );
+}
+
+Dictionary EmotionDialogService::get_prefetch_stats() const {
+    int64_t ready = 0;
+    for (const auto& pair : speculative_lines) {
+        if (pair.second.ready) {
+            ready++;
+        }
+    }
+    
+    Dictionary stats;
+    stats["prefetches"] = static_cast<int64_t>(prefetches_sent);
+    stats["hits"] = static_cast<int64_t>(prefetch_hits);
+    stats["discarded"] = static_cast<int64_t>(prefetches_discarded);
+    stats["late"] = static_cast<int64_t>(prefetches_late);
+    stats["hit_rate"] = prefetches_sent > 0 ? static_cast<double>(prefetch_hits) / prefetches_sent : 0.0;
+    stats["wasted_tokens"] = static_cast<int64_t>(prefetch_wasted_tokens);
+    stats["ready"] = ready;
+    return stats;
+}
+
+bool EmotionDialogService::parse_line_kind(std::string_view name, DialogLineKind& kind) {
+    for (int i = 0; i < DIALOG_LINE_KIND_COUNT; i++) {
+        std::string_view candidate = LINE_KIND_NAMES[i];
+        if (name.size() != candidate.size()) {
+            continue;
+        }
+        bool same = true;
+        for (size_t c = 0; c < name.size() && same; c++) {
+            same = std::tolower(static_cast<unsigned char>(name[c])) == candidate[c];
+        }
+        if (same) {
+            kind = static_cast<DialogLineKind>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* EmotionDialogService::location_bucket(std::string_view location) {
+    std::string lowered(location);
+    for (auto& c : lowered) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    for (const auto& bucket : LOCATION_BUCKETS) {
+        for (const char* const* keyword = bucket.keywords; *keyword; keyword++) {
+            if (lowered.find(*keyword) != std::string::npos) {
+                return bucket.name;
+            }
+        }
+    }
+    return DEFAULT_LOCATION_BUCKET;
+}
+
+void EmotionDialogService::add_bank_lines(LineBank& bank, const std::string& content) {
+    std::string_view rest = content;
+    while (!rest.empty()) {
+        size_t end = rest.find('\n');
+        std::string_view line = trim(rest.substr(0, end));
+        rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+        
+        //"GREETING: text", tolerating list markers and quotes around the text
+        while (!line.empty() && (line.front() == '-' || line.front() == '*')) {
+            line = trim(line.substr(1));
+        }
+        size_t colon = line.find(':');
+        DialogLineKind kind;
+        if (colon == std::string_view::npos || !parse_line_kind(trim(line.substr(0, colon)), kind)) {
+            continue;
+        }
+        std::string_view text = trim(line.substr(colon + 1));
+        if (text.size() >= 2 && text.front() == '"' && text.back() == '"') {
+            text = trim(text.substr(1, text.size() - 2));
+        }
+        if (text.empty()) {
+            continue;
+        }
+        
+        LineBag& bag = bank.bags[static_cast<int>(kind)];
+        if (bag.lines.size() >= BANK_MAX_LINES) {
+            //served lines make room first
+            if (bag.next == 0) {
+                continue;
+            }
+            bag.lines.erase(bag.lines.begin(), bag.lines.begin() + bag.next);
+            bag.next = 0;
+        }
+        std::string clamped;
+        assign_clamped(clamped, text, MAX_BANK_LINE_BYTES);
+        if (std::find(bag.lines.begin(), bag.lines.end(), clamped) == bag.lines.end()) {
+            bag.lines.push_back(std::move(clamped));
+        }
+    }
+    
+    //new lines mix in with the ones not served yet
+    for (auto& bag : bank.bags) {
+        std::shuffle(bag.lines.begin() + bag.next, bag.lines.end(), line_rng);
+    }
+}
+
+void EmotionDialogService::request_bank_lines(const std::string& npc_id, const std::string& mood, const char* bucket) {
+    auto npc = npc_personalities.find(npc_id);
+    if (npc == npc_personalities.end() || client->is_circuit_open(CHAT_COMPLETIONS_ENDPOINT)) {
+        return;
+    }
+    std::string key = bank_key(npc_id, mood, bucket);
+    LineBank& bank = line_banks[key];
+    if (bank.refill_pending) {
+        return;
+    }
+    
+    //same persona block as live dialog, so the provider can reuse the cached prefix
+    std::string request = "Current Mood: ";
+    request += mood;
+    request += "\nLocation: ";
+    request += bucket;
+    request += "\n\nWrite ";
+    request += std::to_string(BANK_LINES_PER_KIND);
+    request += " lines of each kind.";
+    std::vector<ChatMessage> messages = {
+        {"system", BANK_RULES},
+        {"system", get_persona_block(npc_id, npc->second)},
+        {"user", std::move(request)},
+    };
+    
+    bank.refill_pending = true;
+    bank_refills++;
+    
+    RequestOptions options;
+    options.priority = RequestPriority::BACKGROUND;
+    //a refill wants new lines, not the batch it got last time
+    options.bypass_cache = true;
+    
+    client->chat_completion(messages, "gpt-3.5-turbo", 1.0, 40 * BANK_LINES_PER_KIND * DIALOG_LINE_KIND_COUNT,
+        [this, key](const HTTPResponse& response) {
+            LineBank& bank = line_banks[key];
+            bank.refill_pending = false;
+            if (!response.success || response.content.empty()) {
+                bank_refill_failures++;
+                return;
+            }
+            add_bank_lines(bank, response.content);
+        },
+        options
+    );
+}
+
+void EmotionDialogService::fill_line_bank(const String& npc_id, const String& location) {
+    std::string id = npc_id.utf8().get_data();
+    auto npc = npc_personalities.find(id);
+    if (npc == npc_personalities.end()) {
+        return;
+    }
+    CharString place = location.utf8();
+    request_bank_lines(id, npc->second.current_mood, location_bucket(std::string_view(place.get_data(), place.length())));
+}
+
+bool EmotionDialogService::get_bank_line(const String& npc_id, DialogLineKind kind, const String& location, std::string& line) {
+    std::string id = npc_id.utf8().get_data();
+    auto npc = npc_personalities.find(id);
+    if (npc == npc_personalities.end()) {
+        return false;
+    }
+    const std::string& mood = npc->second.current_mood;
+    CharString place = location.utf8();
+    const char* bucket = location_bucket(std::string_view(place.get_data(), place.length()));
+    
+    auto it = line_banks.find(bank_key(id, mood, bucket));
+    if (it == line_banks.end() || it->second.bags[static_cast<int>(kind)].lines.empty()) {
+        bank_misses++;
+        request_bank_lines(id, mood, bucket);
+        return false;
+    }
+    LineBank& bank = it->second;
+    LineBag& bag = bank.bags[static_cast<int>(kind)];
+    
+    //every line was served, start a new round without opening on the line just said
+    //the line just said is the last one, it goes anywhere but first
+    if (bag.remaining() == 0) {
+        size_t count = bag.lines.size();
+        std::shuffle(bag.lines.begin(), bag.lines.end() - 1, line_rng);
+        if (count > 1) {
+            size_t slot = 1 + static_cast<size_t>(line_rng() % (count - 1));
+            std::swap(bag.lines[slot], bag.lines[count - 1]);
+        }
+        bag.next = 0;
+    }
+    line = bag.lines[bag.next++];
+    bank_lines_served++;
+    
+    if (bag.remaining() < BANK_LOW_WATER) {
+        request_bank_lines(id, mood, bucket);
+    }
+    return true;
+}
+
+Dictionary EmotionDialogService::get_line_bank_stats() const {
+    int64_t lines = 0;
+    int64_t unserved = 0;
+    for (const auto& pair : line_banks) {
+        for (const auto& bag : pair.second.bags) {
+            lines += static_cast<int64_t>(bag.lines.size());
+            unserved += static_cast<int64_t>(bag.remaining());
+        }
+    }
+    
+    Dictionary stats;
+    stats["banks"] = static_cast<int64_t>(line_banks.size());
+    stats["lines"] = lines;
+    stats["unserved"] = unserved;
+    stats["served"] = static_cast<int64_t>(bank_lines_served);
+    stats["misses"] = static_cast<int64_t>(bank_misses);
+    stats["refills"] = static_cast<int64_t>(bank_refills);
+    stats["refill_failures"] = static_cast<int64_t>(bank_refill_failures);
+    return stats;
+}
+
+std::string EmotionDialogService::extract_dialog_from_response(const HTTPResponse& response) {
+    //content is pulled out of the json on the io worker
+    if (response.content.empty()) {
+        return "...";
+    }
+    return response.content;
 }
 
 void EmotionDialogService::update_npc_mood(const std::string& npc_id, const std::string& player_action) {
@@ -182,7 +866,8 @@ void EmotionDialogService::generate_dialog(const String& npc_id,
                                            const String& player_input,
                                            const Dictionary& context_dict,
                                            std::function<void(const std::string&)> on_success,
-                                           std::function<void(const std::string&)> on_error) {
+                                           std::function<void(const std::string&)> on_error,
+                                           std::function<void(const std::string&)> on_chunk) {
     std::string id = npc_id.utf8().get_data();
     
     if (npc_personalities.find(id) == npc_personalities.end()) {
@@ -191,37 +876,48 @@ void EmotionDialogService::generate_dialog(const String& npc_id,
     }
     
     const NPCPersonality& personality = npc_personalities[id];
+    DialogContext context = read_context(id, context_dict);
     
-    DialogContext context;
-    context.location = JSONUtils::get_string(context_dict, "location", "unknown");
-    context.recent_player_action = JSONUtils::get_string(context_dict, "recent_action", "");
-    context.first_encounter = JSONUtils::get_bool(context_dict, "first_encounter", false);
-    context.player_sanity = JSONUtils::get_int(context_dict, "player_sanity", 100);
+    CharString input = player_input.utf8();
+    std::string_view input_text(input.get_data(), input.length());
+    const std::vector<ChatMessage>& messages = build_dialog_messages(id, personality, context, input_text);
+    
+    //prefetched while the player walked up, no request at all. a streamed request has a
+    //different body, so only a non-streamed one can join a prefetch still in flight
+    std::string prefetched;
+    if (take_speculative_line(id, messages, !on_chunk, prefetched)) {
+        record_turn(id, input_text, prefetched);
+        if (on_chunk) {
+            on_chunk(prefetched);
+        }
+        on_success(prefetched);
+        return;
+    }
     
-    std::string prompt = build_dialog_prompt(personality, context, player_input.utf8().get_data());
+    //upstream is down, let the caller show its fallback line right away
+    if (client->is_circuit_open(CHAT_COMPLETIONS_ENDPOINT)) {
+        on_error("Dialog service unavailable");
+        return;
+    }
     
-    Array messages;
-    Dictionary user_message;
-    user_message[Variant("role")] = Variant("user");
-    user_message[Variant("content")] = Variant(String(prompt.c_str()));
-    messages.append(user_message);
+    RequestOptions options;
+    options.priority = RequestPriority::INTERACTIVE;
+    if (on_chunk) {
+        options.stream = true;
+        options.on_chunk = on_chunk;
+    }
     
-    client->chat_completion(messages, "gpt-3.5-turbo", 0.9, 150,
-        [this, id, on_success, on_error](const HTTPResponse& response) {
+    client->chat_completion(messages, DIALOG_MODEL, DIALOG_TEMPERATURE, DIALOG_MAX_TOKENS,
+        [this, id, player_text = std::string(input_text), on_success, on_error](const HTTPResponse& response) {
             if (response.success) {
-                std::string dialog = extract_dialog_from_response(response.body);
-                
-                // Store in history
-                if (dialog_history.find(id) == dialog_history.end()) {
-                    dialog_history[id] = std::vector<std::string>();
-                }
-                dialog_history[id].push_back(dialog);
-                
+                std::string dialog = extract_dialog_from_response(response);
+                record_turn(id, player_text, dialog);
                 on_success(dialog);
             } else {
                 on_error(response.error_message);
             }
-        }
+        },
+        options
     );
 }
 
@@ -235,27 +931,27 @@ std::string EmotionDialogService::generate_dialog_sync(const String& npc_id,
     }
     
     const NPCPersonality& personality = npc_personalities[id];
+    DialogContext context = read_context(id, context_dict);
     
-    DialogContext context;
-    context.location = JSONUtils::get_string(context_dict, "location", "unknown");
-    context.recent_player_action = JSONUtils::get_string(context_dict, "recent_action", "");
-    context.first_encounter = JSONUtils::get_bool(context_dict, "first_encounter", false);
+    CharString input = player_input.utf8();
+    std::string_view input_text(input.get_data(), input.length());
+    const std::vector<ChatMessage>& messages = build_dialog_messages(id, personality, context, input_text);
     
-    std::string prompt = build_dialog_prompt(personality, context, player_input.utf8().get_data());
-    
-    Array messages;
-    Dictionary user_message;
-    user_message[Variant("role")] = Variant("user");
-    user_message[Variant("content")] = Variant(String(prompt.c_str()));
-    messages.append(user_message);
+    std::string prefetched;
+    if (take_speculative_line(id, messages, false, prefetched)) {
+        record_turn(id, input_text, prefetched);
+        return prefetched;
+    }
     
-    HTTPResponse response = client->chat_completion_sync(messages, "gpt-3.5-turbo", 0.9, 150);
+    HTTPResponse response = client->chat_completion_sync(messages, DIALOG_MODEL, DIALOG_TEMPERATURE, DIALOG_MAX_TOKENS);
     
     if (!response.success) {
         return "...";
     }
     
-    return extract_dialog_from_response(response.body);
+    std::string dialog = extract_dialog_from_response(response);
+    record_turn(id, input_text, dialog);
+    return dialog;
 }
 
 void EmotionDialogService::update_relationship(const String& npc_id, int delta) {
@@ -294,9 +990,11 @@ Array EmotionDialogService::get_dialog_history(const String& npc_id) {
     Array result;
     std::string id = npc_id.utf8().get_data();
     
-    if (dialog_history.find(id) != dialog_history.end()) {
-        for (const auto& line : dialog_history[id]) {
-            result.append(String(line.c_str()));
+    auto it = dialog_history.find(id);
+    if (it != dialog_history.end()) {
+        for (size_t i = 0; i < it->second.count; i++) {
+            const std::string& line = it->second.turn(i).npc;
+            result.append(String::utf8(line.data(), line.size()));
         }
     }
     
@@ -308,42 +1006,210 @@ void EmotionDialogService::clear_dialog_history(const String& npc_id) {
     dialog_history.erase(id);
 }
 
-void EmotionDialogService::generate_environmental_message(const Dictionary& context,
-                                                         std::function<void(const std::string&)> callback) {
-    std::string location = JSONUtils::get_string(context, "location", "dungeon room");
-    int danger_level = JSONUtils::get_int(context, "danger_level", 1);
-    
-    std::ostringstream prompt;
-    prompt << "Generate a short, cryptic environmental message for a Lovecraftian horror game. ";
-    prompt << "Location: " << location << ". ";
-    prompt << "This might be scrawled on a wall, carved into stone, or written in fungal growth. ";
-    prompt << "Make it unsettling and atmospheric. Maximum 20 words.";
-    
-    Array messages;
-    Dictionary user_message;
-    user_message[Variant("role")] = Variant("user");
-    user_message[Variant("content")] = Variant(String(prompt.str().c_str()));
-    messages.append(user_message);
-    
-    client->chat_completion(messages, "gpt-3.5-turbo", 1.0, 50,
-        [callback](const HTTPResponse& response) {
-            if (response.success) {
-                Dictionary resp_dict = JSONUtils::parse_json(response.body);
-                if (JSONUtils::has_key(resp_dict, "choices")) {
-                    Array choices = JSONUtils::get_array(resp_dict, "choices");
-                    if (choices.size() > 0) {
-                        Dictionary first_choice = choices[0];
-                        Dictionary message = JSONUtils::get_dict(first_choice, "message");
-                        std::string content = JSONUtils::get_string(message, "content");
-                        callback(content);
-                        return;
-                    }
+void EmotionDialogService::set_history_length(int turns) {
+    size_t length = turns > 1 ? static_cast<size_t>(turns) : 1;
+    if (length == history_length) {
+        return;
+    }
+    history_length = length;
+    
+    //rebuild each ring oldest first, turns that no longer fit go to the summary
+    for (auto& pair : dialog_history) {
+        DialogMemory& memory = pair.second;
+        std::vector<DialogTurn> ordered;
+        ordered.reserve(memory.count);
+        for (size_t i = 0; i < memory.count; i++) {
+            ordered.push_back(std::move(memory.turns[(memory.head + i) % memory.turns.size()]));
+        }
+        size_t dropped = ordered.size() > length ? ordered.size() - length : 0;
+        for (size_t i = 0; i < dropped; i++) {
+            memory.evicted.push_back(std::move(ordered[i]));
+        }
+        if (memory.evicted.size() > length) {
+            size_t excess = memory.evicted.size() - length;
+            memory.evicted.erase(memory.evicted.begin(), memory.evicted.begin() + excess);
+            memory.summarizing = memory.summarizing > excess ? memory.summarizing - excess : 0;
+        }
+        
+        memory.turns.clear();
+        memory.turns.shrink_to_fit();
+        memory.turns.resize(length);
+        memory.count = ordered.size() - dropped;
+        memory.head = 0;
+        for (size_t i = 0; i < memory.count; i++) {
+            memory.turns[i] = std::move(ordered[dropped + i]);
+        }
+        
+        if (!memory.evicted.empty() && !memory.summary_pending) {
+            request_summary(pair.first, memory);
+        }
+    }
+}
+
+int EmotionDialogService::get_history_length() const {
+    return static_cast<int>(history_length);
+}
+
+Dictionary EmotionDialogService::get_history_memory_stats() const {
+    Array npcs;
+    size_t used = 0;
+    for (const auto& pair : dialog_history) {
+        const DialogMemory& memory = pair.second;
+        Dictionary npc;
+        npc["npc_id"] = String(pair.first.c_str());
+        npc["turns"] = static_cast<int64_t>(memory.count);
+        npc["pending"] = static_cast<int64_t>(memory.evicted.size());
+        npc["summary_bytes"] = static_cast<int64_t>(memory.summary.size());
+        npc["bytes"] = static_cast<int64_t>(memory.memory_bytes());
+        npcs.append(npc);
+        used += memory.memory_bytes();
+    }
+    
+    Dictionary stats;
+    stats["history_length"] = static_cast<int64_t>(history_length);
+    stats["used"] = static_cast<int64_t>(used);
+    stats["summaries"] = static_cast<int64_t>(summaries_written);
+    stats["summary_failures"] = static_cast<int64_t>(summary_failures);
+    stats["npcs"] = npcs;
+    return stats;
+}
+
+DialogPromptStats EmotionDialogService::get_prompt_stats() const {
+    DialogPromptStats stats = prompt_stats;
+    stats.cached_personas = persona_blocks.size();
+    return stats;
+}
+
+bool MessageRing::push(std::string_view message) {
+    if (slots.empty()) {
+        slots.resize(MESSAGE_RING_CAPACITY);
+    }
+    if (count == slots.size()) {
+        return false;
+    }
+    assign_clamped(slots[(head + count) % slots.size()], message, MAX_MESSAGE_BYTES);
+    count++;
+    return true;
+}
+
+bool MessageRing::pop(std::string& message) {
+    if (count == 0) {
+        return false;
+    }
+    message.swap(slots[head]);
+    head = (head + 1) % slots.size();
+    count--;
+    return true;
+}
+
+void EmotionDialogService::request_messages(const std::string& key, const char* bucket, int danger_level) {
+    MessageRing& ring = message_rings[key];
+    if (ring.refill_pending || client->is_circuit_open(CHAT_COMPLETIONS_ENDPOINT)) {
+        return;
+    }
+    
+    std::string request = "Location: ";
+    request += bucket;
+    request += "\nDanger level: ";
+    request += std::to_string(danger_level);
+    request += " of ";
+    request += std::to_string(MAX_DANGER_LEVEL);
+    request += ", higher is more menacing.\n\nWrite ";
+    request += std::to_string(MESSAGE_BATCH);
+    request += " messages.";
+    std::vector<ChatMessage> messages = {{"system", MESSAGE_RULES}, {"user", std::move(request)}};
+    
+    ring.refill_pending = true;
+    message_refills++;
+    
+    //nobody waits on a refill, and a cached batch would only repeat the last one
+    RequestOptions options;
+    options.priority = RequestPriority::BACKGROUND;
+    options.bypass_cache = true;
+    
+    client->chat_completion(messages, "gpt-3.5-turbo", 1.0, 35 * MESSAGE_BATCH,
+        [this, key](const HTTPResponse& response) {
+            MessageRing& ring = message_rings[key];
+            ring.refill_pending = false;
+            if (!response.success) {
+                return;
+            }
+            
+            std::string_view rest = response.content;
+            while (!rest.empty()) {
+                size_t end = rest.find('\n');
+                std::string_view message = trim(rest.substr(0, end));
+                rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+                
+                //list markers and numbering the model added anyway
+                while (!message.empty() && (message.front() == '-' || message.front() == '*')) {
+                    message = trim(message.substr(1));
+                }
+                size_t digits = 0;
+                while (digits < message.size() && std::isdigit(static_cast<unsigned char>(message[digits]))) {
+                    digits++;
+                }
+                if (digits > 0 && digits < message.size() && (message[digits] == '.' || message[digits] == ')')) {
+                    message = trim(message.substr(digits + 1));
+                }
+                if (message.size() >= 2 && message.front() == '"' && message.back() == '"') {
+                    message = trim(message.substr(1, message.size() - 2));
+                }
+                if (message.empty()) {
+                    continue;
+                }
+                if (!ring.push(message)) {
+                    break;
                 }
+                messages_generated++;
             }
-            callback("The walls whisper secrets best left forgotten...");
-        }
+        },
+        options
     );
 }
 
+void EmotionDialogService::generate_environmental_message(const Dictionary& context,
+                                                         std::function<void(const std::string&)> callback) {
+    MessageTag tag = read_message_tag(context);
+    MessageRing& ring = message_rings[tag.key];
+    
+    //room entry never waits on the network, an empty pool gets the canned line this time
+    std::string message;
+    if (ring.pop(message)) {
+        messages_served++;
+    } else {
+        message_fallbacks++;
+        message = FALLBACK_MESSAGE;
+    }
+    
+    if (ring.count < MESSAGE_LOW_WATER) {
+        request_messages(tag.key, tag.bucket, tag.danger_level);
+    }
+    callback(message);
+}
+
+void EmotionDialogService::fill_environmental_messages(const Dictionary& context) {
+    MessageTag tag = read_message_tag(context);
+    if (message_rings[tag.key].count < MESSAGE_LOW_WATER) {
+        request_messages(tag.key, tag.bucket, tag.danger_level);
+    }
+}
+
+Dictionary EmotionDialogService::get_environmental_message_stats() const {
+    int64_t queued = 0;
+    for (const auto& pair : message_rings) {
+        queued += static_cast<int64_t>(pair.second.count);
+    }
+    
+    Dictionary stats;
+    stats["rings"] = static_cast<int64_t>(message_rings.size());
+    stats["queued"] = queued;
+    stats["served"] = static_cast<int64_t>(messages_served);
+    stats["fallbacks"] = static_cast<int64_t>(message_fallbacks);
+    stats["refills"] = static_cast<int64_t>(message_refills);
+    stats["generated"] = static_cast<int64_t>(messages_generated);
+    return stats;
+}
+
 } // namespace necronomicore
 
@@ -1,73 +1,875 @@
 #include "http_client.h"
 #include <iostream>
+#include <mutex>
 
 #ifdef _WIN32
 #include <windows.h>
 #include <winhttp.h>
 #pragma comment(lib, "winhttp.lib")
 
+// One session for the client's lifetime; WinHTTP pools the underlying
+// keep-alive sockets per session, so reusing it is what enables reuse.
 struct PlatformData {
+    std::mutex mutex;
     HINTERNET hSession;
-    HINTERNET hConnect;
+    std::map<std::wstring, HINTERNET> connections; // "host:port" -> connect handle
+    necronomicore::HTTPClientStats stats;
 };
+
+namespace {
+
+// Splits WinHTTP's raw CRLF header block into lowercased keys, matching the
+// POSIX reader so callers can look up e.g. "x-ratelimit-remaining-requests"
+void parse_raw_headers(const std::wstring& raw, std::map<std::string, std::string>& out) {
+    int size = WideCharToMultiByte(CP_UTF8, 0, raw.c_str(), static_cast<int>(raw.size()), NULL, 0, NULL, NULL);
+    std::string text(size, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, raw.c_str(), static_cast<int>(raw.size()), &text[0], size, NULL, NULL);
+
+    size_t line_start = text.find("\r\n"); // skip the status line
+    while (line_start != std::string::npos) {
+        line_start += 2;
+        size_t line_end = text.find("\r\n", line_start);
+        std::string line = text.substr(line_start, line_end == std::string::npos ? std::string::npos : line_end - line_start);
+        line_start = line_end;
+
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, colon);
+        for (char& c : key) {
+            c = static_cast<char>(::tolower(static_cast<unsigned char>(c)));
+        }
+        size_t value_start = line.find_first_not_of(" \t", colon + 1);
+        std::string value = value_start == std::string::npos ? "" : line.substr(value_start);
+
+        auto existing = out.find(key);
+        if (existing != out.end()) {
+            existing->second += ", " + value;
+        } else {
+            out[key] = value;
+        }
+    }
+}
+
+} // namespace
+#else
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cctype>
+#include <cstdint>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+using PoolClock = std::chrono::steady_clock;
+
+struct PooledConnection {
+    int fd = -1;
+    SSL* ssl = nullptr;
+    PoolClock::time_point last_used;
+};
+
+struct HostPool {
+    std::vector<PooledConnection> idle;
+    SSL_SESSION* tls_session = nullptr; // last resumable session, for abbreviated handshakes
+};
+
+struct PlatformData {
+    std::mutex mutex;
+    SSL_CTX* ssl_ctx = nullptr;
+    std::map<std::string, HostPool> hosts; // "scheme://host:port" -> pool
+    int max_idle_per_host = 4;
+    int idle_timeout_seconds = 60;
+    necronomicore::HTTPClientStats stats;
+};
+
+namespace {
+
+struct ParsedURL {
+    bool secure = false;
+    std::string host;
+    std::string port;
+    std::string path;
+};
+
+bool parse_url(const std::string& url, ParsedURL& out) {
+    size_t host_start;
+    if (url.compare(0, 8, "https://") == 0) {
+        out.secure = true;
+        host_start = 8;
+    } else if (url.compare(0, 7, "http://") == 0) {
+        out.secure = false;
+        host_start = 7;
+    } else {
+        return false;
+    }
+
+    size_t path_start = url.find('/', host_start);
+    std::string authority = url.substr(host_start, path_start == std::string::npos ? std::string::npos : path_start - host_start);
+    out.path = path_start == std::string::npos ? "/" : url.substr(path_start);
+
+    size_t port_sep = std::string::npos;
+    if (!authority.empty() && authority[0] == '[') {
+        // IPv6 literal: [::1]:8080
+        size_t close = authority.find(']');
+        if (close == std::string::npos) {
+            return false;
+        }
+        out.host = authority.substr(1, close - 1);
+        if (close + 1 < authority.size() && authority[close + 1] == ':') {
+            port_sep = close + 1;
+        }
+    } else {
+        port_sep = authority.rfind(':');
+        out.host = authority.substr(0, port_sep);
+    }
+
+    if (port_sep != std::string::npos) {
+        out.port = authority.substr(port_sep + 1);
+    } else {
+        out.port = out.secure ? "443" : "80";
+    }
+
+    return !out.host.empty() && !out.port.empty();
+}
+
+std::string to_lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(::tolower(c)); });
+    return value;
+}
+
+std::string trim(const std::string& value) {
+    size_t start = value.find_first_not_of(" \t");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = value.find_last_not_of(" \t\r");
+    return value.substr(start, end - start + 1);
+}
+
+// OpenSSL writes through write(2), which raises SIGPIPE when the peer has
+// already closed a pooled connection. Block it for the calling thread and
+// swallow anything raised while blocked.
+class SigpipeGuard {
+public:
+    SigpipeGuard() {
+#ifndef SO_NOSIGPIPE
+        sigemptyset(&pipe_mask);
+        sigaddset(&pipe_mask, SIGPIPE);
+        sigset_t pending;
+        sigpending(&pending);
+        was_pending = sigismember(&pending, SIGPIPE) == 1;
+        pthread_sigmask(SIG_BLOCK, &pipe_mask, &old_mask);
+#endif
+    }
+
+    ~SigpipeGuard() {
+#ifndef SO_NOSIGPIPE
+        if (!was_pending) {
+            sigset_t pending;
+            sigpending(&pending);
+            if (sigismember(&pending, SIGPIPE) == 1) {
+                timespec no_wait = {0, 0};
+                sigtimedwait(&pipe_mask, nullptr, &no_wait);
+            }
+        }
+        pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+#endif
+    }
+
+private:
+#ifndef SO_NOSIGPIPE
+    sigset_t pipe_mask;
+    sigset_t old_mask;
+    bool was_pending = false;
+#endif
+};
+
+bool connect_with_timeout(int fd, const sockaddr* addr, socklen_t addr_len, int timeout_seconds) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    int rc = connect(fd, addr, addr_len);
+    if (rc < 0 && errno == EINPROGRESS) {
+        pollfd pfd = {fd, POLLOUT, 0};
+        rc = poll(&pfd, 1, timeout_seconds * 1000);
+        if (rc == 1) {
+            int err = 0;
+            socklen_t err_len = sizeof(err);
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &err_len);
+            rc = err == 0 ? 0 : -1;
+        } else {
+            rc = -1;
+        }
+    }
+
+    fcntl(fd, F_SETFL, flags);
+    return rc == 0;
+}
+
+int open_socket(const ParsedURL& target, int timeout_seconds, std::string& error) {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* results = nullptr;
+    if (getaddrinfo(target.host.c_str(), target.port.c_str(), &hints, &results) != 0) {
+        error = "Failed to resolve host";
+        return -1;
+    }
+
+    int fd = -1;
+    for (addrinfo* ai = results; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect_with_timeout(fd, ai->ai_addr, ai->ai_addrlen, timeout_seconds)) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(results);
+
+    if (fd < 0) {
+        error = "Failed to connect to server";
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+    timeval tv = {};
+    tv.tv_sec = timeout_seconds;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    return fd;
+}
+
+void close_connection(PooledConnection& conn, bool clean) {
+    if (conn.ssl) {
+        // Mark a clean close as shut down so OpenSSL keeps the session resumable
+        if (clean) {
+            SSL_set_shutdown(conn.ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        }
+        SSL_free(conn.ssl);
+    }
+    if (conn.fd >= 0) {
+        close(conn.fd);
+    }
+    conn = PooledConnection();
+}
+
+bool conn_write(PooledConnection& conn, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n;
+        if (conn.ssl) {
+            int chunk = static_cast<int>(std::min<size_t>(len, 1 << 30));
+            n = SSL_write(conn.ssl, data, chunk);
+            if (n <= 0) {
+                return false;
+            }
+        } else {
+            n = send(conn.fd, data, len, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Returns bytes read, 0 on orderly close, -1 on error or timeout
+ssize_t conn_read(PooledConnection& conn, char* buffer, size_t capacity) {
+    if (conn.ssl) {
+        int n = SSL_read(conn.ssl, buffer, static_cast<int>(capacity));
+        if (n > 0) {
+            return n;
+        }
+        return SSL_get_error(conn.ssl, n) == SSL_ERROR_ZERO_RETURN ? 0 : -1;
+    }
+    for (;;) {
+        ssize_t n = recv(conn.fd, buffer, capacity, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return n;
+    }
+}
+
+// A pooled connection is unusable once the server has closed its end
+bool connection_alive(const PooledConnection& conn) {
+    char probe;
+    ssize_t n = recv(conn.fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0) {
+        return false;
+    }
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    // Unread bytes on an idle plain connection mean the stream is out of sync;
+    // on TLS they are usually a late session ticket, which SSL_read consumes.
+    return conn.ssl != nullptr;
+}
+
+class ResponseReader {
+public:
+    explicit ResponseReader(PooledConnection& connection) : conn(connection) {}
+
+    bool received_anything() const { return received; }
+
+    bool read_line(std::string& line) {
+        for (;;) {
+            size_t eol = buffer.find("\r\n", pos);
+            if (eol != std::string::npos) {
+                line.assign(buffer, pos, eol - pos);
+                pos = eol + 2;
+                return true;
+            }
+            if (!fill()) {
+                return false;
+            }
+        }
+    }
+
+    // Body bytes are passed on as they arrive rather than after the whole span
+    template <typename Sink>
+    bool read_exact(size_t count, const Sink& sink) {
+        while (count > 0) {
+            if (pos == buffer.size() && !fill()) {
+                return false;
+            }
+            size_t take = std::min(count, buffer.size() - pos);
+            sink(buffer.data() + pos, take);
+            pos += take;
+            count -= take;
+        }
+        return true;
+    }
+
+    template <typename Sink>
+    void read_to_end(const Sink& sink) {
+        do {
+            if (pos < buffer.size()) {
+                sink(buffer.data() + pos, buffer.size() - pos);
+            }
+            pos = buffer.size();
+        } while (fill());
+    }
+
+private:
+    PooledConnection& conn;
+    std::string buffer;
+    size_t pos = 0;
+    bool received = false;
+
+    bool fill() {
+        if (pos > 0 && pos == buffer.size()) {
+            buffer.clear();
+            pos = 0;
+        }
+        char chunk[16384];
+        ssize_t n = conn_read(conn, chunk, sizeof(chunk));
+        if (n <= 0) {
+            return false;
+        }
+        received = true;
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+};
+
+// Hex size, optionally followed by ";extensions"
+bool parse_chunk_size(const std::string& line, size_t& size) {
+    const char* begin = line.c_str();
+    if (!std::isxdigit(static_cast<unsigned char>(begin[0]))) {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long value = std::strtoull(begin, &end, 16);
+    if (errno == ERANGE || value > SIZE_MAX) {
+        return false;
+    }
+    while (*end == ' ' || *end == '\t') {
+        end++;
+    }
+    if (*end != '\0' && *end != ';') {
+        return false;
+    }
+    size = static_cast<size_t>(value);
+    return true;
+}
+
+// Decimal digits only: no sign, no trailing junk, no overflow
+bool parse_content_length(const std::string& value, size_t& length) {
+    if (value.empty()) {
+        return false;
+    }
+    uint64_t result = 0;
+    for (char c : value) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        uint64_t digit = static_cast<uint64_t>(c - '0');
+        if (result > (SIZE_MAX - digit) / 10) {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+    length = static_cast<size_t>(result);
+    return true;
+}
+
+// Upfront reservation cap, larger bodies grow as they arrive
+const size_t MAX_BODY_RESERVE = 1024 * 1024;
+
+enum class ReadResult {
+    OK,
+    NO_RESPONSE, // nothing came back; a reused connection may simply have gone stale
+    FAILED
+};
+
+ReadResult read_response(PooledConnection& conn, const std::string& method,
+                         const necronomicore::HTTPClient::BodyCallback* on_data,
+                         necronomicore::SimpleHTTPResponse& response, bool& keep_alive) {
+    ResponseReader reader(conn);
+    std::string line;
+    bool http10 = false;
+
+    // Skip interim 1xx responses
+    do {
+        if (!reader.read_line(line)) {
+            return reader.received_anything() ? ReadResult::FAILED : ReadResult::NO_RESPONSE;
+        }
+        if (line.size() < 12 || line.compare(0, 5, "HTTP/") != 0) {
+            return ReadResult::FAILED;
+        }
+        http10 = line.compare(0, 8, "HTTP/1.0") == 0;
+        response.status_code = std::atoi(line.c_str() + 9);
+        response.headers.clear();
+
+        while (reader.read_line(line) && !line.empty()) {
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            std::string key = to_lower(trim(line.substr(0, colon)));
+            std::string value = trim(line.substr(colon + 1));
+            auto existing = response.headers.find(key);
+            if (existing != response.headers.end()) {
+                existing->second += ", " + value;
+            } else {
+                response.headers[key] = value;
+            }
+        }
+        if (!line.empty()) {
+            return ReadResult::FAILED;
+        }
+    } while (response.status_code >= 100 && response.status_code < 200);
+
+    auto connection = response.headers.find("connection");
+    std::string connection_value = connection != response.headers.end() ? to_lower(connection->second) : "";
+    keep_alive = http10 ? connection_value.find("keep-alive") != std::string::npos
+                        : connection_value.find("close") == std::string::npos;
+
+    if (method == "HEAD" || response.status_code == 204 || response.status_code == 304) {
+        return ReadResult::OK;
+    }
+
+    auto transfer_encoding = response.headers.find("transfer-encoding");
+    auto content_length = response.headers.find("content-length");
+
+    bool stream_body = on_data && *on_data && response.status_code >= 200 && response.status_code < 300;
+    auto sink = [&](const char* data, size_t size) {
+        if (stream_body) {
+            (*on_data)(data, size);
+        } else {
+            response.body.append(data, size);
+        }
+    };
+
+    if (transfer_encoding != response.headers.end() &&
+        to_lower(transfer_encoding->second).find("chunked") != std::string::npos) {
+        for (;;) {
+            if (!reader.read_line(line)) {
+                return ReadResult::FAILED;
+            }
+            size_t chunk_size;
+            if (!parse_chunk_size(line, chunk_size)) {
+                return ReadResult::FAILED; // garbage, not the last chunk
+            }
+            if (chunk_size == 0) {
+                // Trailers end with an empty line
+                while (reader.read_line(line) && !line.empty()) {
+                }
+                return line.empty() ? ReadResult::OK : ReadResult::FAILED;
+            }
+            if (!reader.read_exact(chunk_size, sink) || !reader.read_line(line)) {
+                return ReadResult::FAILED;
+            }
+        }
+    }
+
+    if (content_length != response.headers.end()) {
+        size_t length;
+        if (!parse_content_length(content_length->second, length)) {
+            return ReadResult::FAILED; // unknown body size, the connection can't be reused
+        }
+        if (!stream_body) {
+            response.body.reserve(std::min(length, MAX_BODY_RESERVE));
+        }
+        return reader.read_exact(length, sink) ? ReadResult::OK : ReadResult::FAILED;
+    }
+
+    // No framing: body runs until the server closes the connection
+    reader.read_to_end(sink);
+    keep_alive = false;
+    return ReadResult::OK;
+}
+
+std::string build_request(const std::string& method,
+                          const ParsedURL& target,
+                          const std::map<std::string, std::string>& headers,
+                          const std::string& body) {
+    std::string request;
+    request.reserve(512 + body.size());
+
+    request += method;
+    request += ' ';
+    request += target.path;
+    request += " HTTP/1.1\r\nHost: ";
+    request += target.host;
+    if (target.port != (target.secure ? "443" : "80")) {
+        request += ':';
+        request += target.port;
+    }
+    request += "\r\n";
+
+    bool has_user_agent = false;
+    for (const auto& header : headers) {
+        std::string key = to_lower(header.first);
+        if (key == "host" || key == "connection" || key == "content-length") {
+            continue;
+        }
+        has_user_agent = has_user_agent || key == "user-agent";
+        request += header.first;
+        request += ": ";
+        request += header.second;
+        request += "\r\n";
+    }
+
+    if (!has_user_agent) {
+        request += "User-Agent: NecronomiCore/1.0\r\n";
+    }
+    request += "Connection: keep-alive\r\n";
+    if (!body.empty() || method == "POST") {
+        request += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    request += "\r\n";
+    request += body;
+
+    return request;
+}
+
+std::string pool_key_for(const ParsedURL& target) {
+    return (target.secure ? "https://" : "http://") + target.host + ":" + target.port;
+}
+
+bool acquire_idle_connection(PlatformData* data, const std::string& pool_key, PooledConnection& out) {
+    std::vector<PooledConnection> stale;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(data->mutex);
+        auto it = data->hosts.find(pool_key);
+        if (it == data->hosts.end()) {
+            return false;
+        }
+
+        auto expiry = PoolClock::now() - std::chrono::seconds(data->idle_timeout_seconds);
+        std::vector<PooledConnection>& idle = it->second.idle;
+        while (!idle.empty()) {
+            PooledConnection conn = idle.back();
+            idle.pop_back();
+            if (conn.last_used < expiry || !connection_alive(conn)) {
+                stale.push_back(conn);
+                continue;
+            }
+            out = conn;
+            found = true;
+            data->stats.connections_reused++;
+            break;
+        }
+    }
+
+    for (auto& conn : stale) {
+        close_connection(conn, true);
+    }
+    return found;
+}
+
+bool open_connection(PlatformData* data, const ParsedURL& target, const std::string& pool_key,
+                     int timeout_seconds, PooledConnection& conn, std::string& error) {
+    conn.fd = open_socket(target, timeout_seconds, error);
+    if (conn.fd < 0) {
+        return false;
+    }
+
+    if (target.secure) {
+        SSL* ssl = SSL_new(data->ssl_ctx);
+        if (!ssl) {
+            close_connection(conn, false);
+            error = "Failed to create TLS session";
+            return false;
+        }
+        SSL_set_fd(ssl, conn.fd);
+        SSL_set_tlsext_host_name(ssl, target.host.c_str());
+        SSL_set1_host(ssl, target.host.c_str());
+
+        {
+            std::lock_guard<std::mutex> lock(data->mutex);
+            SSL_SESSION* cached = data->hosts[pool_key].tls_session;
+            if (cached) {
+                SSL_set_session(ssl, cached);
+            }
+        }
+
+        if (SSL_connect(ssl) != 1) {
+            ERR_clear_error();
+            SSL_free(ssl);
+            close_connection(conn, false);
+            error = "TLS handshake failed";
+            return false;
+        }
+        conn.ssl = ssl;
+    }
+
+    std::lock_guard<std::mutex> lock(data->mutex);
+    data->stats.connections_opened++;
+    if (conn.ssl) {
+        data->stats.tls_handshakes++;
+        if (SSL_session_reused(conn.ssl)) {
+            data->stats.tls_sessions_resumed++;
+        }
+    }
+    return true;
+}
+
+void release_connection(PlatformData* data, const std::string& pool_key, PooledConnection& conn) {
+    SSL_SESSION* session = nullptr;
+    if (conn.ssl) {
+        // TLS 1.3 tickets arrive after the handshake, so capture the session late
+        session = SSL_get1_session(conn.ssl);
+        if (session && !SSL_SESSION_is_resumable(session)) {
+            SSL_SESSION_free(session);
+            session = nullptr;
+        }
+    }
+
+    bool pooled = false;
+    {
+        std::lock_guard<std::mutex> lock(data->mutex);
+        HostPool& pool = data->hosts[pool_key];
+        if (session) {
+            if (pool.tls_session) {
+                SSL_SESSION_free(pool.tls_session);
+            }
+            pool.tls_session = session;
+        }
+        if (static_cast<int>(pool.idle.size()) < data->max_idle_per_host) {
+            conn.last_used = PoolClock::now();
+            pool.idle.push_back(conn);
+            pooled = true;
+        }
+    }
+
+    if (!pooled) {
+        close_connection(conn, true);
+    }
+}
+
+} // namespace
 #endif
 
 namespace necronomicore {
 
 HTTPClient::HTTPClient() : timeout_seconds(30), platform_data(nullptr) {
+    PlatformData* data = new PlatformData();
 #ifdef _WIN32
-    platform_data = new PlatformData();
-    PlatformData* data = static_cast<PlatformData*>(platform_data);
     data->hSession = nullptr;
-    data->hConnect = nullptr;
+#else
+    data->ssl_ctx = SSL_CTX_new(TLS_client_method());
+    if (data->ssl_ctx) {
+        SSL_CTX_set_min_proto_version(data->ssl_ctx, TLS1_2_VERSION);
+        SSL_CTX_set_default_verify_paths(data->ssl_ctx);
+        SSL_CTX_set_verify(data->ssl_ctx, SSL_VERIFY_PEER, nullptr);
+        SSL_CTX_set_session_cache_mode(data->ssl_ctx, SSL_SESS_CACHE_CLIENT);
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+        SSL_CTX_set_options(data->ssl_ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+    }
 #endif
+    platform_data = data;
 }
 
 HTTPClient::~HTTPClient() {
+    PlatformData* data = static_cast<PlatformData*>(platform_data);
 #ifdef _WIN32
-    if (platform_data) {
-        PlatformData* data = static_cast<PlatformData*>(platform_data);
-        if (data->hConnect) WinHttpCloseHandle(data->hConnect);
-        if (data->hSession) WinHttpCloseHandle(data->hSession);
-        delete data;
+    for (auto& connection : data->connections) {
+        WinHttpCloseHandle(connection.second);
+    }
+    if (data->hSession) WinHttpCloseHandle(data->hSession);
+#else
+    for (auto& host : data->hosts) {
+        for (auto& conn : host.second.idle) {
+            close_connection(conn, true);
+        }
+        if (host.second.tls_session) {
+            SSL_SESSION_free(host.second.tls_session);
+        }
+    }
+    if (data->ssl_ctx) {
+        SSL_CTX_free(data->ssl_ctx);
     }
 #endif
+    delete data;
 }
 
 void HTTPClient::set_timeout(int seconds) {
+    PlatformData* data = static_cast<PlatformData*>(platform_data);
+    std::lock_guard<std::mutex> lock(data->mutex);
     timeout_seconds = seconds;
 }
 
 int HTTPClient::get_timeout() const {
+    PlatformData* data = static_cast<PlatformData*>(platform_data);
+    std::lock_guard<std::mutex> lock(data->mutex);
     return timeout_seconds;
 }
 
+void HTTPClient::set_max_idle_connections_per_host(int count) {
+    PlatformData* data = static_cast<PlatformData*>(platform_data);
+    std::lock_guard<std::mutex> lock(data->mutex);
+#ifdef _WIN32
+    DWORD max_conns = static_cast<DWORD>(count > 0 ? count : 1);
+    if (data->hSession) {
+        WinHttpSetOption(data->hSession, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &max_conns, sizeof(max_conns));
+    }
+#else
+    data->max_idle_per_host = count > 0 ? count : 0;
+#endif
+}
+
+void HTTPClient::set_idle_timeout(int seconds) {
+#ifndef _WIN32
+    PlatformData* data = static_cast<PlatformData*>(platform_data);
+    std::lock_guard<std::mutex> lock(data->mutex);
+    data->idle_timeout_seconds = seconds;
+#else
+    (void)seconds; // WinHTTP manages idle socket lifetime itself
+#endif
+}
+
+void HTTPClient::close_idle_connections() {
+    PlatformData* data = static_cast<PlatformData*>(platform_data);
+#ifdef _WIN32
+    std::lock_guard<std::mutex> lock(data->mutex);
+    for (auto& connection : data->connections) {
+        WinHttpCloseHandle(connection.second);
+    }
+    data->connections.clear();
+#else
+    std::vector<PooledConnection> idle;
+    {
+        std::lock_guard<std::mutex> lock(data->mutex);
+        for (auto& host : data->hosts) {
+            idle.insert(idle.end(), host.second.idle.begin(), host.second.idle.end());
+            host.second.idle.clear();
+        }
+    }
+    for (auto& conn : idle) {
+        close_connection(conn, true);
+    }
+#endif
+}
+
+HTTPClientStats HTTPClient::get_stats() const {
+    PlatformData* data = static_cast<PlatformData*>(platform_data);
+    std::lock_guard<std::mutex> lock(data->mutex);
+    return data->stats;
+}
+
 SimpleHTTPResponse HTTPClient::post(const std::string& url,
                                     const std::map<std::string, std::string>& headers,
                                     const std::string& body) {
-    return make_request("POST", url, headers, body);
+    return make_request("POST", url, headers, body, nullptr);
+}
+
+SimpleHTTPResponse HTTPClient::post_stream(const std::string& url,
+                                           const std::map<std::string, std::string>& headers,
+                                           const std::string& body,
+                                           const BodyCallback& on_data) {
+    return make_request("POST", url, headers, body, &on_data);
 }
 
 SimpleHTTPResponse HTTPClient::get(const std::string& url,
                                    const std::map<std::string, std::string>& headers) {
-    return make_request("GET", url, headers, "");
+    return make_request("GET", url, headers, "", nullptr);
 }
 
 SimpleHTTPResponse HTTPClient::make_request(const std::string& method,
                                            const std::string& url,
                                            const std::map<std::string, std::string>& headers,
-                                           const std::string& body) {
+                                           const std::string& body,
+                                           const BodyCallback* on_data) {
     SimpleHTTPResponse response;
     response.success = false;
     response.status_code = 0;
 
+    PlatformData* data = static_cast<PlatformData*>(platform_data);
+    int timeout; // set_timeout may run on another thread
+    {
+        std::lock_guard<std::mutex> lock(data->mutex);
+        data->stats.requests++;
+        timeout = timeout_seconds;
+    }
+
 #ifdef _WIN32
     // Parse URL
     std::wstring wurl(url.begin(), url.end());
     URL_COMPONENTS urlComp;
     ZeroMemory(&urlComp, sizeof(urlComp));
     urlComp.dwStructSize = sizeof(urlComp);
-    
+
     wchar_t szHostName[256];
     wchar_t szUrlPath[2048];
     urlComp.lpszHostName = szHostName;
@@ -80,28 +882,42 @@ SimpleHTTPResponse HTTPClient::make_request(const std::string& method,
         return response;
     }
 
-    // Create session
-    HINTERNET hSession = WinHttpOpen(L"NecronomiCore/1.0",
-                                     WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-                                     WINHTTP_NO_PROXY_NAME,
-                                     WINHTTP_NO_PROXY_BYPASS, 0);
-    if (!hSession) {
-        response.error = "Failed to create HTTP session";
-        return response;
-    }
+    // Reuse the session and per-host connection handle
+    HINTERNET hConnect = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(data->mutex);
 
-    // Create connection
-    HINTERNET hConnect = WinHttpConnect(hSession, szHostName, urlComp.nPort, 0);
-    if (!hConnect) {
-        WinHttpCloseHandle(hSession);
-        response.error = "Failed to connect to server";
-        return response;
+        if (!data->hSession) {
+            data->hSession = WinHttpOpen(L"NecronomiCore/1.0",
+                                         WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+                                         WINHTTP_NO_PROXY_NAME,
+                                         WINHTTP_NO_PROXY_BYPASS, 0);
+            if (!data->hSession) {
+                response.error = "Failed to create HTTP session";
+                return response;
+            }
+        }
+
+        std::wstring connection_key = std::wstring(szHostName) + L":" + std::to_wstring(urlComp.nPort);
+        auto existing = data->connections.find(connection_key);
+        if (existing != data->connections.end()) {
+            hConnect = existing->second;
+            data->stats.connections_reused++;
+        } else {
+            hConnect = WinHttpConnect(data->hSession, szHostName, urlComp.nPort, 0);
+            if (!hConnect) {
+                response.error = "Failed to connect to server";
+                return response;
+            }
+            data->connections[connection_key] = hConnect;
+            data->stats.connections_opened++;
+        }
     }
 
     // Create request
     std::wstring wmethod(method.begin(), method.end());
     DWORD dwFlags = (urlComp.nScheme == INTERNET_SCHEME_HTTPS) ? WINHTTP_FLAG_SECURE : 0;
-    
+
     HINTERNET hRequest = WinHttpOpenRequest(hConnect,
                                            wmethod.c_str(),
                                            szUrlPath,
@@ -110,14 +926,12 @@ SimpleHTTPResponse HTTPClient::make_request(const std::string& method,
                                            WINHTTP_DEFAULT_ACCEPT_TYPES,
                                            dwFlags);
     if (!hRequest) {
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
         response.error = "Failed to create request";
         return response;
     }
 
     // Set timeout
-    int timeout_ms = timeout_seconds * 1000;
+    int timeout_ms = timeout * 1000;
     WinHttpSetTimeouts(hRequest, timeout_ms, timeout_ms, timeout_ms, timeout_ms);
 
     // Add headers
@@ -146,8 +960,6 @@ SimpleHTTPResponse HTTPClient::make_request(const std::string& method,
 
     if (!bResults) {
         WinHttpCloseHandle(hRequest);
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
         response.error = "Failed to send request";
         return response;
     }
@@ -156,8 +968,6 @@ SimpleHTTPResponse HTTPClient::make_request(const std::string& method,
     bResults = WinHttpReceiveResponse(hRequest, NULL);
     if (!bResults) {
         WinHttpCloseHandle(hRequest);
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
         response.error = "Failed to receive response";
         return response;
     }
@@ -173,7 +983,29 @@ SimpleHTTPResponse HTTPClient::make_request(const std::string& method,
                        NULL);
     response.status_code = dwStatusCode;
 
+    // Get response headers (rate-limit and retry-after hints live here)
+    DWORD dwHeaderSize = 0;
+    WinHttpQueryHeaders(hRequest,
+                       WINHTTP_QUERY_RAW_HEADERS_CRLF,
+                       WINHTTP_HEADER_NAME_BY_INDEX,
+                       WINHTTP_NO_OUTPUT_BUFFER,
+                       &dwHeaderSize,
+                       WINHTTP_NO_HEADER_INDEX);
+    if (GetLastError() == ERROR_INSUFFICIENT_BUFFER && dwHeaderSize > 0) {
+        std::wstring rawHeaders(dwHeaderSize / sizeof(wchar_t), L'\0');
+        if (WinHttpQueryHeaders(hRequest,
+                               WINHTTP_QUERY_RAW_HEADERS_CRLF,
+                               WINHTTP_HEADER_NAME_BY_INDEX,
+                               &rawHeaders[0],
+                               &dwHeaderSize,
+                               WINHTTP_NO_HEADER_INDEX)) {
+            rawHeaders.resize(dwHeaderSize / sizeof(wchar_t));
+            parse_raw_headers(rawHeaders, response.headers);
+        }
+    }
+
     // Read response body
+    bool stream_body = on_data && *on_data && dwStatusCode >= 200 && dwStatusCode < 300;
     std::string responseBody;
     DWORD dwDownloaded = 0;
     do {
@@ -190,7 +1022,11 @@ SimpleHTTPResponse HTTPClient::make_request(const std::string& method,
         ZeroMemory(pszOutBuffer, dwSize + 1);
 
         if (WinHttpReadData(hRequest, (LPVOID)pszOutBuffer, dwSize, &dwDownloaded)) {
-            responseBody.append(pszOutBuffer, dwDownloaded);
+            if (stream_body) {
+                (*on_data)(pszOutBuffer, dwDownloaded);
+            } else {
+                responseBody.append(pszOutBuffer, dwDownloaded);
+            }
         }
 
         delete[] pszOutBuffer;
@@ -199,17 +1035,61 @@ SimpleHTTPResponse HTTPClient::make_request(const std::string& method,
     response.body = responseBody;
     response.success = (dwStatusCode >= 200 && dwStatusCode < 300);
 
-    // Cleanup
+    // Cleanup (session and connection stay open for reuse)
     WinHttpCloseHandle(hRequest);
-    WinHttpCloseHandle(hConnect);
-    WinHttpCloseHandle(hSession);
 
 #else
-    response.error = "HTTP client not implemented for this platform";
+    ParsedURL target;
+    if (!parse_url(url, target)) {
+        response.error = "Failed to parse URL";
+        return response;
+    }
+    if (target.secure && !data->ssl_ctx) {
+        response.error = "TLS is unavailable";
+        return response;
+    }
+
+    const std::string pool_key = pool_key_for(target);
+    const std::string request_bytes = build_request(method, target, headers, body);
+    SigpipeGuard sigpipe_guard;
+
+    // A pooled connection may have been closed by the server since its last
+    // use; if it fails before any byte comes back, retry once on a fresh one.
+    for (int attempt = 0; attempt < 2; attempt++) {
+        PooledConnection conn;
+        bool reused = attempt == 0 && acquire_idle_connection(data, pool_key, conn);
+        if (!reused && !open_connection(data, target, pool_key, timeout, conn, response.error)) {
+            return response;
+        }
+
+        bool sent = conn_write(conn, request_bytes.data(), request_bytes.size());
+        bool keep_alive = false;
+        ReadResult result = sent ? read_response(conn, method, on_data, response, keep_alive) : ReadResult::NO_RESPONSE;
+
+        if (result == ReadResult::NO_RESPONSE && reused) {
+            close_connection(conn, false);
+            continue;
+        }
+
+        if (result != ReadResult::OK) {
+            close_connection(conn, false);
+            response.error = sent ? "Failed to receive response" : "Failed to send request";
+            return response;
+        }
+
+        response.success = (response.status_code >= 200 && response.status_code < 300);
+        if (keep_alive) {
+            release_connection(data, pool_key, conn);
+        } else {
+            close_connection(conn, true);
+        }
+        return response;
+    }
+
+    response.error = "Failed to send request";
 #endif
 
     return response;
 }
 
 } // namespace necronomicore
-
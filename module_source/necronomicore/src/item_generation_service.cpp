@@ -1,10 +1,13 @@
 #include "item_generation_service.h"
+#include "procedural_item_generator.h"
 #include "json_utils.h"
+#include "json_reader.h"
 #include <godot_cpp/variant/utility_functions.hpp>
 #include <godot_cpp/variant/variant.hpp>
-#include <godot_cpp/classes/json.hpp>
 #include <sstream>
 #include <algorithm>
+#include <charconv>
+#include <cstring>
 
 using namespace godot;
 
@@ -12,72 +15,340 @@ namespace necronomicore {
 
 Dictionary ItemDefinition::to_dictionary() const {
     Dictionary dict;
-    dict["name"] = String(name.c_str());
-    dict["description"] = String(description.c_str());
+    dict["name"] = String::utf8(name.data(), name.size());
+    dict["description"] = String::utf8(description.data(), description.size());
     dict["type"] = static_cast<int>(type);
     dict["rarity"] = static_cast<int>(rarity);
     dict["damage"] = damage;
     dict["defense"] = defense;
     dict["healing"] = healing;
     dict["cooldown"] = cooldown;
-    dict["flavor_text"] = String(flavor_text.c_str());
-    dict["sprite_hint"] = String(sprite_hint.c_str());
+    dict["flavor_text"] = String::utf8(flavor_text.data(), flavor_text.size());
+    dict["sprite_hint"] = String::utf8(sprite_hint.data(), sprite_hint.size());
     
     Array effects_array;
     for (const auto& effect : effects) {
-        effects_array.append(String(effect.c_str()));
+        effects_array.append(String::utf8(effect.data(), effect.size()));
     }
     dict["effects"] = effects_array;
+
+    Dictionary modifiers_dict;
+    for (const auto& modifier : modifiers) {
+        modifiers_dict[String::utf8(modifier.first.data(), modifier.first.size())] = modifier.second;
+    }
+    dict["modifiers"] = modifiers_dict;
     
     return dict;
 }
 
+namespace {
+
+const char* const RARITY_NAMES[ItemStore::RARITY_COUNT] = {"common", "uncommon", "rare", "epic", "legendary", "cursed"};
+
+//items asked for per rarity in a full pool (10 in total)
+const int RARITY_TARGETS[ItemStore::RARITY_COUNT] = {3, 2, 2, 1, 1, 1};
+
+//the rarities below their target and how many items each is short
+PoolShard shortfall(const size_t* filled) {
+    PoolShard shard;
+    shard.item_count = 0;
+    for (int rarity = 0; rarity < ItemStore::RARITY_COUNT; rarity++) {
+        size_t target = static_cast<size_t>(RARITY_TARGETS[rarity]);
+        if (filled[rarity] < target) {
+            shard.rarities.push_back(static_cast<ItemRarity>(rarity));
+            shard.item_count += static_cast<int>(target - filled[rarity]);
+        }
+    }
+    return shard;
+}
+
+ItemRarity rarity_from_string(std::string& text) {
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    if (text == "uncommon") return ItemRarity::UNCOMMON;
+    if (text == "rare") return ItemRarity::RARE;
+    if (text == "epic") return ItemRarity::EPIC;
+    if (text == "legendary") return ItemRarity::LEGENDARY;
+    if (text == "cursed") return ItemRarity::CURSED;
+    return ItemRarity::COMMON;
+}
+
+ItemType type_from_string(std::string& text) {
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    if (text == "armor") return ItemType::ARMOR;
+    if (text == "consumable") return ItemType::CONSUMABLE;
+    if (text == "relic") return ItemType::RELIC;
+    if (text == "artifact") return ItemType::ARTIFACT;
+    return ItemType::WEAPON;
+}
+
+//string field, any other json type leaves the default in place
+bool read_text_field(std::string_view json, size_t& pos, std::string& out) {
+    JSONReader::skip_whitespace(json, pos);
+    if (pos < json.size() && json[pos] == '"') {
+        return JSONReader::read_string(json, pos, out);
+    }
+    return JSONReader::skip_value(json, pos);
+}
+
+//stat written as a number or a numeric string ("12"), anything else counts as 0
+bool read_stat_field(std::string_view json, size_t& pos, double& out, std::string& scratch) {
+    out = 0.0;
+    JSONReader::skip_whitespace(json, pos);
+    if (pos < json.size() && json[pos] == '"') {
+        if (!JSONReader::read_string(json, pos, scratch)) {
+            return false;
+        }
+        std::from_chars(scratch.data(), scratch.data() + scratch.size(), out);
+        return true;
+    }
+    if (JSONReader::read_number(json, pos, out)) {
+        return true;
+    }
+    return JSONReader::skip_value(json, pos);
+}
+
+int stat_to_int(double value) {
+    //clamped before the cast, the model occasionally writes absurd numbers
+    return static_cast<int>(std::clamp(value, -1.0e6, 1.0e6));
+}
+
+//pos on the '{' of an item object, ends past its '}'
+//fills fields as it meets them, false if the object is malformed
+bool parse_item_object(std::string_view json, size_t& pos, ItemDefinition& item, std::string& key, std::string& text) {
+    item.name = "Unknown Item";
+    pos++;
+    JSONReader::skip_whitespace(json, pos);
+    if (pos < json.size() && json[pos] == '}') {
+        pos++;
+        return true;
+    }
+
+    while (true) {
+        if (!JSONReader::read_string(json, pos, key)) {
+            return false;
+        }
+        JSONReader::skip_whitespace(json, pos);
+        if (pos >= json.size() || json[pos] != ':') {
+            return false;
+        }
+        pos++;
+
+        bool ok;
+        double number;
+        if (key == "name") {
+            ok = read_text_field(json, pos, item.name);
+        } else if (key == "description") {
+            ok = read_text_field(json, pos, item.description);
+        } else if (key == "flavor_text") {
+            ok = read_text_field(json, pos, item.flavor_text);
+        } else if (key == "sprite_hint") {
+            ok = read_text_field(json, pos, item.sprite_hint);
+        } else if (key == "rarity") {
+            text.clear();
+            ok = read_text_field(json, pos, text);
+            item.rarity = rarity_from_string(text);
+        } else if (key == "type") {
+            text.clear();
+            ok = read_text_field(json, pos, text);
+            item.type = type_from_string(text);
+        } else if (key == "damage") {
+            ok = read_stat_field(json, pos, number, text);
+            item.damage = stat_to_int(number);
+        } else if (key == "defense") {
+            ok = read_stat_field(json, pos, number, text);
+            item.defense = stat_to_int(number);
+        } else if (key == "healing") {
+            ok = read_stat_field(json, pos, number, text);
+            item.healing = stat_to_int(number);
+        } else if (key == "cooldown") {
+            ok = read_stat_field(json, pos, number, text);
+            item.cooldown = static_cast<float>(std::clamp(number, -1.0e6, 1.0e6));
+        } else {
+            ok = JSONReader::skip_value(json, pos);
+        }
+        if (!ok) {
+            return false;
+        }
+
+        JSONReader::skip_whitespace(json, pos);
+        if (pos >= json.size()) {
+            return false;
+        }
+        if (json[pos] == '}') {
+            pos++;
+            return true;
+        }
+        if (json[pos] != ',') {
+            return false;
+        }
+        pos++;
+    }
+}
+
+} // anonymous namespace
+
 ItemDefinition ItemDefinition::from_json(const std::string& json) {
     ItemDefinition item;
-    Dictionary dict = JSONUtils::parse_json(json);
-    
-    item.name = JSONUtils::get_string(dict, "name", "Unknown Item");
-    item.description = JSONUtils::get_string(dict, "description", "");
-    item.damage = JSONUtils::get_int(dict, "damage", 0);
-    item.defense = JSONUtils::get_int(dict, "defense", 0);
-    item.healing = JSONUtils::get_int(dict, "healing", 0);
-    item.cooldown = JSONUtils::get_float(dict, "cooldown", 0.0f);
-    item.flavor_text = JSONUtils::get_string(dict, "flavor_text", "");
-    item.sprite_hint = JSONUtils::get_string(dict, "sprite_hint", "");
-    
-    // Parse rarity
-    std::string rarity_str = JSONUtils::get_string(dict, "rarity", "common");
-    std::transform(rarity_str.begin(), rarity_str.end(), rarity_str.begin(), ::tolower);
-    
-    if (rarity_str == "uncommon") item.rarity = ItemRarity::UNCOMMON;
-    else if (rarity_str == "rare") item.rarity = ItemRarity::RARE;
-    else if (rarity_str == "epic") item.rarity = ItemRarity::EPIC;
-    else if (rarity_str == "legendary") item.rarity = ItemRarity::LEGENDARY;
-    else if (rarity_str == "cursed") item.rarity = ItemRarity::CURSED;
-    else item.rarity = ItemRarity::COMMON;
-    
-    // Parse type
-    std::string type_str = JSONUtils::get_string(dict, "type", "weapon");
-    std::transform(type_str.begin(), type_str.end(), type_str.begin(), ::tolower);
-    
-    if (type_str == "armor") item.type = ItemType::ARMOR;
-    else if (type_str == "consumable") item.type = ItemType::CONSUMABLE;
-    else if (type_str == "relic") item.type = ItemType::RELIC;
-    else if (type_str == "artifact") item.type = ItemType::ARTIFACT;
-    else item.type = ItemType::WEAPON;
-    
+    std::string key;
+    std::string text;
+    size_t pos = json.find('{');
+    if (pos == std::string::npos || !parse_item_object(json, pos, item, key, text)) {
+        item = ItemDefinition();
+        item.name = "Unknown Item";
+    }
     return item;
 }
 
+size_t ItemStreamParser::feed(std::string_view delta, std::vector<ItemDefinition>& out) {
+    if (finished) {
+        return 0;
+    }
+    content.append(delta.data(), delta.size());
+    
+    size_t found = 0;
+    for (; scan_pos < content.size(); scan_pos++) {
+        char c = content[scan_pos];
+        //strings only count inside the payload, a preamble like "here's your loot" is not json
+        if (in_string) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                in_string = false;
+            }
+            continue;
+        }
+        
+        if (c == '"' && depth > 0) {
+            in_string = true;
+        } else if (c == '{' || c == '[') {
+            if (c == '{' && depth == array_depth) {
+                object_start = scan_pos;
+            }
+            depth++;
+            if (c == '[' && array_depth < 0) {
+                array_depth = depth;
+            }
+        } else if ((c == '}' || c == ']') && depth > 0) {
+            if (c == ']' && depth == array_depth) {
+                //the items array is closed, whatever follows is not ours
+                finished = true;
+                scan_pos = content.size();
+                break;
+            }
+            depth--;
+            if (c == '}' && depth == array_depth && object_start != std::string::npos) {
+                std::string_view json(content);
+                size_t pos = object_start;
+                ItemDefinition item;
+                if (parse_item_object(json, pos, item, key, text) && pos == scan_pos + 1) {
+                    ItemGenerationService::validate_and_clamp_item(item);
+                    out.push_back(std::move(item));
+                    item_count++;
+                    found++;
+                } else {
+                    skipped_count++;
+                }
+                object_start = std::string::npos;
+            }
+        }
+    }
+    return found;
+}
+
+PoolSnapshotCache::Snapshot& PoolSnapshotCache::snapshot_of(const ItemPool& pool) {
+    Snapshot& snapshot = snapshots[pool.pool_id];
+    if (snapshot.version != pool.store.get_version()) {
+        //a new pool was published under this id, drop what was built for the old one
+        snapshot = Snapshot();
+        snapshot.version = pool.store.get_version();
+    }
+    return snapshot;
+}
+
+Array PoolSnapshotCache::get_items(const ItemPool& pool) {
+    Snapshot& snapshot = snapshot_of(pool);
+    if (!snapshot.has_items) {
+        snapshot.items = pool.store.to_array(0, pool.store.size());
+        snapshot.has_items = true;
+    }
+    return snapshot.items;
+}
+
+Array PoolSnapshotCache::get_range(const ItemPool& pool, int64_t offset, int64_t count) {
+    size_t begin = static_cast<size_t>(std::max<int64_t>(offset, 0));
+    size_t end = count < 0 ? pool.store.size() : begin + static_cast<size_t>(count);
+    end = std::min(end, pool.store.size());
+    
+    Snapshot& snapshot = snapshot_of(pool);
+    if (snapshot.has_items && begin < end) {
+        Array page = snapshot.items.slice(static_cast<int64_t>(begin), static_cast<int64_t>(end));
+        page.make_read_only();
+        return page;
+    }
+    return pool.store.to_array(begin, end);
+}
+
+PackedByteArray PoolSnapshotCache::get_packed(const ItemPool& pool) {
+    Snapshot& snapshot = snapshot_of(pool);
+    if (!snapshot.has_packed) {
+        std::string bytes;
+        ItemPoolStore::serialize(0, pool, bytes);
+        snapshot.packed.resize(static_cast<int64_t>(bytes.size()));
+        if (!bytes.empty()) {
+            std::memcpy(snapshot.packed.ptrw(), bytes.data(), bytes.size());
+        }
+        snapshot.has_packed = true;
+    }
+    return snapshot.packed;
+}
+
+//one pool's shards in flight, shared by their callbacks
+struct ItemGenerationService::PoolAssembly {
+    std::string pool_id;
+    Dictionary run_config;
+    uint64_t store_key = 0;
+    std::vector<ItemDefinition> items;        //the model's items, what the pool store keeps
+    std::vector<ItemDefinition> placeholders; //procedural items, by rarity
+    size_t backfilled = 0;                    //placeholders in the latest publish
+    int shards_pending = 0;
+    int shards_failed = 0;
+    std::string error;
+    bool published = false;
+    bool topped_up = false; //one top-up round per pool
+    size_t published_items = 0;
+    std::shared_ptr<ItemPool> latest;
+    PoolCallback on_pool;
+    std::function<void(const ItemDefinition&)> on_item;
+};
+
 ItemGenerationService::ItemGenerationService(std::shared_ptr<OpenAIClient> openai_client)
-    : client(openai_client) {
+    : client(openai_client),
+      next_pool_id(0),
+      pool_clock(0),
+      pool_memory_limit(8 * 1024 * 1024),
+      pool_evictions(0),
+      pool_store_enabled(true),
+      current_floor(1),
+      prefetch_depth(1),
+      run_generation(0),
+      current_pool_floor(0),
+      rng(std::random_device{}()),
+      shard_count(3),
+      min_ready_items(3),
+      top_up_enabled(true),
+      top_up_requests(0),
+      top_up_items(0),
+      procedural_fill_enabled(true),
+      procedural_items(0) {
     initialize_fallback_pool();
 }
 
 ItemGenerationService::~ItemGenerationService() {
 }
 
-std::string ItemGenerationService::build_item_generation_prompt(const Dictionary& run_config) {
+std::string ItemGenerationService::build_item_generation_prompt(const Dictionary& run_config, const PoolShard& shard) {
     int difficulty = run_config.get("difficulty", 1);
     int floor_number = run_config.get("floor", 1);
     String theme = run_config.get("theme", "lovecraftian fungal dungeon");
@@ -102,83 +373,87 @@ std::string ItemGenerationService::build_item_generation_prompt(const Dictionary
     prompt << "  },\n";
     prompt << "  {\"name\": \"Item 2\", ...}\n";
     prompt << "]\n\n";
-    prompt << "Generate 10 items with varied rarities (common, uncommon, rare, epic, legendary, cursed). ";
+    if (shard.rarities.empty()) {
+        prompt << "Generate " << shard.item_count << " items with varied rarities (common, uncommon, rare, epic, legendary, cursed). ";
+    } else {
+        prompt << "Generate " << shard.item_count << " items. Use only these rarities: ";
+        for (size_t i = 0; i < shard.rarities.size(); i++) {
+            prompt << (i > 0 ? ", " : "") << RARITY_NAMES[static_cast<int>(shard.rarities[i])];
+        }
+        prompt << ". ";
+    }
     prompt << "Items should fit the Lovecraftian fungal theme with names inspired by mushrooms and cosmic horror. ";
     prompt << "Types can be: weapon, armor, consumable, relic, or artifact.";
     
     return prompt.str();
 }
 
-std::vector<ItemDefinition> ItemGenerationService::parse_item_array(const std::string& json) {
+std::vector<ItemDefinition> ItemGenerationService::parse_item_array(std::string_view content, int* skipped_count) {
     std::vector<ItemDefinition> items;
+    int skipped = 0;
     
-    Dictionary response = JSONUtils::parse_json(json);
+    //the first bracket starts the payload, which drops ```json fences and any preamble
+    size_t pos = content.find_first_of("[{");
+    if (pos != std::string_view::npos && content[pos] == '{') {
+        std::string_view wrapped;
+        if (JSONReader(content.substr(pos)).find("items", wrapped) && !wrapped.empty() && wrapped[0] == '[') {
+            content = wrapped;
+            pos = 0;
+        } else {
+            //a lone item object instead of an array
+            std::string key;
+            std::string text;
+            ItemDefinition item;
+            if (parse_item_object(content, pos, item, key, text)) {
+                validate_and_clamp_item(item);
+                items.push_back(std::move(item));
+            }
+            pos = std::string_view::npos;
+        }
+    }
     
-    // Handle OpenAI response format: response.choices[0].message.content
-    if (JSONUtils::has_key(response, "choices")) {
-        Array choices = JSONUtils::get_array(response, "choices");
-        if (choices.size() > 0) {
-            Dictionary first_choice = choices[0];
-            Dictionary message = JSONUtils::get_dict(first_choice, "message");
-            std::string content = JSONUtils::get_string(message, "content");
-            
-            // The content is a JSON string, parse it
-            // GPT might return just an array like: [{item1}, {item2}, ...]
-            Ref<JSON> json_parser;
-            json_parser.instantiate();
-            Error err = json_parser->parse(String(content.c_str()));
+    if (pos != std::string_view::npos) {
+        items.reserve(content.size() / 256);
+        std::string key;
+        std::string text;
+        pos++;
+        while (true) {
+            JSONReader::skip_whitespace(content, pos);
+            if (pos >= content.size() || content[pos] == ']') {
+                break;
+            }
             
-            if (err == OK) {
-                Variant content_data = json_parser->get_data();
-                
-                // Check if it's directly an array
-                if (content_data.get_type() == Variant::ARRAY) {
-                    Array items_array = content_data;
-                    for (int i = 0; i < items_array.size(); i++) {
-                        if (items_array[i].get_type() == Variant::DICTIONARY) {
-                            Dictionary item_dict = items_array[i];
-                            ItemDefinition item = ItemDefinition::from_json(JSONUtils::stringify_json(item_dict));
-                            validate_and_clamp_item(item);
-                            items.push_back(item);
-                        }
-                    }
-                }
-                // Or if it's a dict with "items" key
-                else if (content_data.get_type() == Variant::DICTIONARY) {
-                    Dictionary content_dict = content_data;
-                    if (content_dict.has(Variant("items"))) {
-                        Variant items_var = content_dict[Variant("items")];
-                        if (items_var.get_type() == Variant::ARRAY) {
-                            Array items_array = items_var;
-                            for (int i = 0; i < items_array.size(); i++) {
-                                if (items_array[i].get_type() == Variant::DICTIONARY) {
-                                    Dictionary item_dict = items_array[i];
-                                    ItemDefinition item = ItemDefinition::from_json(JSONUtils::stringify_json(item_dict));
-                                    validate_and_clamp_item(item);
-                                    items.push_back(item);
-                                }
-                            }
-                        }
-                    }
+            size_t element_start = pos;
+            ItemDefinition item;
+            if (content[pos] == '{' && parse_item_object(content, pos, item, key, text)) {
+                validate_and_clamp_item(item);
+                items.push_back(std::move(item));
+            } else {
+                //resynchronize on the element's closing bracket, a truncated tail ends the pool
+                skipped++;
+                pos = element_start;
+                if (!JSONReader::skip_value(content, pos)) {
+                    break;
                 }
             }
+            
+            JSONReader::skip_whitespace(content, pos);
+            if (pos >= content.size() || content[pos] != ',') {
+                break;
+            }
+            pos++;
         }
     }
     
+    if (skipped_count) {
+        *skipped_count = skipped;
+    }
     return items;
 }
 
 void ItemGenerationService::validate_and_clamp_item(ItemDefinition& item) {
-    // Clamp stats based on rarity
-    int max_stat = 10;
-    switch (item.rarity) {
-        case ItemRarity::COMMON: max_stat = 15; break;
-        case ItemRarity::UNCOMMON: max_stat = 30; break;
-        case ItemRarity::RARE: max_stat = 50; break;
-        case ItemRarity::EPIC: max_stat = 75; break;
-        case ItemRarity::LEGENDARY: max_stat = 100; break;
-        case ItemRarity::CURSED: max_stat = 150; break; // Can be powerful but dangerous
-    }
+    //one item at a time, whole pools are clamped column-wise by ItemStore::clamp_stats
+    int max_stat = ItemStore::max_stat(item.rarity);
     
     item.damage = std::clamp(item.damage, 0, max_stat);
     item.defense = std::clamp(item.defense, 0, max_stat);
@@ -196,152 +471,573 @@ void ItemGenerationService::initialize_fallback_pool() {
     sword.damage = 10;
     sword.flavor_text = "Even decay has its uses.";
     
-    fallback_pool.common_items.push_back(sword);
+    //a fixed seed, so the fallback pool is the same every launch; two of each type per
+    //rarity so a type filter never comes back empty
+    std::vector<ItemDefinition> items = {sword};
+    std::mt19937_64 fallback_rng(0x5eed);
+    for (int rarity = 0; rarity < ItemStore::RARITY_COUNT; rarity++) {
+        for (int type = 0; type < ItemStore::TYPE_COUNT * 2; type++) {
+            items.push_back(ProceduralItemGenerator::generate(fallback_rng, static_cast<ItemRarity>(rarity),
+                                                              type % ItemStore::TYPE_COUNT, 1, 1));
+        }
+    }
+    
     fallback_pool.pool_id = "fallback";
     fallback_pool.theme = "emergency_pool";
+    fallback_pool.store.build(items, fallback_pool.floor_number);
 }
 
-void ItemGenerationService::generate_item_pool(const Dictionary& run_config,
-                                               std::function<void(const std::string&)> on_success,
-                                               std::function<void(const std::string&)> on_error) {
-    std::string pool_id = "pool_" + std::to_string(cached_pools.size());
-    std::string prompt = build_item_generation_prompt(run_config);
+bool ItemGenerationService::open_pool_store(const std::string& directory) {
+    return pool_store.open(directory);
+}
+
+bool ItemGenerationService::has_stored_pool(const Dictionary& run_config) {
+    return pool_store_enabled && pool_store.contains(ItemPoolStore::config_key(build_item_generation_prompt(run_config)));
+}
+
+std::shared_ptr<ItemPool> ItemGenerationService::build_pool(const std::string& pool_id,
+                                                            const Dictionary& run_config,
+                                                            const std::vector<ItemDefinition>& items) {
+    auto pool = std::make_shared<ItemPool>();
+    pool->pool_id = pool_id;
+    pool->difficulty_level = run_config.get("difficulty", 1);
+    pool->floor_number = run_config.get("floor", 1);
+    pool->theme = String(run_config.get("theme", "lovecraftian fungal dungeon")).utf8().get_data();
     
-    Array messages;
-    Dictionary user_message;
-    user_message[Variant("role")] = Variant("user");
-    user_message[Variant("content")] = Variant(String(prompt.c_str()));
-    messages.append(user_message);
-    
-    client->chat_completion(messages, "gpt-3.5-turbo", 0.8, 2000,
-        [this, pool_id, on_success, on_error](const HTTPResponse& response) {
-            if (response.success) {
-                std::vector<ItemDefinition> items = parse_item_array(response.body);
-                
-                if (items.empty()) {
-                    on_error("Failed to parse items from API response");
-                    return;
+    pool->store.build(items, pool->floor_number);
+    return pool;
+}
+
+void ItemGenerationService::generate_procedural_items(const Dictionary& run_config, std::vector<ItemDefinition>& out) {
+    int difficulty = run_config.get("difficulty", 1);
+    int floor_number = run_config.get("floor", 1);
+    CharString theme = String(run_config.get("theme", "lovecraftian fungal dungeon")).utf8();
+    size_t before = out.size();
+    ProceduralItemGenerator::generate_pool(rng, RARITY_TARGETS, difficulty, floor_number,
+                                           std::string_view(theme.get_data(), theme.length()), out);
+    procedural_items += out.size() - before;
+}
+
+std::shared_ptr<ItemPool> ItemGenerationService::build_procedural_pool(const std::string& pool_id, const Dictionary& run_config) {
+    std::vector<ItemDefinition> items;
+    generate_procedural_items(run_config, items);
+    return build_pool(pool_id, run_config, items);
+}
+
+//rarities dealt round-robin over the shards, each asking for its rarities' targets
+std::vector<PoolShard> ItemGenerationService::plan_shards() const {
+    if (shard_count <= 1) {
+        return {PoolShard()};
+    }
+    std::vector<PoolShard> shards(shard_count);
+    for (PoolShard& shard : shards) {
+        shard.item_count = 0;
+    }
+    for (int rarity = 0; rarity < ItemStore::RARITY_COUNT; rarity++) {
+        PoolShard& shard = shards[rarity % shard_count];
+        shard.rarities.push_back(static_cast<ItemRarity>(rarity));
+        shard.item_count += RARITY_TARGETS[rarity];
+    }
+    return shards;
+}
+
+void ItemGenerationService::set_shard_count(int shards) {
+    shard_count = std::clamp(shards, 1, ItemStore::RARITY_COUNT);
+}
+
+void ItemGenerationService::set_top_up_enabled(bool enabled) {
+    top_up_enabled = enabled;
+}
+
+void ItemGenerationService::set_min_ready_items(int items) {
+    min_ready_items = std::max(items, 1);
+}
+
+void ItemGenerationService::request_pool(const Dictionary& run_config,
+                                         const std::string& pool_id,
+                                         PoolCallback on_pool,
+                                         std::function<void(const ItemDefinition&)> on_item) {
+    //stored pools are keyed by the whole-pool prompt, whatever the shard count
+    uint64_t store_key = ItemPoolStore::config_key(build_item_generation_prompt(run_config));
+    if (pool_store_enabled) {
+        std::shared_ptr<ItemPool> stored = pool_store.load(store_key);
+        if (stored) {
+            stored->pool_id = pool_id;
+            if (on_item) {
+                for (size_t row = 0; row < stored->store.size(); row++) {
+                    on_item(stored->store.get_item(row));
                 }
-                
-                ItemPool pool;
-                pool.pool_id = pool_id;
-                
-                // Organize by rarity
-                for (const auto& item : items) {
-                    switch (item.rarity) {
-                        case ItemRarity::COMMON: pool.common_items.push_back(item); break;
-                        case ItemRarity::UNCOMMON: pool.uncommon_items.push_back(item); break;
-                        case ItemRarity::RARE: pool.rare_items.push_back(item); break;
-                        case ItemRarity::EPIC: pool.epic_items.push_back(item); break;
-                        case ItemRarity::LEGENDARY: pool.legendary_items.push_back(item); break;
-                        case ItemRarity::CURSED: pool.cursed_items.push_back(item); break;
-                    }
+            }
+            
+            //a stored pool short of some rarity is backfilled and topped up like a fresh one
+            PoolShard top_up = plan_top_up(*stored);
+            bool backfill = procedural_fill_enabled && !top_up.rarities.empty();
+            if (!backfill) {
+                on_pool(stored, "", false);
+            }
+            if ((top_up_enabled || backfill) && !top_up.rarities.empty()) {
+                auto assembly = std::make_shared<PoolAssembly>();
+                assembly->pool_id = pool_id;
+                assembly->run_config = run_config.duplicate();
+                assembly->store_key = store_key;
+                assembly->items.reserve(stored->store.size());
+                for (size_t row = 0; row < stored->store.size(); row++) {
+                    assembly->items.push_back(stored->store.get_item(row));
+                }
+                assembly->on_pool = on_pool;
+                assembly->on_item = on_item;
+                if (backfill) {
+                    generate_procedural_items(assembly->run_config, assembly->placeholders);
+                    publish_pool(assembly);
+                } else {
+                    assembly->latest = stored;
+                    assembly->published = true;
+                    assembly->published_items = assembly->items.size();
+                }
+                if (top_up_enabled) {
+                    request_top_up(assembly, top_up);
                 }
-                
-                cached_pools[pool_id] = pool;
-                on_success(pool_id);
-            } else {
-                on_error(response.error_message);
             }
+            return;
         }
-    );
+    }
+    
+    std::vector<PoolShard> shards = plan_shards();
+    auto assembly = std::make_shared<PoolAssembly>();
+    assembly->pool_id = pool_id;
+    assembly->run_config = run_config.duplicate();
+    assembly->store_key = store_key;
+    assembly->on_pool = on_pool;
+    assembly->on_item = on_item;
+    
+    //a full pool right away, the shards replace it rarity by rarity
+    if (procedural_fill_enabled) {
+        generate_procedural_items(assembly->run_config, assembly->placeholders);
+        publish_pool(assembly);
+    }
+    
+    for (const PoolShard& shard : shards) {
+        request_shard(assembly, shard);
+    }
 }
 
-std::string ItemGenerationService::generate_item_pool_sync(const Dictionary& run_config) {
-    std::string pool_id = "pool_" + std::to_string(cached_pools.size());
-    std::string prompt = build_item_generation_prompt(run_config);
+void ItemGenerationService::request_shard(const std::shared_ptr<PoolAssembly>& assembly, const PoolShard& shard) {
+    assembly->shards_pending++;
     
-    Array messages;
-    Dictionary user_message;
-    user_message[Variant("role")] = Variant("user");
-    user_message[Variant("content")] = Variant(String(prompt.c_str()));
-    messages.append(user_message);
+    //large requests, must not hold up dialog the player is waiting on
+    //streamed so each item lands as soon as its object is closed
+    auto parser = std::make_shared<ItemStreamParser>();
+    RequestOptions options;
+    options.priority = RequestPriority::BACKGROUND;
+    options.stream = true;
+    options.on_chunk = [this, assembly, parser](const std::string& delta) {
+        std::vector<ItemDefinition> items;
+        if (parser->feed(delta, items) > 0) {
+            add_pool_items(assembly, items);
+        }
+    };
     
-    HTTPResponse response = client->chat_completion_sync(messages, "gpt-3.5-turbo", 0.8, 2000);
+    std::vector<ChatMessage> messages = {{"user", build_item_generation_prompt(assembly->run_config, shard)}};
+    int max_tokens = std::min(2000, 200 * shard.item_count + 200);
+    client->chat_completion(messages, "gpt-3.5-turbo", 0.8, max_tokens,
+        [this, assembly, parser](const HTTPResponse& response) {
+            on_shard_done(assembly, *parser, response);
+        },
+        options
+    );
+}
+
+PoolShard ItemGenerationService::plan_top_up(const ItemPool& pool) {
+    size_t filled[ItemStore::RARITY_COUNT];
+    for (int rarity = 0; rarity < ItemStore::RARITY_COUNT; rarity++) {
+        filled[rarity] = pool.store.count(rarity);
+    }
+    return shortfall(filled);
+}
+
+PoolShard ItemGenerationService::plan_top_up(const std::vector<ItemDefinition>& items) {
+    size_t filled[ItemStore::RARITY_COUNT] = {};
+    for (const ItemDefinition& item : items) {
+        filled[static_cast<int>(item.rarity)]++;
+    }
+    return shortfall(filled);
+}
+
+void ItemGenerationService::request_top_up(const std::shared_ptr<PoolAssembly>& assembly, const PoolShard& shard) {
+    //only the missing rarities, sized to what is missing; the items already in the
+    //pool are kept and the new ones are appended to them
+    assembly->topped_up = true;
+    top_up_requests++;
+    request_shard(assembly, shard);
+}
+
+void ItemGenerationService::add_pool_items(const std::shared_ptr<PoolAssembly>& assembly, std::vector<ItemDefinition>& items) {
+    for (ItemDefinition& item : items) {
+        if (assembly->on_item) {
+            assembly->on_item(item);
+        }
+        assembly->items.push_back(std::move(item));
+    }
+    if (assembly->topped_up) {
+        top_up_items += items.size();
+    }
     
-    if (!response.success) {
-        return "fallback";
+    bool ready = assembly->published || assembly->items.size() >= static_cast<size_t>(min_ready_items) ||
+        assembly->shards_pending == 0;
+    if (ready && assembly->items.size() > assembly->published_items) {
+        publish_pool(assembly);
     }
+}
+
+void ItemGenerationService::publish_pool(const std::shared_ptr<PoolAssembly>& assembly) {
+    //every publish is a new immutable pool, readers of the previous one are unaffected
+    //the store copies the items into its arena, the assembly keeps its own for the next publish
+    //placeholders fill each rarity up to its target, so a model item of a rarity displaces one
+    size_t filled[ItemStore::RARITY_COUNT] = {};
+    for (const ItemDefinition& item : assembly->items) {
+        filled[static_cast<int>(item.rarity)]++;
+    }
+    std::vector<ItemDefinition> backfill;
+    for (const ItemDefinition& item : assembly->placeholders) {
+        int rarity = static_cast<int>(item.rarity);
+        if (filled[rarity] < static_cast<size_t>(RARITY_TARGETS[rarity])) {
+            filled[rarity]++;
+            backfill.push_back(item);
+        }
+    }
+    assembly->backfilled = backfill.size();
+    if (backfill.empty()) {
+        assembly->latest = build_pool(assembly->pool_id, assembly->run_config, assembly->items);
+    } else {
+        backfill.insert(backfill.begin(), assembly->items.begin(), assembly->items.end());
+        assembly->latest = build_pool(assembly->pool_id, assembly->run_config, backfill);
+    }
+    assembly->published_items = assembly->items.size();
+    bool update = assembly->published;
+    assembly->published = true;
+    assembly->on_pool(assembly->latest, "", update);
+}
+
+void ItemGenerationService::on_shard_done(const std::shared_ptr<PoolAssembly>& assembly,
+                                          const ItemStreamParser& parser,
+                                          const HTTPResponse& response) {
+    assembly->shards_pending--;
+    int skipped = parser.get_skipped_count();
+    std::vector<ItemDefinition> items;
     
-    std::vector<ItemDefinition> items = parse_item_array(response.body);
-    if (items.empty()) {
-        return "fallback";
+    if (response.success) {
+        //nothing came through the stream: a server that ignored stream, or a shape the
+        //incremental parser doesn't follow (a lone object), parse the whole reply instead
+        if (parser.get_item_count() == 0) {
+            items = parse_item_array(response.content, &skipped);
+        }
+        if (parser.get_item_count() == 0 && items.empty() && !assembly->topped_up) {
+            assembly->shards_failed++;
+            assembly->error = "Failed to parse items from API response";
+        }
+    } else if (!assembly->topped_up) {
+        //items streamed before the failure are kept, the pool just isn't stored
+        assembly->shards_failed++;
+        assembly->error = response.error_message;
+    }
+    if (skipped > 0) {
+        UtilityFunctions::push_warning("NecronomiCore: skipped malformed items in generated pool: ", skipped);
     }
     
-    ItemPool pool;
-    pool.pool_id = pool_id;
+    //also publishes a short pool once the last shard is in
+    add_pool_items(assembly, items);
     
-    for (const auto& item : items) {
-        switch (item.rarity) {
-            case ItemRarity::COMMON: pool.common_items.push_back(item); break;
-            case ItemRarity::UNCOMMON: pool.uncommon_items.push_back(item); break;
-            case ItemRarity::RARE: pool.rare_items.push_back(item); break;
-            case ItemRarity::EPIC: pool.epic_items.push_back(item); break;
-            case ItemRarity::LEGENDARY: pool.legendary_items.push_back(item); break;
-            case ItemRarity::CURSED: pool.cursed_items.push_back(item); break;
+    if (assembly->shards_pending > 0) {
+        return;
+    }
+    if (assembly->items.empty()) {
+        if (assembly->published) {
+            //already out as a procedural pool, which is what it stays
+            UtilityFunctions::push_warning("NecronomiCore: item generation failed, keeping procedural items: ",
+                                           String(assembly->error.c_str()));
+        } else {
+            assembly->on_pool(nullptr, assembly->error, false);
         }
+        return;
     }
     
-    cached_pools[pool_id] = pool;
-    return pool_id;
+    //the model often skips legendary or cursed, or a failed shard took its rarities with it
+    PoolShard top_up = plan_top_up(assembly->items);
+    if (top_up_enabled && !assembly->topped_up && !top_up.rarities.empty()) {
+        request_top_up(assembly, top_up);
+        return;
+    }
+    
+    //only a pool with every shard (or its top-up) in is worth keeping across restarts
+    bool stocked = top_up.rarities.empty();
+    if ((assembly->shards_failed == 0 || stocked) && pool_store_enabled) {
+        if (assembly->backfilled == 0) {
+            pool_store.save(assembly->store_key, *assembly->latest);
+        } else {
+            pool_store.save(assembly->store_key, *build_pool(assembly->pool_id, assembly->run_config, assembly->items));
+        }
+    }
 }
 
-Dictionary ItemGenerationService::get_random_item(const std::string& pool_id, ItemRarity rarity) {
-    const ItemPool* pool = &fallback_pool;
+void ItemGenerationService::generate_item_pool(const Dictionary& run_config,
+                                               std::function<void(const std::string&)> on_success,
+                                               std::function<void(const std::string&)> on_error,
+                                               std::function<void(const std::string&)> on_update,
+                                               std::function<void(const ItemDefinition&)> on_item) {
+    //upstream is down, hand out a local pool now instead of a failed request later
+    if (client->is_circuit_open(CHAT_COMPLETIONS_ENDPOINT) && !has_stored_pool(run_config)) {
+        if (!procedural_fill_enabled) {
+            on_success(fallback_pool.pool_id);
+            return;
+        }
+        std::string pool_id = "pool_" + std::to_string(next_pool_id++);
+        cache_pool(pool_id, build_procedural_pool(pool_id, run_config));
+        on_success(pool_id);
+        return;
+    }
     
-    if (cached_pools.find(pool_id) != cached_pools.end()) {
-        pool = &cached_pools[pool_id];
+    std::string pool_id = "pool_" + std::to_string(next_pool_id++);
+    request_pool(run_config, pool_id,
+        [this, pool_id, on_success, on_error, on_update](std::shared_ptr<const ItemPool> pool, const std::string& error, bool update) {
+            if (pool) {
+                cache_pool(pool_id, pool);
+                if (!update) {
+                    on_success(pool_id);
+                } else if (on_update) {
+                    on_update(pool_id);
+                }
+            } else if (client->is_circuit_open(CHAT_COMPLETIONS_ENDPOINT)) {
+                on_success(fallback_pool.pool_id);
+            } else {
+                on_error(error);
+            }
+        },
+        on_item
+    );
+}
+
+std::string ItemGenerationService::generate_item_pool_sync(const Dictionary& run_config) {
+    std::string pool_id = "pool_" + std::to_string(next_pool_id++);
+    std::string prompt = build_item_generation_prompt(run_config);
+    uint64_t store_key = ItemPoolStore::config_key(prompt);
+    if (pool_store_enabled) {
+        std::shared_ptr<ItemPool> stored = pool_store.load(store_key);
+        if (stored) {
+            stored->pool_id = pool_id;
+            cache_pool(pool_id, stored);
+            return pool_id;
+        }
     }
     
-    const std::vector<ItemDefinition>* items_vec = nullptr;
+    std::vector<ChatMessage> messages = {{"user", prompt}};
     
-    switch (rarity) {
-        case ItemRarity::COMMON: items_vec = &pool->common_items; break;
-        case ItemRarity::UNCOMMON: items_vec = &pool->uncommon_items; break;
-        case ItemRarity::RARE: items_vec = &pool->rare_items; break;
-        case ItemRarity::EPIC: items_vec = &pool->epic_items; break;
-        case ItemRarity::LEGENDARY: items_vec = &pool->legendary_items; break;
-        case ItemRarity::CURSED: items_vec = &pool->cursed_items; break;
+    HTTPResponse response = client->chat_completion_sync(messages, "gpt-3.5-turbo", 0.8, 2000);
+    std::vector<ItemDefinition> items;
+    if (response.success) {
+        items = parse_item_array(response.content);
+    }
+    if (items.empty()) {
+        if (!procedural_fill_enabled) {
+            return "fallback";
+        }
+        cache_pool(pool_id, build_procedural_pool(pool_id, run_config));
+        return pool_id;
     }
     
-    if (!items_vec || items_vec->empty()) {
-        return fallback_pool.common_items[0].to_dictionary();
+    std::shared_ptr<ItemPool> pool = build_pool(pool_id, run_config, items);
+    if (pool_store_enabled) {
+        pool_store.save(store_key, *pool);
     }
+    cache_pool(pool_id, pool);
+    return pool_id;
+}
+
+void ItemGenerationService::start_run(const Dictionary& config) {
+    //anything still in flight belongs to the previous run
+    run_generation++;
+    run_config = config.duplicate();
+    current_floor = run_config.get("floor", 1);
+    current_pool.reset();
+    current_pool_floor = 0;
+    prefetched_pools.clear();
+    pending_floors.clear();
     
-    int index = rand() % items_vec->size();
-    return (*items_vec)[index].to_dictionary();
+    prefetch_ahead();
 }
 
-Dictionary ItemGenerationService::get_random_item_any_rarity(const std::string& pool_id) {
-    ItemRarity rarities[] = {
-        ItemRarity::COMMON,
-        ItemRarity::UNCOMMON,
-        ItemRarity::RARE,
-        ItemRarity::EPIC,
-        ItemRarity::LEGENDARY,
-        ItemRarity::CURSED
-    };
+void ItemGenerationService::advance_to_floor(int floor) {
+    current_floor = floor;
+    
+    //back buffers for floors behind us are never needed again
+    prefetched_pools.erase(prefetched_pools.begin(), prefetched_pools.lower_bound(floor));
     
-    ItemRarity selected = rarities[rand() % 6];
-    return get_random_item(pool_id, selected);
+    auto ready = prefetched_pools.find(floor);
+    if (ready != prefetched_pools.end()) {
+        //one pointer swap, anything still holding the old pool keeps it alive
+        current_pool = ready->second;
+        current_pool_floor = floor;
+        prefetched_pools.erase(ready);
+    }
+    
+    prefetch_ahead();
 }
 
-Array ItemGenerationService::get_all_items_in_pool(const std::string& pool_id) {
-    Array result;
+void ItemGenerationService::set_prefetch_depth(int floors) {
+    prefetch_depth = std::clamp(floors, 0, 3);
+}
+
+//requests every floor from the current one to prefetch_depth ahead that isn't ready or in flight
+void ItemGenerationService::prefetch_ahead() {
+    if (run_config.is_empty()) {
+        return;
+    }
     
-    const ItemPool* pool = &fallback_pool;
-    if (cached_pools.find(pool_id) != cached_pools.end()) {
-        pool = &cached_pools[pool_id];
+    for (int floor = current_floor; floor <= current_floor + prefetch_depth; floor++) {
+        bool have = (floor == current_pool_floor) || prefetched_pools.count(floor) || pending_floors.count(floor);
+        if (have) {
+            continue;
+        }
+        Dictionary config = run_config.duplicate();
+        config["floor"] = floor;
+        
+        //no point queueing work that would only fail fast, the next advance tries again
+        if (client->is_circuit_open(CHAT_COMPLETIONS_ENDPOINT) && !has_stored_pool(config)) {
+            continue;
+        }
+        pending_floors.insert(floor);
+        
+        uint64_t generation = run_generation;
+        request_pool(config, "floor_" + std::to_string(floor),
+            [this, floor, generation](std::shared_ptr<const ItemPool> pool, const std::string& error, bool) {
+                if (generation != run_generation) {
+                    return;
+                }
+                pending_floors.erase(floor);
+                if (!pool) {
+                    UtilityFunctions::push_warning("NecronomiCore: item prefetch failed for floor ", floor, ": ", String(error.c_str()));
+                    return;
+                }
+                on_floor_pool_ready(floor, pool);
+            }
+        );
+    }
+}
+
+void ItemGenerationService::on_floor_pool_ready(int floor, std::shared_ptr<const ItemPool> pool) {
+    if (floor < current_floor) {
+        return; //the player already moved past it
     }
+    if (floor == current_floor) {
+        //the player got here before the pool did, swap it in now
+        current_pool = pool;
+        current_pool_floor = floor;
+        return;
+    }
+    prefetched_pools[floor] = pool;
+}
+
+Dictionary ItemGenerationService::get_prefetch_status() const {
+    Dictionary status;
+    status["current_floor"] = current_floor;
+    status["current_pool_ready"] = is_floor_pool_ready();
+    status["prefetch_depth"] = prefetch_depth;
     
-    for (const auto& item : pool->common_items) result.append(item.to_dictionary());
-    for (const auto& item : pool->uncommon_items) result.append(item.to_dictionary());
-    for (const auto& item : pool->rare_items) result.append(item.to_dictionary());
-    for (const auto& item : pool->epic_items) result.append(item.to_dictionary());
-    for (const auto& item : pool->legendary_items) result.append(item.to_dictionary());
-    for (const auto& item : pool->cursed_items) result.append(item.to_dictionary());
+    Array ready;
+    for (const auto& pair : prefetched_pools) {
+        ready.append(pair.first);
+    }
+    Array pending;
+    for (int floor : pending_floors) {
+        pending.append(floor);
+    }
+    status["prefetched_floors"] = ready;
+    status["pending_floors"] = pending;
+    status["top_up_requests"] = static_cast<int64_t>(top_up_requests);
+    status["top_up_items"] = static_cast<int64_t>(top_up_items);
+    status["procedural_items"] = static_cast<int64_t>(procedural_items);
+    return status;
+}
+
+const ItemPool& ItemGenerationService::find_pool(const std::string& pool_id) const {
+    if (pool_id.empty()) {
+        return current_pool ? *current_pool : fallback_pool;
+    }
+    auto it = cached_pools.find(pool_id);
+    if (it == cached_pools.end()) {
+        return fallback_pool;
+    }
+    it->second.last_used = ++pool_clock;
+    return *it->second.pool;
+}
+
+void ItemGenerationService::cache_pool(const std::string& pool_id, std::shared_ptr<const ItemPool> pool) {
+    CachedPool& entry = cached_pools[pool_id];
+    entry.pool = std::move(pool);
+    entry.last_used = ++pool_clock;
+    //a grown pool is a new version, its old snapshot is dropped on the next query anyway
+    evict_pools(pool_id);
+}
+
+void ItemGenerationService::evict_pools(const std::string& keep_id) {
+    if (pool_memory_limit == 0) {
+        return;
+    }
+    size_t used = get_pool_memory_used();
+    while (used > pool_memory_limit && cached_pools.size() > 1) {
+        auto oldest = cached_pools.end();
+        for (auto it = cached_pools.begin(); it != cached_pools.end(); ++it) {
+            if (it->first != keep_id && (oldest == cached_pools.end() || it->second.last_used < oldest->second.last_used)) {
+                oldest = it;
+            }
+        }
+        if (oldest == cached_pools.end()) {
+            break;
+        }
+        used -= oldest->second.pool->memory_bytes();
+        snapshots.erase(oldest->first);
+        cached_pools.erase(oldest);
+        pool_evictions++;
+    }
+}
+
+Dictionary ItemGenerationService::random_item_from(const ItemPool& pool, int rarity, int type) const {
+    int64_t row = pool.store.sample(rng, rarity, type);
+    if (row >= 0) {
+        return pool.store.to_dictionary(row);
+    }
     
-    return result;
+    //nothing of that type in the pool
+    const ItemStore& fallback = fallback_pool.store;
+    row = fallback.sample(rng, rarity, type);
+    return fallback.to_dictionary(row >= 0 ? row : 0);
+}
+
+Dictionary ItemGenerationService::get_random_item(ItemRarity rarity, int type) const {
+    return random_item_from(current_pool ? *current_pool : fallback_pool, static_cast<int>(rarity), type);
+}
+
+Dictionary ItemGenerationService::get_random_item_any_rarity(int type) const {
+    return random_item_from(current_pool ? *current_pool : fallback_pool, ItemStore::ANY, type);
+}
+
+Dictionary ItemGenerationService::get_random_item(const std::string& pool_id, ItemRarity rarity) {
+    return random_item_from(find_pool(pool_id), static_cast<int>(rarity), ItemStore::ANY);
+}
+
+Dictionary ItemGenerationService::get_random_item_any_rarity(const std::string& pool_id) {
+    return random_item_from(find_pool(pool_id), ItemStore::ANY, ItemStore::ANY);
+}
+
+Array ItemGenerationService::get_all_items_in_pool(const std::string& pool_id) {
+    return snapshots.get_items(find_pool(pool_id));
+}
+
+Array ItemGenerationService::get_items_range(const std::string& pool_id, int64_t offset, int64_t count) {
+    return snapshots.get_range(find_pool(pool_id), offset, count);
+}
+
+PackedByteArray ItemGenerationService::export_pool(const std::string& pool_id) {
+    return snapshots.get_packed(find_pool(pool_id));
 }
 
 bool ItemGenerationService::has_pool(const std::string& pool_id) const {
@@ -350,10 +1046,49 @@ bool ItemGenerationService::has_pool(const std::string& pool_id) const {
 
 void ItemGenerationService::clear_pool(const std::string& pool_id) {
     cached_pools.erase(pool_id);
+    snapshots.erase(pool_id);
 }
 
 void ItemGenerationService::clear_all_pools() {
     cached_pools.clear();
+    snapshots.clear();
+}
+
+void ItemGenerationService::set_pool_memory_limit(size_t bytes) {
+    pool_memory_limit = bytes;
+    evict_pools("");
+}
+
+size_t ItemGenerationService::get_pool_memory_used() const {
+    size_t used = 0;
+    for (const auto& pair : cached_pools) {
+        used += pair.second.pool->memory_bytes();
+    }
+    return used;
+}
+
+Dictionary ItemGenerationService::get_pool_memory_stats() const {
+    std::vector<std::pair<uint64_t, const ItemPool*>> by_use;
+    for (const auto& pair : cached_pools) {
+        by_use.emplace_back(pair.second.last_used, pair.second.pool.get());
+    }
+    std::sort(by_use.begin(), by_use.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    
+    Array pools;
+    for (const auto& entry : by_use) {
+        Dictionary pool;
+        pool["pool_id"] = String(entry.second->pool_id.c_str());
+        pool["bytes"] = static_cast<int64_t>(entry.second->memory_bytes());
+        pool["items"] = static_cast<int64_t>(entry.second->store.size());
+        pools.append(pool);
+    }
+    
+    Dictionary stats;
+    stats["limit"] = static_cast<int64_t>(pool_memory_limit);
+    stats["used"] = static_cast<int64_t>(get_pool_memory_used());
+    stats["evictions"] = static_cast<int64_t>(pool_evictions);
+    stats["pools"] = pools;
+    return stats;
 }
 
 Dictionary ItemGenerationService::get_pool_metadata(const std::string& pool_id) {
@@ -363,17 +1098,24 @@ Dictionary ItemGenerationService::get_pool_metadata(const std::string& pool_id)
         return metadata;
     }
     
-    const ItemPool& pool = cached_pools[pool_id];
+    const ItemPool& pool = find_pool(pool_id);
     metadata["pool_id"] = String(pool.pool_id.c_str());
     metadata["difficulty"] = pool.difficulty_level;
     metadata["floor"] = pool.floor_number;
     metadata["theme"] = String(pool.theme.c_str());
-    metadata["total_items"] = pool.common_items.size() + pool.uncommon_items.size() + 
-                             pool.rare_items.size() + pool.epic_items.size() + 
-                             pool.legendary_items.size() + pool.cursed_items.size();
+    metadata["total_items"] = static_cast<int64_t>(pool.store.size());
+    metadata["version"] = static_cast<int64_t>(pool.store.get_version());
+    metadata["memory_bytes"] = static_cast<int64_t>(pool.memory_bytes());
+    
+    //fill per rarity bucket against its target, what a top-up would ask for
+    Array rarity_counts;
+    for (int rarity = 0; rarity < ItemStore::RARITY_COUNT; rarity++) {
+        rarity_counts.append(static_cast<int64_t>(pool.store.count(rarity)));
+    }
+    metadata["rarity_counts"] = rarity_counts;
+    metadata["missing_items"] = plan_top_up(pool).item_count;
     
     return metadata;
 }
 
 } // namespace necronomicore
-
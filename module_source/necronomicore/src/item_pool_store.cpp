@@ -0,0 +1,451 @@
+#include "item_pool_store.h"
+#include "item_generation_service.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace necronomicore {
+
+namespace {
+
+//file layout, host byte order (the magic doubles as the byte-order check):
+//  header       64 bytes
+//  records      item_count x 64 bytes, items in rarity order
+//  effects      effect_count x StringRef
+//  modifiers    modifier_count x 16 bytes (key, value)
+//  strings      string_bytes of utf-8, referenced by offset and length
+//every section is a multiple of 8 bytes, so a mapping can be read in place.
+//bump FILE_VERSION on any layout change, older files are rejected and regenerated
+const uint32_t FILE_MAGIC = 0x5049434E; //"NCIP"
+const uint32_t FILE_VERSION = 2;
+const char* FILE_EXTENSION = ".pool";
+
+//bounds a corrupt header can't push us past
+const uint32_t MAX_ITEMS = 1 << 16;
+const uint32_t MAX_EFFECTS = 1 << 20;
+const uint32_t MAX_MODIFIERS = 1 << 20;
+
+struct StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t item_count;
+    uint32_t effect_count;
+    uint32_t string_bytes;
+    int32_t difficulty_level;
+    int32_t floor_number;
+    StringRef pool_id;
+    StringRef theme;
+    uint32_t modifier_count;
+    uint32_t reserved[2];
+};
+
+struct ItemRecord {
+    uint8_t type;
+    uint8_t rarity;
+    uint16_t modifier_count;
+    int32_t damage;
+    int32_t defense;
+    int32_t healing;
+    float cooldown;
+    StringRef name;
+    StringRef description;
+    StringRef flavor_text;
+    StringRef sprite_hint;
+    uint32_t first_effect;
+    uint32_t effect_count;
+    uint32_t first_modifier;
+};
+
+struct ModifierRecord {
+    StringRef key;
+    float value;
+    uint32_t padding;
+};
+
+static_assert(sizeof(StringRef) == 8, "pool file layout changed");
+static_assert(sizeof(FileHeader) == 64, "pool file layout changed");
+static_assert(sizeof(ItemRecord) == 64, "pool file layout changed");
+static_assert(sizeof(ModifierRecord) == 16, "pool file layout changed");
+
+StringRef add_string(std::string& strings, const std::string& text) {
+    StringRef ref = {static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(text.size())};
+    strings.append(text);
+    return ref;
+}
+
+bool ref_in_bounds(const StringRef& ref, uint32_t string_bytes) {
+    return static_cast<uint64_t>(ref.offset) + ref.length <= string_bytes;
+}
+
+} // anonymous namespace
+
+ItemPoolStore::ItemPoolStore() {
+}
+
+ItemPoolStore::~ItemPoolStore() {
+    unmap_all();
+}
+
+uint64_t ItemPoolStore::config_key(std::string_view canonical) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : canonical) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool ItemPoolStore::open(const std::string& path) {
+    close();
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+    if (ec || !std::filesystem::is_directory(path, ec)) {
+        return false;
+    }
+    directory = path;
+    return true;
+}
+
+void ItemPoolStore::close() {
+    unmap_all();
+    directory.clear();
+}
+
+std::string ItemPoolStore::path_for(uint64_t key) const {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(directory) / (std::string(name) + FILE_EXTENSION)).string();
+}
+
+const ItemPoolStore::Mapping* ItemPoolStore::map_pool(uint64_t key) {
+    auto existing = mappings.find(key);
+    if (existing != mappings.end()) {
+        return &existing->second;
+    }
+
+    std::string path = path_for(key);
+    Mapping mapping;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader))) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    HANDLE section = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!section) {
+        return nullptr;
+    }
+    //the view keeps the section alive on its own
+    void* view = MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(section);
+    if (!view) {
+        return nullptr;
+    }
+    mapping.data = static_cast<const char*>(view);
+    mapping.size = static_cast<size_t>(file_size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        ::close(fd);
+        return nullptr;
+    }
+    //shared read-only pages, every process mapping the file uses the same page cache
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        return nullptr;
+    }
+    mapping.data = static_cast<const char*>(view);
+    mapping.size = static_cast<size_t>(info.st_size);
+#endif
+
+    stats.mapped_bytes += mapping.size;
+    return &mappings.emplace(key, mapping).first->second;
+}
+
+void ItemPoolStore::unmap(uint64_t key) {
+    auto it = mappings.find(key);
+    if (it == mappings.end()) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(it->second.data);
+#else
+    munmap(const_cast<char*>(it->second.data), it->second.size);
+#endif
+    stats.mapped_bytes -= it->second.size;
+    mappings.erase(it);
+}
+
+void ItemPoolStore::unmap_all() {
+    while (!mappings.empty()) {
+        unmap(mappings.begin()->first);
+    }
+}
+
+std::shared_ptr<ItemPool> ItemPoolStore::load(uint64_t key) {
+    if (!is_open()) {
+        return nullptr;
+    }
+
+    const Mapping* mapping = map_pool(key);
+    if (!mapping) {
+        stats.misses++;
+        return nullptr;
+    }
+
+    std::shared_ptr<ItemPool> pool = deserialize(key, mapping->data, mapping->size);
+    if (!pool) {
+        //stale version or a damaged file, drop it so the next generation rewrites it
+        stats.rejected++;
+        stats.misses++;
+        unmap(key);
+        std::error_code ec;
+        std::filesystem::remove(path_for(key), ec);
+        return nullptr;
+    }
+
+    stats.hits++;
+    return pool;
+}
+
+bool ItemPoolStore::contains(uint64_t key) const {
+    if (!is_open()) {
+        return false;
+    }
+    if (mappings.count(key)) {
+        return true;
+    }
+    std::error_code ec;
+    return std::filesystem::is_regular_file(path_for(key), ec);
+}
+
+bool ItemPoolStore::save(uint64_t key, const ItemPool& pool) {
+    if (!is_open()) {
+        return false;
+    }
+
+    std::string buffer;
+    serialize(key, pool, buffer);
+
+    //write beside the target and rename over it, so a reader never maps a half-written file
+    //and processes that already mapped the old file keep their pages
+    //our own mapping would keep serving the replaced file
+    unmap(key);
+
+    std::string path = path_for(key);
+    std::string temp_path = path + ".tmp";
+    std::FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool written = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    written = (std::fclose(file) == 0) && written;
+
+    std::error_code ec;
+    if (written) {
+        std::filesystem::rename(temp_path, path, ec);
+    }
+    if (!written || ec) {
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+
+    stats.stores++;
+    return true;
+}
+
+void ItemPoolStore::clear() {
+    unmap_all();
+    if (!is_open()) {
+        return;
+    }
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+        if (entry.path().extension() == FILE_EXTENSION) {
+            std::error_code remove_ec;
+            std::filesystem::remove(entry.path(), remove_ec);
+        }
+    }
+}
+
+ItemPoolStoreStats ItemPoolStore::get_stats() const {
+    ItemPoolStoreStats result = stats;
+    result.mapped_files = mappings.size();
+    return result;
+}
+
+void ItemPoolStore::serialize(uint64_t key, const ItemPool& pool, std::string& out) {
+    std::string strings;
+    std::vector<ItemRecord> records;
+    std::vector<StringRef> effects;
+    std::vector<ModifierRecord> modifiers;
+
+    FileHeader header = {};
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.key = key;
+    header.difficulty_level = pool.difficulty_level;
+    header.floor_number = pool.floor_number;
+    header.pool_id = add_string(strings, pool.pool_id);
+    header.theme = add_string(strings, pool.theme);
+
+    //store rows are already in rarity order
+    for (size_t row = 0; row < pool.store.size(); row++) {
+        ItemDefinition item = pool.store.get_item(row);
+        ItemRecord record = {};
+        record.type = static_cast<uint8_t>(item.type);
+        record.rarity = static_cast<uint8_t>(item.rarity);
+        record.damage = item.damage;
+        record.defense = item.defense;
+        record.healing = item.healing;
+        record.cooldown = item.cooldown;
+        record.name = add_string(strings, item.name);
+        record.description = add_string(strings, item.description);
+        record.flavor_text = add_string(strings, item.flavor_text);
+        record.sprite_hint = add_string(strings, item.sprite_hint);
+        record.first_effect = static_cast<uint32_t>(effects.size());
+        record.effect_count = static_cast<uint32_t>(item.effects.size());
+        for (const std::string& effect : item.effects) {
+            effects.push_back(add_string(strings, effect));
+        }
+        record.first_modifier = static_cast<uint32_t>(modifiers.size());
+        for (const auto& modifier : item.modifiers) {
+            if (record.modifier_count == UINT16_MAX) {
+                break;
+            }
+            ModifierRecord entry = {};
+            entry.key = add_string(strings, modifier.first);
+            entry.value = modifier.second;
+            modifiers.push_back(entry);
+            record.modifier_count++;
+        }
+        records.push_back(record);
+    }
+    strings.resize((strings.size() + 7) & ~static_cast<size_t>(7), '\0');
+
+    header.item_count = static_cast<uint32_t>(records.size());
+    header.effect_count = static_cast<uint32_t>(effects.size());
+    header.modifier_count = static_cast<uint32_t>(modifiers.size());
+    header.string_bytes = static_cast<uint32_t>(strings.size());
+
+    out.clear();
+    out.reserve(sizeof(FileHeader) + records.size() * sizeof(ItemRecord) +
+                effects.size() * sizeof(StringRef) + modifiers.size() * sizeof(ModifierRecord) + strings.size());
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(ItemRecord));
+    out.append(reinterpret_cast<const char*>(effects.data()), effects.size() * sizeof(StringRef));
+    out.append(reinterpret_cast<const char*>(modifiers.data()), modifiers.size() * sizeof(ModifierRecord));
+    out.append(strings);
+}
+
+std::shared_ptr<ItemPool> ItemPoolStore::deserialize(uint64_t key, const char* data, size_t size) {
+    if (size < sizeof(FileHeader)) {
+        return nullptr;
+    }
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != FILE_MAGIC || header.version != FILE_VERSION || header.key != key ||
+        header.item_count > MAX_ITEMS || header.effect_count > MAX_EFFECTS ||
+        header.modifier_count > MAX_MODIFIERS) {
+        return nullptr;
+    }
+
+    //the sections must cover the file exactly
+    size_t records_offset = sizeof(FileHeader);
+    size_t effects_offset = records_offset + static_cast<size_t>(header.item_count) * sizeof(ItemRecord);
+    size_t modifiers_offset = effects_offset + static_cast<size_t>(header.effect_count) * sizeof(StringRef);
+    size_t strings_offset = modifiers_offset + static_cast<size_t>(header.modifier_count) * sizeof(ModifierRecord);
+    if (strings_offset + header.string_bytes != size) {
+        return nullptr;
+    }
+    const char* strings = data + strings_offset;
+    auto text = [strings](const StringRef& ref) {
+        return std::string(strings + ref.offset, ref.length);
+    };
+
+    if (!ref_in_bounds(header.pool_id, header.string_bytes) || !ref_in_bounds(header.theme, header.string_bytes)) {
+        return nullptr;
+    }
+
+    auto pool = std::make_shared<ItemPool>();
+    std::vector<ItemDefinition> items(header.item_count);
+    pool->pool_id = text(header.pool_id);
+    pool->theme = text(header.theme);
+    pool->difficulty_level = header.difficulty_level;
+    pool->floor_number = header.floor_number;
+
+    for (uint32_t i = 0; i < header.item_count; i++) {
+        ItemRecord record;
+        std::memcpy(&record, data + records_offset + i * sizeof(ItemRecord), sizeof(record));
+        if (record.type > static_cast<uint8_t>(ItemType::ARTIFACT) ||
+            record.rarity > static_cast<uint8_t>(ItemRarity::CURSED) ||
+            static_cast<uint64_t>(record.first_effect) + record.effect_count > header.effect_count ||
+            static_cast<uint64_t>(record.first_modifier) + record.modifier_count > header.modifier_count ||
+            !ref_in_bounds(record.name, header.string_bytes) ||
+            !ref_in_bounds(record.description, header.string_bytes) ||
+            !ref_in_bounds(record.flavor_text, header.string_bytes) ||
+            !ref_in_bounds(record.sprite_hint, header.string_bytes)) {
+            return nullptr;
+        }
+
+        ItemDefinition& item = items[i];
+        item.type = static_cast<ItemType>(record.type);
+        item.rarity = static_cast<ItemRarity>(record.rarity);
+        item.damage = record.damage;
+        item.defense = record.defense;
+        item.healing = record.healing;
+        item.cooldown = record.cooldown;
+        item.name = text(record.name);
+        item.description = text(record.description);
+        item.flavor_text = text(record.flavor_text);
+        item.sprite_hint = text(record.sprite_hint);
+        item.effects.reserve(record.effect_count);
+        for (uint32_t e = 0; e < record.effect_count; e++) {
+            StringRef ref;
+            std::memcpy(&ref, data + effects_offset + (record.first_effect + e) * sizeof(StringRef), sizeof(ref));
+            if (!ref_in_bounds(ref, header.string_bytes)) {
+                return nullptr;
+            }
+            item.effects.push_back(text(ref));
+        }
+        for (uint32_t m = 0; m < record.modifier_count; m++) {
+            ModifierRecord entry;
+            std::memcpy(&entry, data + modifiers_offset + (record.first_modifier + m) * sizeof(ModifierRecord), sizeof(entry));
+            if (!ref_in_bounds(entry.key, header.string_bytes)) {
+                return nullptr;
+            }
+            item.modifiers[text(entry.key)] = entry.value;
+        }
+    }
+    pool->store.build(items, pool->floor_number);
+    return pool;
+}
+
+} // namespace necronomicore
@@ -0,0 +1,421 @@
+#include "item_store.h"
+#include "item_generation_service.h"
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/string.hpp>
+#include <unordered_map>
+#include <string_view>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+using namespace godot;
+
+namespace necronomicore {
+
+namespace {
+
+//odds on floor 1 and their growth per floor, capped at floor 20
+const double BASE_RARITY_WEIGHT[ItemStore::RARITY_COUNT] = {50.0, 28.0, 14.0, 6.0, 1.5, 0.5};
+const double RARITY_WEIGHT_GROWTH[ItemStore::RARITY_COUNT] = {0.94, 1.0, 1.05, 1.08, 1.10, 1.06};
+const int MAX_WEIGHTED_FLOOR = 20;
+
+const int MAX_STAT[ItemStore::RARITY_COUNT] = {15, 30, 50, 75, 100, 150};
+
+//shared by every store, build() may run on any thread
+std::atomic<uint64_t> next_store_version{1};
+
+//interns strings while a store is being built, views point into the source items
+class StringInterner {
+private:
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::vector<std::string_view> strings;
+    size_t text_bytes = 0;
+
+public:
+    StringInterner() {
+        intern(std::string_view());
+    }
+
+    uint32_t intern(std::string_view text) {
+        auto result = ids.emplace(text, static_cast<uint32_t>(strings.size()));
+        if (result.second) {
+            strings.push_back(text);
+            text_bytes += text.size() + 1;
+        }
+        return result.first->second;
+    }
+
+    uint32_t find(std::string_view text) const {
+        return ids.find(text)->second;
+    }
+
+    const std::vector<std::string_view>& get_strings() const { return strings; }
+    size_t get_text_bytes() const { return text_bytes; }
+};
+
+template <typename T>
+void allocate_column(PoolArena& arena, Column<T>& column, size_t count) {
+    column.data = arena.allocate<T>(count);
+    column.count = static_cast<uint32_t>(count);
+}
+
+//uniform in [0, n) from the high 32 bits of a draw (multiply-shift, no modulo bias worth measuring)
+inline uint32_t uniform_index(uint64_t draw, size_t n) {
+    return static_cast<uint32_t>(((draw >> 32) * static_cast<uint64_t>(n)) >> 32);
+}
+
+} // anonymous namespace
+
+double ItemStore::rarity_weight(ItemRarity item_rarity, int floor) {
+    int index = static_cast<int>(item_rarity);
+    int steps = std::clamp(floor, 1, MAX_WEIGHTED_FLOOR) - 1;
+    return BASE_RARITY_WEIGHT[index] * std::pow(RARITY_WEIGHT_GROWTH[index], steps);
+}
+
+int ItemStore::max_stat(ItemRarity item_rarity) {
+    return MAX_STAT[static_cast<int>(item_rarity)];
+}
+
+void PoolArena::reset(size_t bytes) {
+    size_t words = (bytes + 7) / 8;
+    block.reset(words > 0 ? new uint64_t[words] : nullptr);
+    capacity = words * 8;
+    used = 0;
+}
+
+void ItemStore::build(const std::vector<ItemDefinition>& items, int floor) {
+    floor_number = floor;
+    version = next_store_version.fetch_add(1, std::memory_order_relaxed);
+
+    //rows grouped by rarity, in arrival order within a rarity
+    size_t count = items.size();
+    size_t rarity_rows[RARITY_COUNT] = {};
+    size_t type_rows[RARITY_COUNT][TYPE_COUNT] = {};
+    for (const ItemDefinition& item : items) {
+        int r = std::clamp(static_cast<int>(item.rarity), 0, RARITY_COUNT - 1);
+        int t = std::clamp(static_cast<int>(item.type), 0, TYPE_COUNT - 1);
+        rarity_rows[r]++;
+        type_rows[r][t]++;
+    }
+    std::vector<const ItemDefinition*> ordered(count);
+    size_t next_row[RARITY_COUNT] = {};
+    for (int r = 1; r < RARITY_COUNT; r++) {
+        next_row[r] = next_row[r - 1] + rarity_rows[r - 1];
+    }
+    for (const ItemDefinition& item : items) {
+        int r = std::clamp(static_cast<int>(item.rarity), 0, RARITY_COUNT - 1);
+        ordered[next_row[r]++] = &item;
+    }
+
+    //first pass: unique strings and list lengths, so the arena can be sized exactly
+    StringInterner interner;
+    size_t effect_total = 0;
+    size_t modifier_total = 0;
+    for (const ItemDefinition* item : ordered) {
+        interner.intern(item->name);
+        interner.intern(item->description);
+        interner.intern(item->flavor_text);
+        interner.intern(item->sprite_hint);
+        for (const std::string& effect : item->effects) {
+            interner.intern(effect);
+        }
+        for (const auto& modifier : item->modifiers) {
+            interner.intern(modifier.first);
+        }
+        effect_total += item->effects.size();
+        modifier_total += item->modifiers.size();
+    }
+    size_t string_count = interner.get_strings().size();
+
+    size_t bytes = 0;
+    bytes += PoolArena::bytes_for<int32_t>(count) * 3;
+    bytes += PoolArena::bytes_for<float>(count);
+    bytes += PoolArena::bytes_for<uint8_t>(count) * 2;
+    bytes += PoolArena::bytes_for<uint32_t>(count) * 8;
+    bytes += PoolArena::bytes_for<uint32_t>(effect_total);
+    bytes += PoolArena::bytes_for<uint32_t>(modifier_total);
+    bytes += PoolArena::bytes_for<float>(modifier_total);
+    bytes += PoolArena::bytes_for<uint32_t>(string_count) * 2;
+    bytes += PoolArena::bytes_for<char>(interner.get_text_bytes());
+    for (int t = 0; t <= TYPE_COUNT; t++) {
+        size_t rows = 0;
+        for (int r = 0; r < RARITY_COUNT; r++) {
+            size_t cell = t < TYPE_COUNT ? type_rows[r][t] : rarity_rows[r];
+            bytes += PoolArena::bytes_for<uint32_t>(cell);
+            rows += cell;
+        }
+        bytes += PoolArena::bytes_for<uint32_t>(rows) * 3;
+    }
+    arena.reset(bytes);
+
+    allocate_column(arena, damage, count);
+    allocate_column(arena, defense, count);
+    allocate_column(arena, healing, count);
+    allocate_column(arena, cooldown, count);
+    allocate_column(arena, rarity, count);
+    allocate_column(arena, type, count);
+    allocate_column(arena, name, count);
+    allocate_column(arena, description, count);
+    allocate_column(arena, flavor_text, count);
+    allocate_column(arena, sprite_hint, count);
+    allocate_column(arena, first_effect, count);
+    allocate_column(arena, effect_count, count);
+    allocate_column(arena, first_modifier, count);
+    allocate_column(arena, modifier_count, count);
+    allocate_column(arena, effects, effect_total);
+    allocate_column(arena, modifier_keys, modifier_total);
+    allocate_column(arena, modifier_values, modifier_total);
+    allocate_column(arena, string_offset, string_count);
+    allocate_column(arena, string_length, string_count);
+    allocate_column(arena, text, interner.get_text_bytes());
+    for (int r = 0; r < RARITY_COUNT; r++) {
+        for (int t = 0; t < TYPE_COUNT; t++) {
+            allocate_column(arena, by_rarity[r][t], type_rows[r][t]);
+        }
+        allocate_column(arena, by_rarity[r][TYPE_COUNT], rarity_rows[r]);
+    }
+    for (int t = 0; t <= TYPE_COUNT; t++) {
+        size_t rows = 0;
+        for (int r = 0; r < RARITY_COUNT; r++) {
+            rows += by_rarity[r][t].size();
+        }
+        allocate_column(arena, weighted[t].rows, rows);
+        allocate_column(arena, weighted[t].threshold, rows);
+        allocate_column(arena, weighted[t].alias, rows);
+    }
+
+    size_t offset = 0;
+    for (size_t id = 0; id < string_count; id++) {
+        std::string_view source = interner.get_strings()[id];
+        string_offset[id] = static_cast<uint32_t>(offset);
+        string_length[id] = static_cast<uint32_t>(source.size());
+        std::copy(source.begin(), source.end(), text.begin() + offset);
+        text[offset + source.size()] = '\0';
+        offset += source.size() + 1;
+    }
+
+    size_t effect_index = 0;
+    size_t modifier_index = 0;
+    for (size_t row = 0; row < count; row++) {
+        const ItemDefinition& item = *ordered[row];
+        damage[row] = item.damage;
+        defense[row] = item.defense;
+        healing[row] = item.healing;
+        cooldown[row] = item.cooldown;
+        rarity[row] = static_cast<uint8_t>(std::clamp(static_cast<int>(item.rarity), 0, RARITY_COUNT - 1));
+        type[row] = static_cast<uint8_t>(std::clamp(static_cast<int>(item.type), 0, TYPE_COUNT - 1));
+        name[row] = interner.find(item.name);
+        description[row] = interner.find(item.description);
+        flavor_text[row] = interner.find(item.flavor_text);
+        sprite_hint[row] = interner.find(item.sprite_hint);
+        first_effect[row] = static_cast<uint32_t>(effect_index);
+        effect_count[row] = static_cast<uint32_t>(item.effects.size());
+        for (const std::string& effect : item.effects) {
+            effects[effect_index++] = interner.find(effect);
+        }
+        first_modifier[row] = static_cast<uint32_t>(modifier_index);
+        modifier_count[row] = static_cast<uint32_t>(item.modifiers.size());
+        for (const auto& modifier : item.modifiers) {
+            modifier_keys[modifier_index] = interner.find(modifier.first);
+            modifier_values[modifier_index] = modifier.second;
+            modifier_index++;
+        }
+    }
+
+    clamp_stats();
+    build_tables();
+}
+
+void ItemStore::clamp_stats() {
+    size_t count = size();
+    std::vector<int32_t> limit(count);
+    for (size_t i = 0; i < count; i++) {
+        limit[i] = MAX_STAT[std::min<int>(rarity[i], RARITY_COUNT - 1)];
+    }
+
+    //plain min/max over contiguous columns, the compiler turns these into simd
+    int32_t* damage_column = damage.data;
+    int32_t* defense_column = defense.data;
+    int32_t* healing_column = healing.data;
+    float* cooldown_column = cooldown.data;
+    const int32_t* limit_column = limit.data();
+    for (size_t i = 0; i < count; i++) {
+        damage_column[i] = std::min(std::max(damage_column[i], 0), limit_column[i]);
+    }
+    for (size_t i = 0; i < count; i++) {
+        defense_column[i] = std::min(std::max(defense_column[i], 0), limit_column[i]);
+    }
+    for (size_t i = 0; i < count; i++) {
+        healing_column[i] = std::min(std::max(healing_column[i], 0), limit_column[i] * 2);
+    }
+    for (size_t i = 0; i < count; i++) {
+        cooldown_column[i] = std::min(std::max(cooldown_column[i], 0.0f), 60.0f);
+    }
+}
+
+void ItemStore::build_tables() {
+    size_t fill[RARITY_COUNT][TYPE_COUNT + 1] = {};
+    for (size_t row = 0; row < size(); row++) {
+        by_rarity[rarity[row]][type[row]][fill[rarity[row]][type[row]]++] = static_cast<uint32_t>(row);
+        by_rarity[rarity[row]][TYPE_COUNT][fill[rarity[row]][TYPE_COUNT]++] = static_cast<uint32_t>(row);
+    }
+
+    double rarity_weights[RARITY_COUNT];
+    for (int r = 0; r < RARITY_COUNT; r++) {
+        rarity_weights[r] = rarity_weight(static_cast<ItemRarity>(r), floor_number);
+    }
+
+    std::vector<double> scaled;
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+    for (int t = 0; t <= TYPE_COUNT; t++) {
+        AliasTable& table = weighted[t];
+
+        //each rarity's weight is split evenly over its items, so how many items the model
+        //returned per rarity doesn't change the rarity odds
+        double total = 0.0;
+        for (int r = 0; r < RARITY_COUNT; r++) {
+            if (!by_rarity[r][t].empty()) {
+                total += rarity_weights[r];
+            }
+        }
+        scaled.clear();
+        size_t slot = 0;
+        for (int r = 0; r < RARITY_COUNT; r++) {
+            const Column<uint32_t>& rows = by_rarity[r][t];
+            for (uint32_t row : rows) {
+                table.rows[slot++] = row;
+                scaled.push_back(rarity_weights[r] / rows.size());
+            }
+        }
+
+        size_t n = table.rows.size();
+        if (n == 0) {
+            continue;
+        }
+        small.clear();
+        large.clear();
+        for (size_t i = 0; i < n; i++) {
+            scaled[i] = scaled[i] * n / total;
+            table.threshold[i] = 0;
+            table.alias[i] = static_cast<uint32_t>(i);
+            (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+        }
+        while (!small.empty() && !large.empty()) {
+            uint32_t less = small.back();
+            small.pop_back();
+            uint32_t more = large.back();
+            table.threshold[less] = static_cast<uint32_t>(std::min(scaled[less] * 4294967296.0, 4294967295.0));
+            table.alias[less] = more;
+            scaled[more] -= 1.0 - scaled[less];
+            if (scaled[more] < 1.0) {
+                large.pop_back();
+                small.push_back(more);
+            }
+        }
+        //leftovers are 1 up to rounding, they always keep their own slot
+        for (uint32_t i : large) {
+            table.threshold[i] = UINT32_MAX;
+        }
+        for (uint32_t i : small) {
+            table.threshold[i] = UINT32_MAX;
+        }
+    }
+}
+
+int64_t ItemStore::sample(std::mt19937_64& rng, int rarity_filter, int type_filter) const {
+    int t = (type_filter >= 0 && type_filter < TYPE_COUNT) ? type_filter : TYPE_COUNT;
+
+    if (rarity_filter < 0 || rarity_filter >= RARITY_COUNT) {
+        const AliasTable& table = weighted[t];
+        if (table.rows.empty()) {
+            return -1;
+        }
+        uint64_t draw = rng();
+        uint32_t slot = uniform_index(draw, table.rows.size());
+        if (static_cast<uint32_t>(draw) >= table.threshold[slot]) {
+            slot = table.alias[slot];
+        }
+        return table.rows[slot];
+    }
+
+    //nearest rarity that has items: the asked one, then one below, one above, two below...
+    for (int distance = 0; distance < RARITY_COUNT; distance++) {
+        for (int r : {rarity_filter - distance, rarity_filter + distance}) {
+            if (r < 0 || r >= RARITY_COUNT) {
+                continue;
+            }
+            const Column<uint32_t>& rows = by_rarity[r][t];
+            if (!rows.empty()) {
+                return rows[uniform_index(rng(), rows.size())];
+            }
+        }
+    }
+    return -1;
+}
+
+ItemDefinition ItemStore::get_item(size_t row) const {
+    ItemDefinition item;
+    item.name = string_of(name[row]);
+    item.description = string_of(description[row]);
+    item.type = static_cast<ItemType>(type[row]);
+    item.rarity = static_cast<ItemRarity>(rarity[row]);
+    item.damage = damage[row];
+    item.defense = defense[row];
+    item.healing = healing[row];
+    item.cooldown = cooldown[row];
+    item.flavor_text = string_of(flavor_text[row]);
+    item.sprite_hint = string_of(sprite_hint[row]);
+    for (uint32_t i = 0; i < effect_count[row]; i++) {
+        item.effects.push_back(string_of(effects[first_effect[row] + i]));
+    }
+    for (uint32_t i = 0; i < modifier_count[row]; i++) {
+        item.modifiers[string_of(modifier_keys[first_modifier[row] + i])] = modifier_values[first_modifier[row] + i];
+    }
+    return item;
+}
+
+Dictionary ItemStore::to_dictionary(size_t row) const {
+    Dictionary dict;
+    dict["name"] = utf8_string(name[row]);
+    dict["description"] = utf8_string(description[row]);
+    dict["type"] = static_cast<int>(type[row]);
+    dict["rarity"] = static_cast<int>(rarity[row]);
+    dict["damage"] = damage[row];
+    dict["defense"] = defense[row];
+    dict["healing"] = healing[row];
+    dict["cooldown"] = cooldown[row];
+    dict["flavor_text"] = utf8_string(flavor_text[row]);
+    dict["sprite_hint"] = utf8_string(sprite_hint[row]);
+
+    Array effects_array;
+    for (uint32_t i = 0; i < effect_count[row]; i++) {
+        effects_array.append(utf8_string(effects[first_effect[row] + i]));
+    }
+    dict["effects"] = effects_array;
+
+    Dictionary modifiers_dict;
+    for (uint32_t i = 0; i < modifier_count[row]; i++) {
+        modifiers_dict[utf8_string(modifier_keys[first_modifier[row] + i])] = modifier_values[first_modifier[row] + i];
+    }
+    dict["modifiers"] = modifiers_dict;
+
+    return dict;
+}
+
+Array ItemStore::to_array(size_t begin, size_t end) const {
+    Array result;
+    end = std::min(end, size());
+    if (begin < end) {
+        result.resize(static_cast<int64_t>(end - begin));
+    }
+    for (size_t row = begin; row < end; row++) {
+        Dictionary dict = to_dictionary(row);
+        dict.make_read_only();
+        result[static_cast<int64_t>(row - begin)] = dict;
+    }
+    result.make_read_only();
+    return result;
+}
+
+} // namespace necronomicore
@@ -0,0 +1,388 @@
+#include "json_reader.h"
+#include <charconv>
+#include <cstring>
+
+namespace necronomicore {
+
+namespace {
+
+//pos on the opening quote, ends just past the closing one
+//only quotes can end a string, so jump from quote to quote and skip the escaped ones
+bool skip_string(std::string_view json, size_t& pos) {
+    const char* begin = json.data() + pos + 1;
+    const char* cursor = begin;
+    const char* end = json.data() + json.size();
+    while (cursor < end) {
+        const char* quote = static_cast<const char*>(std::memchr(cursor, '"', end - cursor));
+        if (!quote) {
+            return false;
+        }
+        //escaped if preceded by an odd run of backslashes
+        const char* back = quote;
+        while (back > begin && back[-1] == '\\') {
+            back--;
+        }
+        if ((quote - back) % 2 == 0) {
+            pos = (quote - json.data()) + 1;
+            return true;
+        }
+        cursor = quote + 1;
+    }
+    return false;
+}
+
+bool parse_index(std::string_view segment, size_t& index) {
+    if (segment.empty()) {
+        return false;
+    }
+    auto result = std::from_chars(segment.data(), segment.data() + segment.size(), index);
+    return result.ec == std::errc() && result.ptr == segment.data() + segment.size();
+}
+
+bool key_matches(std::string_view raw_key, std::string_view segment) {
+    std::string_view inner = raw_key.substr(1, raw_key.size() - 2);
+    if (inner.find('\\') == std::string_view::npos) {
+        return inner == segment;
+    }
+    std::string decoded;
+    return JSONReader::decode_string(raw_key, decoded) && decoded == segment;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool read_hex4(std::string_view text, size_t pos, uint32_t& value) {
+    if (pos + 4 > text.size()) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = pos; i < pos + 4; i++) {
+        int digit = hex_value(text[i]);
+        if (digit < 0) {
+            return false;
+        }
+        value = (value << 4) | static_cast<uint32_t>(digit);
+    }
+    return true;
+}
+
+//writes the utf-8 form of codepoint at dst and advances it
+void write_utf8(char*& dst, uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        *dst++ = static_cast<char>(codepoint);
+    } else if (codepoint < 0x800) {
+        *dst++ = static_cast<char>(0xC0 | (codepoint >> 6));
+        *dst++ = static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        *dst++ = static_cast<char>(0xE0 | (codepoint >> 12));
+        *dst++ = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        *dst++ = static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else {
+        *dst++ = static_cast<char>(0xF0 | (codepoint >> 18));
+        *dst++ = static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        *dst++ = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        *dst++ = static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+}
+
+} // anonymous namespace
+
+JSONReader::JSONReader(std::string_view buffer)
+    : json(buffer) {
+}
+
+void JSONReader::skip_whitespace(std::string_view json, size_t& pos) {
+    while (pos < json.size()) {
+        char c = json[pos];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+            return;
+        }
+        pos++;
+    }
+}
+
+bool JSONReader::read_string(std::string_view json, size_t& pos, std::string& out) {
+    skip_whitespace(json, pos);
+    if (pos >= json.size() || json[pos] != '"') {
+        return false;
+    }
+    size_t start = pos;
+    return skip_string(json, pos) && decode_string(json.substr(start, pos - start), out);
+}
+
+bool JSONReader::read_number(std::string_view json, size_t& pos, double& out) {
+    skip_whitespace(json, pos);
+    const char* start = json.data() + pos;
+    auto result = std::from_chars(start, json.data() + json.size(), out);
+    if (result.ec != std::errc()) {
+        return false;
+    }
+    pos += result.ptr - start;
+    return true;
+}
+
+bool JSONReader::skip_value(std::string_view json, size_t& pos) {
+    skip_whitespace(json, pos);
+    if (pos >= json.size()) {
+        return false;
+    }
+
+    char c = json[pos];
+    if (c == '"') {
+        return skip_string(json, pos);
+    }
+
+    if (c == '{' || c == '[') {
+        //only brackets outside strings matter, so counting depth is enough to find the end
+        int depth = 0;
+        while (pos < json.size()) {
+            c = json[pos];
+            if (c == '"') {
+                if (!skip_string(json, pos)) {
+                    return false;
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if (c == '}' || c == ']') {
+                depth--;
+                if (depth == 0) {
+                    pos++;
+                    return true;
+                }
+            }
+            pos++;
+        }
+        return false;
+    }
+
+    //number, true, false or null
+    size_t start = pos;
+    while (pos < json.size()) {
+        c = json[pos];
+        if (c == ',' || c == '}' || c == ']' || c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            break;
+        }
+        pos++;
+    }
+    return pos > start;
+}
+
+bool JSONReader::find(std::string_view path, std::string_view& raw) const {
+    size_t pos = 0;
+    size_t segment_start = 0;
+
+    while (segment_start < path.size()) {
+        size_t segment_end = path.find('/', segment_start);
+        if (segment_end == std::string_view::npos) {
+            segment_end = path.size();
+        }
+        std::string_view segment = path.substr(segment_start, segment_end - segment_start);
+        segment_start = segment_end + 1;
+
+        skip_whitespace(json, pos);
+        if (pos >= json.size()) {
+            return false;
+        }
+
+        if (json[pos] == '{') {
+            pos++;
+            while (true) {
+                skip_whitespace(json, pos);
+                if (pos >= json.size() || json[pos] != '"') {
+                    return false; //end of object (or malformed) without a match
+                }
+                size_t key_start = pos;
+                if (!skip_string(json, pos)) {
+                    return false;
+                }
+                std::string_view raw_key = json.substr(key_start, pos - key_start);
+
+                skip_whitespace(json, pos);
+                if (pos >= json.size() || json[pos] != ':') {
+                    return false;
+                }
+                pos++;
+
+                if (key_matches(raw_key, segment)) {
+                    break;
+                }
+                if (!skip_value(json, pos)) {
+                    return false;
+                }
+                skip_whitespace(json, pos);
+                if (pos >= json.size() || json[pos] != ',') {
+                    return false;
+                }
+                pos++;
+            }
+        } else if (json[pos] == '[') {
+            size_t index;
+            if (!parse_index(segment, index)) {
+                return false;
+            }
+            pos++;
+            for (size_t i = 0; i < index; i++) {
+                skip_whitespace(json, pos);
+                if (pos < json.size() && json[pos] == ']') {
+                    return false;
+                }
+                if (!skip_value(json, pos)) {
+                    return false;
+                }
+                skip_whitespace(json, pos);
+                if (pos >= json.size() || json[pos] != ',') {
+                    return false;
+                }
+                pos++;
+            }
+            skip_whitespace(json, pos);
+            if (pos >= json.size() || json[pos] == ']') {
+                return false;
+            }
+        } else {
+            return false; //path goes deeper than the document
+        }
+    }
+
+    skip_whitespace(json, pos);
+    size_t value_start = pos;
+    if (!skip_value(json, pos)) {
+        return false;
+    }
+    raw = json.substr(value_start, pos - value_start);
+    return true;
+}
+
+bool JSONReader::has(std::string_view path) const {
+    std::string_view raw;
+    return find(path, raw);
+}
+
+bool JSONReader::get_string(std::string_view path, std::string& out) const {
+    std::string_view raw;
+    if (find(path, raw) && decode_string(raw, out)) {
+        return true;
+    }
+    out.clear();
+    return false;
+}
+
+bool JSONReader::get_int(std::string_view path, int64_t& out) const {
+    std::string_view raw;
+    if (!find(path, raw)) {
+        return false;
+    }
+    auto result = std::from_chars(raw.data(), raw.data() + raw.size(), out);
+    if (result.ec == std::errc() && result.ptr == raw.data() + raw.size()) {
+        return true;
+    }
+    //"3.0" or "1e3"
+    double number;
+    auto fallback = std::from_chars(raw.data(), raw.data() + raw.size(), number);
+    if (fallback.ec != std::errc() || fallback.ptr != raw.data() + raw.size()) {
+        return false;
+    }
+    out = static_cast<int64_t>(number);
+    return true;
+}
+
+bool JSONReader::get_double(std::string_view path, double& out) const {
+    std::string_view raw;
+    if (!find(path, raw)) {
+        return false;
+    }
+    auto result = std::from_chars(raw.data(), raw.data() + raw.size(), out);
+    return result.ec == std::errc() && result.ptr == raw.data() + raw.size();
+}
+
+bool JSONReader::get_bool(std::string_view path, bool& out) const {
+    std::string_view raw;
+    if (!find(path, raw)) {
+        return false;
+    }
+    if (raw == "true" || raw == "false") {
+        out = raw == "true";
+        return true;
+    }
+    return false;
+}
+
+bool JSONReader::decode_string(std::string_view raw, std::string& out) {
+    if (raw.size() < 2 || raw.front() != '"' || raw.back() != '"') {
+        return false;
+    }
+    std::string_view text = raw.substr(1, raw.size() - 2);
+
+    out.clear();
+    size_t escape = text.find('\\');
+    if (escape == std::string_view::npos) {
+        out.assign(text.data(), text.size());
+        return true;
+    }
+
+    //decoding never grows the text (\uXXXX is 6 bytes for at most 3, a pair 12 for 4),
+    //so write into a buffer of the escaped size and trim it at the end
+    out.resize(text.size());
+    char* dst = &out[0];
+    size_t pos = 0;
+    while (escape != std::string_view::npos) {
+        std::memcpy(dst, text.data() + pos, escape - pos);
+        dst += escape - pos;
+        if (escape + 1 >= text.size()) {
+            out.clear();
+            return false;
+        }
+
+        char code = text[escape + 1];
+        pos = escape + 2;
+        switch (code) {
+            case '"': *dst++ = '"'; break;
+            case '\\': *dst++ = '\\'; break;
+            case '/': *dst++ = '/'; break;
+            case 'b': *dst++ = '\b'; break;
+            case 'f': *dst++ = '\f'; break;
+            case 'n': *dst++ = '\n'; break;
+            case 'r': *dst++ = '\r'; break;
+            case 't': *dst++ = '\t'; break;
+            case 'u': {
+                uint32_t codepoint;
+                if (!read_hex4(text, pos, codepoint)) {
+                    out.clear();
+                    return false;
+                }
+                pos += 4;
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                    //high surrogate, only valid followed by \u low surrogate
+                    uint32_t low;
+                    if (pos + 6 <= text.size() && text[pos] == '\\' && text[pos + 1] == 'u' &&
+                        read_hex4(text, pos + 2, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                        pos += 6;
+                    } else {
+                        codepoint = 0xFFFD;
+                    }
+                } else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+                    codepoint = 0xFFFD;
+                }
+                write_utf8(dst, codepoint);
+                break;
+            }
+            default:
+                out.clear();
+                return false;
+        }
+        escape = text.find('\\', pos);
+    }
+    std::memcpy(dst, text.data() + pos, text.size() - pos);
+    dst += text.size() - pos;
+    out.resize(dst - out.data());
+    return true;
+}
+
+} // namespace necronomicore
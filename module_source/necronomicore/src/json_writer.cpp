@@ -0,0 +1,135 @@
+#include "json_writer.h"
+#include <charconv>
+#include <cmath>
+
+namespace necronomicore {
+
+JSONWriter::JSONWriter(std::string& buffer)
+    : out(buffer), need_comma(false) {
+}
+
+void JSONWriter::separate() {
+    if (need_comma) {
+        out.push_back(',');
+    }
+    need_comma = true;
+}
+
+void JSONWriter::begin_object() {
+    separate();
+    out.push_back('{');
+    need_comma = false;
+}
+
+void JSONWriter::end_object() {
+    out.push_back('}');
+    need_comma = true;
+}
+
+void JSONWriter::begin_array() {
+    separate();
+    out.push_back('[');
+    need_comma = false;
+}
+
+void JSONWriter::end_array() {
+    out.push_back(']');
+    need_comma = true;
+}
+
+void JSONWriter::key(std::string_view name) {
+    separate();
+    write_string(out, name);
+    out.push_back(':');
+    need_comma = false;
+}
+
+void JSONWriter::value(std::string_view text) {
+    separate();
+    write_string(out, text);
+}
+
+void JSONWriter::value(const char* text) {
+    value(std::string_view(text));
+}
+
+void JSONWriter::value(int64_t number) {
+    separate();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+}
+
+void JSONWriter::value(int number) {
+    value(static_cast<int64_t>(number));
+}
+
+void JSONWriter::value(double number) {
+    separate();
+    //json has no nan/inf
+    if (!std::isfinite(number)) {
+        out.append("null");
+        return;
+    }
+    //shortest text that round-trips, 0.8 stays "0.8"
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+}
+
+void JSONWriter::value(float number) {
+    separate();
+    if (!std::isfinite(number)) {
+        out.append("null");
+        return;
+    }
+    //formatted as a float so 0.8f is "0.8", not "0.800000011920929"
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+}
+
+void JSONWriter::value(bool flag) {
+    separate();
+    out.append(flag ? "true" : "false");
+}
+
+void JSONWriter::null_value() {
+    separate();
+    out.append("null");
+}
+
+void JSONWriter::write_string(std::string& out, std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+
+    out.push_back('"');
+    //copy runs that need no escaping in one go, utf-8 passes through untouched
+    size_t run_start = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        out.append(text.data() + run_start, i - run_start);
+        run_start = i + 1;
+        switch (c) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            case '\b': out.append("\\b"); break;
+            case '\f': out.append("\\f"); break;
+            default: {
+                char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                out.append(escaped, sizeof(escaped));
+                break;
+            }
+        }
+    }
+    out.append(text.data() + run_start, text.size() - run_start);
+    out.push_back('"');
+}
+
+} // namespace necronomicore
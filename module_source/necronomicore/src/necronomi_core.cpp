@@ -1,10 +1,14 @@
 #include "necronomi_core.h"
 #include "openai_client.h"
+#include "http_client.h"
 #include "item_generation_service.h"
 #include "emotion_dialog_service.h"
 #include "random_roll_service.h"
+#include "response_cache.h"
+#include "benchmarks.h"
 
 #include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
 
 using namespace godot;
@@ -13,7 +17,25 @@ namespace necronomicore {
 
 NecronomiCore* NecronomiCore::singleton = nullptr;
 
-NecronomiCore::NecronomiCore() : initialized(false) {
+NecronomiCore::NecronomiCore()
+    : network_worker_count(2),
+      max_in_flight_requests(4),
+      dialog_streaming(false),
+      dialog_history_length(4),
+      response_cache_enabled(true),
+      response_cache_ttl(24 * 60 * 60),
+      requests_per_minute(60.0),
+      tokens_per_minute(40000.0),
+      max_request_retries(3),
+      item_prefetch_depth(1),
+      item_pool_store_enabled(true),
+      item_random_seed(-1),
+      item_generation_shards(3),
+      item_pool_min_ready(3),
+      item_pool_top_up(true),
+      item_pool_procedural_fill(true),
+      item_pool_memory_limit(8 * 1024 * 1024),
+      initialized(false) {
     ERR_FAIL_COND_MSG(singleton != nullptr, "NecronomiCore singleton already exists!");
     singleton = this;
 }
@@ -30,17 +52,78 @@ void NecronomiCore::_bind_methods() {
     //properties
     ClassDB::bind_method(D_METHOD("set_api_key", "key"), &NecronomiCore::set_api_key);
     ClassDB::bind_method(D_METHOD("get_api_key"), &NecronomiCore::get_api_key);
+    ClassDB::bind_method(D_METHOD("set_base_url", "url"), &NecronomiCore::set_base_url);
+    ClassDB::bind_method(D_METHOD("get_base_url"), &NecronomiCore::get_base_url);
+    ClassDB::bind_method(D_METHOD("set_network_worker_count", "count"), &NecronomiCore::set_network_worker_count);
+    ClassDB::bind_method(D_METHOD("get_network_worker_count"), &NecronomiCore::get_network_worker_count);
+    ClassDB::bind_method(D_METHOD("set_max_in_flight_requests", "count"), &NecronomiCore::set_max_in_flight_requests);
+    ClassDB::bind_method(D_METHOD("get_max_in_flight_requests"), &NecronomiCore::get_max_in_flight_requests);
+    ClassDB::bind_method(D_METHOD("set_dialog_streaming", "enabled"), &NecronomiCore::set_dialog_streaming);
+    ClassDB::bind_method(D_METHOD("is_dialog_streaming"), &NecronomiCore::is_dialog_streaming);
+    ClassDB::bind_method(D_METHOD("set_dialog_history_length", "turns"), &NecronomiCore::set_dialog_history_length);
+    ClassDB::bind_method(D_METHOD("get_dialog_history_length"), &NecronomiCore::get_dialog_history_length);
+    ClassDB::bind_method(D_METHOD("set_response_cache_enabled", "enabled"), &NecronomiCore::set_response_cache_enabled);
+    ClassDB::bind_method(D_METHOD("is_response_cache_enabled"), &NecronomiCore::is_response_cache_enabled);
+    ClassDB::bind_method(D_METHOD("set_response_cache_ttl", "seconds"), &NecronomiCore::set_response_cache_ttl);
+    ClassDB::bind_method(D_METHOD("get_response_cache_ttl"), &NecronomiCore::get_response_cache_ttl);
+    ClassDB::bind_method(D_METHOD("set_rate_limits", "requests_per_minute", "tokens_per_minute"), &NecronomiCore::set_rate_limits);
+    ClassDB::bind_method(D_METHOD("set_max_request_retries", "retries"), &NecronomiCore::set_max_request_retries);
+    ClassDB::bind_method(D_METHOD("get_max_request_retries"), &NecronomiCore::get_max_request_retries);
+    ClassDB::bind_method(D_METHOD("set_item_prefetch_depth", "floors"), &NecronomiCore::set_item_prefetch_depth);
+    ClassDB::bind_method(D_METHOD("get_item_prefetch_depth"), &NecronomiCore::get_item_prefetch_depth);
+    ClassDB::bind_method(D_METHOD("set_item_pool_store_enabled", "enabled"), &NecronomiCore::set_item_pool_store_enabled);
+    ClassDB::bind_method(D_METHOD("is_item_pool_store_enabled"), &NecronomiCore::is_item_pool_store_enabled);
+    ClassDB::bind_method(D_METHOD("set_item_random_seed", "seed"), &NecronomiCore::set_item_random_seed);
+    ClassDB::bind_method(D_METHOD("get_item_random_seed"), &NecronomiCore::get_item_random_seed);
+    ClassDB::bind_method(D_METHOD("set_item_generation_shards", "shards"), &NecronomiCore::set_item_generation_shards);
+    ClassDB::bind_method(D_METHOD("get_item_generation_shards"), &NecronomiCore::get_item_generation_shards);
+    ClassDB::bind_method(D_METHOD("set_item_pool_min_ready", "items"), &NecronomiCore::set_item_pool_min_ready);
+    ClassDB::bind_method(D_METHOD("get_item_pool_min_ready"), &NecronomiCore::get_item_pool_min_ready);
+    ClassDB::bind_method(D_METHOD("set_item_pool_top_up_enabled", "enabled"), &NecronomiCore::set_item_pool_top_up_enabled);
+    ClassDB::bind_method(D_METHOD("is_item_pool_top_up_enabled"), &NecronomiCore::is_item_pool_top_up_enabled);
+    ClassDB::bind_method(D_METHOD("set_item_pool_procedural_fill_enabled", "enabled"), &NecronomiCore::set_item_pool_procedural_fill_enabled);
+    ClassDB::bind_method(D_METHOD("is_item_pool_procedural_fill_enabled"), &NecronomiCore::is_item_pool_procedural_fill_enabled);
+    ClassDB::bind_method(D_METHOD("set_item_pool_memory_limit", "bytes"), &NecronomiCore::set_item_pool_memory_limit);
+    ClassDB::bind_method(D_METHOD("get_item_pool_memory_limit"), &NecronomiCore::get_item_pool_memory_limit);
     ClassDB::bind_method(D_METHOD("is_initialized"), &NecronomiCore::is_initialized);
     ClassDB::bind_method(D_METHOD("initialize"), &NecronomiCore::initialize);
 
     //service methods
     ClassDB::bind_method(D_METHOD("request_item_generation", "config"), &NecronomiCore::request_item_generation);
+    ClassDB::bind_method(D_METHOD("start_item_run", "config"), &NecronomiCore::start_item_run);
+    ClassDB::bind_method(D_METHOD("advance_to_floor", "floor"), &NecronomiCore::advance_to_floor);
+    ClassDB::bind_method(D_METHOD("get_random_item", "rarity", "type"), &NecronomiCore::get_random_item, DEFVAL(-1), DEFVAL(-1));
+    ClassDB::bind_method(D_METHOD("get_item_pool_items", "offset", "count"), &NecronomiCore::get_item_pool_items, DEFVAL(0), DEFVAL(-1));
+    ClassDB::bind_method(D_METHOD("export_item_pool"), &NecronomiCore::export_item_pool);
+    ClassDB::bind_method(D_METHOD("get_item_pool_version"), &NecronomiCore::get_item_pool_version);
     ClassDB::bind_method(D_METHOD("request_emotion_dialog", "npc_name", "context", "personality"), &NecronomiCore::request_emotion_dialog);
+    ClassDB::bind_method(D_METHOD("prefetch_emotion_dialog", "npc_name", "context", "personality"), &NecronomiCore::prefetch_emotion_dialog);
+    ClassDB::bind_method(D_METHOD("prepare_dialog_lines", "npc_name", "personality", "locations"), &NecronomiCore::prepare_dialog_lines);
+    ClassDB::bind_method(D_METHOD("get_dialog_line", "npc_name", "kind", "location"), &NecronomiCore::get_dialog_line, DEFVAL(String()));
+    ClassDB::bind_method(D_METHOD("get_environmental_message", "location", "danger_level"), &NecronomiCore::get_environmental_message, DEFVAL(1));
+    ClassDB::bind_method(D_METHOD("prepare_environmental_messages", "location", "danger_level"), &NecronomiCore::prepare_environmental_messages, DEFVAL(1));
     ClassDB::bind_method(D_METHOD("generate_random_roll", "min_value", "max_value", "context"), &NecronomiCore::generate_random_roll);
 
+    //diagnostics
+    ClassDB::bind_method(D_METHOD("get_network_stats"), &NecronomiCore::get_network_stats);
+    ClassDB::bind_method(D_METHOD("get_queue_stats"), &NecronomiCore::get_queue_stats);
+    ClassDB::bind_method(D_METHOD("get_cache_stats"), &NecronomiCore::get_cache_stats);
+    ClassDB::bind_method(D_METHOD("get_item_prefetch_status"), &NecronomiCore::get_item_prefetch_status);
+    ClassDB::bind_method(D_METHOD("get_item_pool_memory_stats"), &NecronomiCore::get_item_pool_memory_stats);
+    ClassDB::bind_method(D_METHOD("get_dialog_memory_stats"), &NecronomiCore::get_dialog_memory_stats);
+    ClassDB::bind_method(D_METHOD("get_dialog_prefetch_stats"), &NecronomiCore::get_dialog_prefetch_stats);
+    ClassDB::bind_method(D_METHOD("get_dialog_line_stats"), &NecronomiCore::get_dialog_line_stats);
+    ClassDB::bind_method(D_METHOD("get_environmental_message_stats"), &NecronomiCore::get_environmental_message_stats);
+    ClassDB::bind_method(D_METHOD("clear_response_cache"), &NecronomiCore::clear_response_cache);
+    ClassDB::bind_method(D_METHOD("clear_item_pool_store"), &NecronomiCore::clear_item_pool_store);
+    ClassDB::bind_method(D_METHOD("run_benchmark", "name", "options"), &NecronomiCore::run_benchmark, DEFVAL(Dictionary()));
+
     //signals
     ADD_SIGNAL(MethodInfo("item_pool_ready", PropertyInfo(Variant::ARRAY, "items")));
+    ADD_SIGNAL(MethodInfo("item_pool_updated", PropertyInfo(Variant::ARRAY, "items")));
+    ADD_SIGNAL(MethodInfo("item_generated", PropertyInfo(Variant::DICTIONARY, "item")));
     ADD_SIGNAL(MethodInfo("dialog_ready", PropertyInfo(Variant::STRING, "dialog_text")));
+    ADD_SIGNAL(MethodInfo("dialog_chunk", PropertyInfo(Variant::STRING, "chunk_text")));
     ADD_SIGNAL(MethodInfo("request_failed", PropertyInfo(Variant::STRING, "error_message")));
 }
 
@@ -55,6 +138,191 @@ String NecronomiCore::get_api_key() const {
     return api_key;
 }
 
+void NecronomiCore::set_base_url(const String& url) {
+    base_url = url;
+    if (openai_client && !url.is_empty()) {
+        openai_client->set_base_url(url.utf8().get_data());
+    }
+}
+
+String NecronomiCore::get_base_url() const {
+    if (openai_client) {
+        return String(openai_client->get_base_url().c_str());
+    }
+    return base_url;
+}
+
+void NecronomiCore::set_network_worker_count(int count) {
+    network_worker_count = count > 0 ? count : 1;
+    if (openai_client) {
+        openai_client->set_worker_count(network_worker_count);
+    }
+}
+
+int NecronomiCore::get_network_worker_count() const {
+    return network_worker_count;
+}
+
+void NecronomiCore::set_max_in_flight_requests(int count) {
+    max_in_flight_requests = count > 0 ? count : 1;
+    if (openai_client) {
+        openai_client->set_max_in_flight(max_in_flight_requests);
+    }
+}
+
+int NecronomiCore::get_max_in_flight_requests() const {
+    return max_in_flight_requests;
+}
+
+void NecronomiCore::set_dialog_streaming(bool enabled) {
+    dialog_streaming = enabled;
+}
+
+bool NecronomiCore::is_dialog_streaming() const {
+    return dialog_streaming;
+}
+
+void NecronomiCore::set_dialog_history_length(int turns) {
+    dialog_history_length = turns > 1 ? turns : 1;
+    if (dialog_service) {
+        dialog_service->set_history_length(dialog_history_length);
+    }
+}
+
+int NecronomiCore::get_dialog_history_length() const {
+    return dialog_history_length;
+}
+
+void NecronomiCore::set_response_cache_enabled(bool enabled) {
+    response_cache_enabled = enabled;
+    if (openai_client) {
+        openai_client->set_cache_enabled(enabled);
+    }
+}
+
+bool NecronomiCore::is_response_cache_enabled() const {
+    return response_cache_enabled;
+}
+
+void NecronomiCore::set_response_cache_ttl(int seconds) {
+    response_cache_ttl = seconds > 0 ? seconds : 1;
+    if (openai_client) {
+        openai_client->set_cache_ttl(response_cache_ttl);
+    }
+}
+
+int NecronomiCore::get_response_cache_ttl() const {
+    return response_cache_ttl;
+}
+
+void NecronomiCore::set_rate_limits(double requests, double tokens) {
+    //starting budgets, the server's rate-limit headers take over once responses arrive
+    requests_per_minute = requests > 0.0 ? requests : 1.0;
+    tokens_per_minute = tokens > 0.0 ? tokens : 1.0;
+    if (openai_client) {
+        openai_client->set_rate_limits(requests_per_minute, tokens_per_minute);
+    }
+}
+
+void NecronomiCore::set_max_request_retries(int retries) {
+    max_request_retries = retries > 0 ? retries : 0;
+    if (openai_client) {
+        openai_client->set_max_retries(max_request_retries);
+    }
+}
+
+int NecronomiCore::get_max_request_retries() const {
+    return max_request_retries;
+}
+
+void NecronomiCore::set_item_prefetch_depth(int floors) {
+    item_prefetch_depth = floors > 0 ? floors : 0;
+    if (item_service) {
+        item_service->set_prefetch_depth(item_prefetch_depth);
+    }
+}
+
+int NecronomiCore::get_item_prefetch_depth() const {
+    return item_service ? item_service->get_prefetch_depth() : item_prefetch_depth;
+}
+
+void NecronomiCore::set_item_pool_store_enabled(bool enabled) {
+    item_pool_store_enabled = enabled;
+    if (item_service) {
+        item_service->set_pool_store_enabled(enabled);
+    }
+}
+
+bool NecronomiCore::is_item_pool_store_enabled() const {
+    return item_pool_store_enabled;
+}
+
+void NecronomiCore::set_item_random_seed(int64_t seed) {
+    item_random_seed = seed >= 0 ? seed : -1;
+    if (item_service && item_random_seed >= 0) {
+        item_service->set_random_seed(static_cast<uint64_t>(item_random_seed));
+    }
+}
+
+int64_t NecronomiCore::get_item_random_seed() const {
+    return item_random_seed;
+}
+
+void NecronomiCore::set_item_generation_shards(int shards) {
+    item_generation_shards = shards > 0 ? shards : 1;
+    if (item_service) {
+        item_service->set_shard_count(item_generation_shards);
+    }
+}
+
+int NecronomiCore::get_item_generation_shards() const {
+    return item_service ? item_service->get_shard_count() : item_generation_shards;
+}
+
+void NecronomiCore::set_item_pool_min_ready(int items) {
+    item_pool_min_ready = items > 0 ? items : 1;
+    if (item_service) {
+        item_service->set_min_ready_items(item_pool_min_ready);
+    }
+}
+
+int NecronomiCore::get_item_pool_min_ready() const {
+    return item_pool_min_ready;
+}
+
+void NecronomiCore::set_item_pool_top_up_enabled(bool enabled) {
+    item_pool_top_up = enabled;
+    if (item_service) {
+        item_service->set_top_up_enabled(enabled);
+    }
+}
+
+bool NecronomiCore::is_item_pool_top_up_enabled() const {
+    return item_pool_top_up;
+}
+
+void NecronomiCore::set_item_pool_memory_limit(int64_t bytes) {
+    item_pool_memory_limit = bytes > 0 ? bytes : 0;
+    if (item_service) {
+        item_service->set_pool_memory_limit(static_cast<size_t>(item_pool_memory_limit));
+    }
+}
+
+int64_t NecronomiCore::get_item_pool_memory_limit() const {
+    return item_pool_memory_limit;
+}
+
+void NecronomiCore::set_item_pool_procedural_fill_enabled(bool enabled) {
+    item_pool_procedural_fill = enabled;
+    if (item_service) {
+        item_service->set_procedural_fill_enabled(enabled);
+    }
+}
+
+bool NecronomiCore::is_item_pool_procedural_fill_enabled() const {
+    return item_pool_procedural_fill;
+}
+
 bool NecronomiCore::is_initialized() const {
     return initialized;
 }
@@ -74,10 +342,43 @@ void NecronomiCore::initialize() {
     //create openai client
     openai_client = std::make_shared<OpenAIClient>();
     openai_client->set_api_key(api_key.utf8().get_data());
+    if (!base_url.is_empty()) {
+        openai_client->set_base_url(base_url.utf8().get_data());
+    }
+    openai_client->set_worker_count(network_worker_count);
+    openai_client->set_max_in_flight(max_in_flight_requests);
+    openai_client->set_cache_enabled(response_cache_enabled);
+    openai_client->set_cache_ttl(response_cache_ttl);
+    openai_client->set_rate_limits(requests_per_minute, tokens_per_minute);
+    openai_client->set_max_retries(max_request_retries);
+
+    //persistent cache tier, survives restarts
+    String cache_path = ProjectSettings::get_singleton()->globalize_path("user://necronomicore_response_cache.bin");
+    if (!openai_client->open_cache_file(cache_path.utf8().get_data())) {
+        UtilityFunctions::push_warning("NecronomiCore: response cache file unavailable, caching in memory only");
+    }
 
     //create services
     item_service = std::make_shared<ItemGenerationService>(openai_client);
+    item_service->set_prefetch_depth(item_prefetch_depth);
+    item_service->set_pool_store_enabled(item_pool_store_enabled);
+    if (item_random_seed >= 0) {
+        item_service->set_random_seed(static_cast<uint64_t>(item_random_seed));
+    }
+    item_service->set_shard_count(item_generation_shards);
+    item_service->set_min_ready_items(item_pool_min_ready);
+    item_service->set_top_up_enabled(item_pool_top_up);
+    item_service->set_pool_memory_limit(static_cast<size_t>(item_pool_memory_limit));
+    item_service->set_procedural_fill_enabled(item_pool_procedural_fill);
+
+    //generated pools persist per run config, a restart maps them back instead of regenerating
+    String pool_path = ProjectSettings::get_singleton()->globalize_path("user://necronomicore_item_pools");
+    if (!item_service->open_pool_store(pool_path.utf8().get_data())) {
+        UtilityFunctions::push_warning("NecronomiCore: item pool store unavailable, pools will not persist");
+    }
+
     dialog_service = std::make_shared<EmotionDialogService>(openai_client);
+    dialog_service->set_history_length(dialog_history_length);
     roll_service = std::make_shared<RandomRollService>(openai_client);
 
     initialized = true;
@@ -90,20 +391,95 @@ void NecronomiCore::request_item_generation(const Dictionary& config) {
         return;
     }
 
-    //async item generation
+    //async item generation, each item announced as it streams in, the pool ready once
+    //enough are in and updated as the rest land
     item_service->generate_item_pool(config,
         [this](const std::string& pool_id) {
             //success
+            item_query_pool = pool_id;
             Array items = item_service->get_all_items_in_pool(pool_id);
             emit_signal("item_pool_ready", items);
         },
         [this](const std::string& error) {
             //error
             emit_signal("request_failed", String(error.c_str()));
+        },
+        [this](const std::string& pool_id) {
+            item_query_pool = pool_id;
+            emit_signal("item_pool_updated", item_service->get_all_items_in_pool(pool_id));
+        },
+        [this](const ItemDefinition& item) {
+            emit_signal("item_generated", item.to_dictionary());
         }
     );
 }
 
+void NecronomiCore::start_item_run(const Dictionary& config) {
+    if (!initialized) {
+        emit_signal("request_failed", "NecronomiCore not initialized");
+        return;
+    }
+
+    //pools for the starting floor and the next ones generate in the background
+    item_query_pool.clear();
+    item_service->start_run(config);
+}
+
+void NecronomiCore::advance_to_floor(int floor) {
+    if (!initialized) {
+        UtilityFunctions::push_error("NecronomiCore not initialized");
+        return;
+    }
+
+    item_service->advance_to_floor(floor);
+}
+
+Dictionary NecronomiCore::get_random_item(int rarity, int type) {
+    if (!initialized) {
+        UtilityFunctions::push_error("NecronomiCore not initialized");
+        return Dictionary();
+    }
+
+    //never waits: serves the current floor's pool, or the last one until it arrives
+    //-1 (or out of range) leaves rarity to the floor's odds and type open
+    if (type < 0 || type >= ItemStore::TYPE_COUNT) {
+        type = ItemStore::ANY;
+    }
+    if (rarity < 0 || rarity > static_cast<int>(ItemRarity::CURSED)) {
+        return item_service->get_random_item_any_rarity(type);
+    }
+    return item_service->get_random_item(static_cast<ItemRarity>(rarity), type);
+}
+
+Array NecronomiCore::get_item_pool_items(int64_t offset, int64_t count) {
+    if (!initialized) {
+        UtilityFunctions::push_error("NecronomiCore not initialized");
+        return Array();
+    }
+
+    //the last pool item_pool_ready/item_pool_updated announced, or the current floor's
+    //during a run; the whole pool is one cached read-only array until the pool changes
+    if (offset <= 0 && count < 0) {
+        return item_service->get_all_items_in_pool(item_query_pool);
+    }
+    return item_service->get_items_range(item_query_pool, offset, count);
+}
+
+PackedByteArray NecronomiCore::export_item_pool() {
+    if (!initialized) {
+        UtilityFunctions::push_error("NecronomiCore not initialized");
+        return PackedByteArray();
+    }
+    return item_service->export_pool(item_query_pool);
+}
+
+int64_t NecronomiCore::get_item_pool_version() const {
+    if (!item_service) {
+        return 0;
+    }
+    return static_cast<int64_t>(item_service->get_pool_version(item_query_pool));
+}
+
 void NecronomiCore::request_emotion_dialog(const String& npc_name, const String& context, const Dictionary& personality) {
     if (!initialized) {
         emit_signal("request_failed", "NecronomiCore not initialized");
@@ -114,19 +490,106 @@ void NecronomiCore::request_emotion_dialog(const String& npc_name, const String&
     dialog_service->register_npc(npc_name, personality);
 
     //generate dialog
+    //the scene description goes into the prompt as what the player just did
     Dictionary ctx;
     ctx["context"] = context;
+    ctx["recent_action"] = context;
+    
+    //streamed text arrives as dialog_chunk, the full line still comes as dialog_ready
+    std::function<void(const std::string&)> on_chunk;
+    if (dialog_streaming) {
+        on_chunk = [this](const std::string& chunk) {
+            emit_signal("dialog_chunk", String::utf8(chunk.data(), chunk.size()));
+        };
+    }
     
     dialog_service->generate_dialog(npc_name, "", ctx,
         [this](const std::string& dialog) {
-            emit_signal("dialog_ready", String(dialog.c_str()));
+            emit_signal("dialog_ready", String::utf8(dialog.data(), dialog.size()));
         },
         [this](const std::string& error) {
             emit_signal("request_failed", String(error.c_str()));
-        }
+        },
+        on_chunk
     );
 }
 
+void NecronomiCore::prefetch_emotion_dialog(const String& npc_name, const String& context, const Dictionary& personality) {
+    if (!initialized) {
+        return;
+    }
+
+    //same registration and context as request_emotion_dialog, or the prefetched line never matches
+    dialog_service->register_npc(npc_name, personality);
+
+    Dictionary ctx;
+    ctx["context"] = context;
+    ctx["recent_action"] = context;
+    dialog_service->prefetch_dialog(npc_name, ctx);
+}
+
+void NecronomiCore::prepare_dialog_lines(const String& npc_name, const Dictionary& personality, const Array& locations) {
+    if (!initialized) {
+        return;
+    }
+
+    //banks are keyed by the mood in this personality, one request per location bucket
+    dialog_service->register_npc(npc_name, personality);
+    if (locations.is_empty()) {
+        dialog_service->fill_line_bank(npc_name, String());
+        return;
+    }
+    for (int i = 0; i < locations.size(); i++) {
+        dialog_service->fill_line_bank(npc_name, locations[i]);
+    }
+}
+
+String NecronomiCore::get_dialog_line(const String& npc_name, const String& kind, const String& location) {
+    if (!initialized) {
+        return String();
+    }
+
+    CharString kind_name = kind.utf8();
+    DialogLineKind line_kind;
+    if (!EmotionDialogService::parse_line_kind(std::string_view(kind_name.get_data(), kind_name.length()), line_kind)) {
+        UtilityFunctions::push_error("NecronomiCore: unknown dialog line kind ", kind);
+        return String();
+    }
+    std::string line;
+    if (!dialog_service->get_bank_line(npc_name, line_kind, location, line)) {
+        return String();
+    }
+    return String::utf8(line.data(), line.size());
+}
+
+String NecronomiCore::get_environmental_message(const String& location, int danger_level) {
+    if (!initialized) {
+        return String();
+    }
+
+    Dictionary context;
+    context["location"] = location;
+    context["danger_level"] = danger_level;
+
+    //the callback runs before generate_environmental_message returns
+    String message;
+    dialog_service->generate_environmental_message(context, [&message](const std::string& text) {
+        message = String::utf8(text.data(), text.size());
+    });
+    return message;
+}
+
+void NecronomiCore::prepare_environmental_messages(const String& location, int danger_level) {
+    if (!initialized) {
+        return;
+    }
+
+    Dictionary context;
+    context["location"] = location;
+    context["danger_level"] = danger_level;
+    dialog_service->fill_environmental_messages(context);
+}
+
 int NecronomiCore::generate_random_roll(int min_value, int max_value, const String& context) {
     if (!initialized) {
         UtilityFunctions::push_error("NecronomiCore not initialized");
@@ -137,14 +600,177 @@ int NecronomiCore::generate_random_roll(int min_value, int max_value, const Stri
     return result.get("value", 0);
 }
 
+Dictionary NecronomiCore::get_network_stats() const {
+    Dictionary stats;
+    if (!openai_client) {
+        return stats;
+    }
+
+    HTTPClientStats http = openai_client->get_http_stats();
+    stats["requests"] = static_cast<int64_t>(http.requests);
+    stats["connections_opened"] = static_cast<int64_t>(http.connections_opened);
+    stats["connections_reused"] = static_cast<int64_t>(http.connections_reused);
+    stats["tls_handshakes"] = static_cast<int64_t>(http.tls_handshakes);
+    stats["tls_sessions_resumed"] = static_cast<int64_t>(http.tls_sessions_resumed);
+    stats["queued"] = openai_client->get_queued_count();
+    stats["in_flight"] = openai_client->get_in_flight_count();
+    stats["coalesced"] = static_cast<int64_t>(openai_client->get_coalesced_count());
+
+    RateLimiterStats limits = openai_client->get_rate_limit_stats();
+    stats["rate_limit_requests_available"] = limits.requests_available;
+    stats["rate_limit_tokens_available"] = limits.tokens_available;
+    stats["rate_limit_requests_per_minute"] = limits.requests_per_second * 60.0;
+    stats["rate_limit_tokens_per_minute"] = limits.tokens_per_second * 60.0;
+    stats["rate_limit_paused_seconds"] = limits.paused_seconds;
+    stats["rate_limited_responses"] = static_cast<int64_t>(limits.throttled_responses);
+
+    CircuitStats circuit = openai_client->get_circuit_stats(CHAT_COMPLETIONS_ENDPOINT);
+    const char* circuit_states[] = {"closed", "open", "half_open"};
+    stats["retries"] = static_cast<int64_t>(openai_client->get_retried_count());
+    stats["circuit_state"] = circuit_states[static_cast<int>(circuit.state)];
+    stats["circuit_trips"] = static_cast<int64_t>(circuit.trips);
+    stats["circuit_fast_failures"] = static_cast<int64_t>(circuit.fast_failures);
+    stats["circuit_probes"] = static_cast<int64_t>(circuit.probes);
+    stats["prompt_tokens"] = static_cast<int64_t>(openai_client->get_prompt_tokens_used());
+    stats["completion_tokens"] = static_cast<int64_t>(openai_client->get_completion_tokens_used());
+    stats["cached_prompt_tokens"] = static_cast<int64_t>(openai_client->get_cached_prompt_tokens_used());
+    return stats;
+}
+
+Dictionary NecronomiCore::get_queue_stats() const {
+    Dictionary stats;
+    if (!openai_client) {
+        return stats;
+    }
+
+    const char* class_names[REQUEST_PRIORITY_COUNT] = {"interactive", "gameplay", "background"};
+    for (int priority = 0; priority < REQUEST_PRIORITY_COUNT; priority++) {
+        QueueClassStats queue = openai_client->get_queue_stats(static_cast<RequestPriority>(priority));
+        Dictionary entry;
+        entry["queued"] = queue.queued;
+        entry["dispatched"] = static_cast<int64_t>(queue.dispatched);
+        entry["expired"] = static_cast<int64_t>(queue.expired);
+        entry["avg_wait_ms"] = queue.dispatched > 0 ? queue.total_wait_seconds * 1000.0 / queue.dispatched : 0.0;
+        entry["max_wait_ms"] = queue.max_wait_seconds * 1000.0;
+        stats[class_names[priority]] = entry;
+    }
+    return stats;
+}
+
+Dictionary NecronomiCore::get_item_prefetch_status() const {
+    if (!item_service) {
+        return Dictionary();
+    }
+    return item_service->get_prefetch_status();
+}
+
+Dictionary NecronomiCore::get_item_pool_memory_stats() const {
+    if (!item_service) {
+        return Dictionary();
+    }
+    return item_service->get_pool_memory_stats();
+}
+
+Dictionary NecronomiCore::get_dialog_memory_stats() const {
+    if (!dialog_service) {
+        return Dictionary();
+    }
+    return dialog_service->get_history_memory_stats();
+}
+
+Dictionary NecronomiCore::get_dialog_prefetch_stats() const {
+    if (!dialog_service) {
+        return Dictionary();
+    }
+    return dialog_service->get_prefetch_stats();
+}
+
+Dictionary NecronomiCore::get_dialog_line_stats() const {
+    if (!dialog_service) {
+        return Dictionary();
+    }
+    return dialog_service->get_line_bank_stats();
+}
+
+Dictionary NecronomiCore::get_environmental_message_stats() const {
+    if (!dialog_service) {
+        return Dictionary();
+    }
+    return dialog_service->get_environmental_message_stats();
+}
+
+Dictionary NecronomiCore::get_cache_stats() const {
+    Dictionary stats;
+    if (!openai_client) {
+        return stats;
+    }
+
+    ResponseCacheStats cache = openai_client->get_cache_stats();
+    stats["hits"] = static_cast<int64_t>(cache.memory_hits + cache.disk_hits);
+    stats["memory_hits"] = static_cast<int64_t>(cache.memory_hits);
+    stats["disk_hits"] = static_cast<int64_t>(cache.disk_hits);
+    stats["misses"] = static_cast<int64_t>(cache.misses);
+    stats["evictions"] = static_cast<int64_t>(cache.evictions);
+    stats["stores"] = static_cast<int64_t>(cache.stores);
+    stats["memory_entries"] = static_cast<int64_t>(cache.memory_entries);
+    stats["memory_bytes"] = static_cast<int64_t>(cache.memory_bytes);
+    stats["disk_entries"] = static_cast<int64_t>(cache.disk_entries);
+
+    if (item_service) {
+        ItemPoolStoreStats pools = item_service->get_pool_store_stats();
+        stats["pool_store_hits"] = static_cast<int64_t>(pools.hits);
+        stats["pool_store_misses"] = static_cast<int64_t>(pools.misses);
+        stats["pool_store_rejected"] = static_cast<int64_t>(pools.rejected);
+        stats["pool_store_stores"] = static_cast<int64_t>(pools.stores);
+        stats["pool_store_mapped_files"] = static_cast<int64_t>(pools.mapped_files);
+        stats["pool_store_mapped_bytes"] = static_cast<int64_t>(pools.mapped_bytes);
+    }
+    if (dialog_service) {
+        DialogPromptStats prompts = dialog_service->get_prompt_stats();
+        stats["persona_renders"] = static_cast<int64_t>(prompts.persona_renders);
+        stats["persona_reuses"] = static_cast<int64_t>(prompts.persona_reuses);
+        stats["cached_personas"] = static_cast<int64_t>(prompts.cached_personas);
+    }
+    return stats;
+}
+
+void NecronomiCore::clear_response_cache() {
+    if (openai_client) {
+        openai_client->clear_cache();
+    }
+}
+
+void NecronomiCore::clear_item_pool_store() {
+    if (item_service) {
+        item_service->clear_pool_store();
+    }
+}
+
+Dictionary NecronomiCore::run_benchmark(const String& name, const Dictionary& options) {
+    //runs on the calling thread and blocks it, meant for test scenes and profiling builds
+    return Benchmarks::run(name.utf8().get_data(), options);
+}
+
 void NecronomiCore::emit_item_pool_ready(const Array& items) {
     emit_signal("item_pool_ready", items);
 }
 
+void NecronomiCore::emit_item_pool_updated(const Array& items) {
+    emit_signal("item_pool_updated", items);
+}
+
+void NecronomiCore::emit_item_generated(const Dictionary& item) {
+    emit_signal("item_generated", item);
+}
+
 void NecronomiCore::emit_dialog_ready(const String& dialog_text) {
     emit_signal("dialog_ready", dialog_text);
 }
 
+void NecronomiCore::emit_dialog_chunk(const String& chunk_text) {
+    emit_signal("dialog_chunk", chunk_text);
+}
+
 void NecronomiCore::emit_request_failed(const String& error_message) {
     emit_signal("request_failed", error_message);
 }
@@ -161,7 +787,7 @@ void NecronomiCore::_process(double delta) {
     //update rate limiting
     openai_client->update_rate_limit(delta);
 
-    //process queued requests
+    //dispatch queued requests to the io workers and fire finished callbacks
     openai_client->process_queue();
 }
 
@@ -1,8 +1,18 @@
 #include "openai_client.h"
 #include "http_client.h"
 #include "json_utils.h"
+#include "sse_parser.h"
+#include "response_cache.h"
+#include "json_writer.h"
+#include "json_reader.h"
 #include <godot_cpp/variant/variant.hpp>
 #include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <locale>
 
 using namespace godot;
 
@@ -10,16 +20,165 @@ namespace necronomicore {
 
 OpenAIClient::OpenAIClient() 
     : base_url("https://api.openai.com/v1"),
-      processing(false),
-      max_requests_per_minute(60),
-      current_request_count(0),
-      last_reset_time(0.0) {
+      http_client(std::make_unique<HTTPClient>()),
+      next_sequence(0),
+      workers_stopping(false),
+      workers_retiring(0),
+      worker_count(2),
+      max_in_flight(4),
+      in_flight(0),
+      response_cache(std::make_unique<ResponseCache>()),
+      cache_enabled(true),
+      coalesced_requests(0),
+      max_retries(3),
+      retry_base_delay(0.5),
+      retry_max_delay(8.0),
+      retry_rng(std::random_device{}()),
+      retried_requests(0),
+      prompt_tokens_used(0),
+      completion_tokens_used(0),
+      cached_prompt_tokens_used(0) {
+    http_client->set_timeout(30);
 }
 
 OpenAIClient::~OpenAIClient() {
+    //joining waits for requests already on the wire (bounded by the http timeout)
+    stop_workers();
     clear_queue();
 }
 
+void OpenAIClient::start_workers() {
+    std::lock_guard<std::mutex> lock(worker_mutex);
+    workers_stopping = false;
+    int active = static_cast<int>(workers.size() - retired_workers.size()) - workers_retiring;
+    if (active > worker_count) {
+        workers_retiring += active - worker_count;
+        worker_cv.notify_all();
+        return;
+    }
+
+    //take back pending retirements before spawning anything new
+    int keep = std::min(workers_retiring, worker_count - active);
+    workers_retiring -= keep;
+    active += keep;
+    for (; active < worker_count; active++) {
+        workers.emplace_back(&OpenAIClient::worker_loop, this);
+    }
+}
+
+void OpenAIClient::stop_workers() {
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex);
+        workers_stopping = true;
+    }
+    worker_cv.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+    workers_retiring = 0;
+    retired_workers.clear();
+}
+
+//joins workers that already left worker_loop, so this never waits on a request
+void OpenAIClient::reap_retired_workers() {
+    std::vector<std::thread::id> retired;
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex);
+        retired.swap(retired_workers);
+    }
+
+    for (const std::thread::id& id : retired) {
+        auto worker = std::find_if(workers.begin(), workers.end(),
+            [&id](const std::thread& thread) { return thread.get_id() == id; });
+        if (worker != workers.end()) {
+            worker->join();
+            workers.erase(worker);
+        }
+    }
+}
+
+void OpenAIClient::worker_loop() {
+    for (;;) {
+        OpenAIRequest request;
+        {
+            std::unique_lock<std::mutex> lock(worker_mutex);
+            worker_cv.wait(lock, [this] {
+                return workers_stopping || workers_retiring > 0 || !dispatched_requests.empty();
+            });
+            if (workers_stopping) {
+                return;
+            }
+            if (workers_retiring > 0) {
+                //the pool shrank, leave before taking more work
+                workers_retiring--;
+                retired_workers.push_back(std::this_thread::get_id());
+                return;
+            }
+            //the most urgent class first when more is dispatched than there are workers
+            auto next = std::min_element(dispatched_requests.begin(), dispatched_requests.end(),
+                [](const OpenAIRequest& a, const OpenAIRequest& b) {
+                    if (a.priority != b.priority) {
+                        return a.priority < b.priority;
+                    }
+                    return a.sequence < b.sequence;
+                });
+            request = std::move(*next);
+            dispatched_requests.erase(next);
+        }
+
+        CompletedRequest done;
+        done.priority = request.priority;
+        done.callback = std::move(request.callback);
+
+        //a deadline can still pass while waiting for a free worker
+        if (request.deadline <= RequestClock::now()) {
+            done.response = make_expired_response();
+            done.expired = true;
+        } else {
+            done.response = send_http_request(request);
+            done.from_worker = true;
+            store_cached_response(request, done.response);
+            //a stream that already delivered text can't be replayed without duplicating it
+            done.retryable = !done.response.success && !request.probe &&
+                             is_transient_status(done.response.status_code) &&
+                             !(request.stream && !done.response.content.empty());
+        }
+
+        if (done.retryable) {
+            done.request = std::move(request);
+        } else {
+            done.request.endpoint = std::move(request.endpoint);
+            done.request.probe = request.probe;
+        }
+
+        std::lock_guard<std::mutex> lock(worker_mutex);
+        completed_requests.push_back(std::move(done));
+    }
+}
+
+void OpenAIClient::set_worker_count(int count) {
+    count = count > 0 ? count : 1;
+    if (count == worker_count) {
+        return;
+    }
+
+    //resize without joining, a busy worker would hold the main thread for up to
+    //the http timeout; surplus workers exit after their current request
+    worker_count = count;
+    reap_retired_workers();
+    if (!workers.empty()) {
+        start_workers();
+    }
+}
+
+void OpenAIClient::set_max_in_flight(int count) {
+    max_in_flight = count > 0 ? count : 1;
+}
+
 void OpenAIClient::set_api_key(const std::string& key) {
     api_key = key;
 }
@@ -28,140 +187,865 @@ void OpenAIClient::set_base_url(const std::string& url) {
     base_url = url;
 }
 
-std::string OpenAIClient::build_chat_completion_body(const Array& messages,
-                                                     const String& model,
-                                                     float temperature,
-                                                     int max_tokens) {
-    Dictionary body;
-    body[Variant("model")] = Variant(model);
-    body[Variant("messages")] = Variant(messages);
-    body[Variant("temperature")] = Variant(temperature);
-    body[Variant("max_tokens")] = Variant(max_tokens);
-    
-    return JSONUtils::stringify_json(body);
+HTTPClientStats OpenAIClient::get_http_stats() const {
+    return http_client->get_stats();
+}
+
+void OpenAIClient::set_cache_enabled(bool enabled) {
+    cache_enabled = enabled;
+}
+
+bool OpenAIClient::open_cache_file(const std::string& path) {
+    return response_cache->open_disk_tier(path);
+}
+
+void OpenAIClient::set_cache_ttl(int seconds) {
+    response_cache->set_default_ttl(seconds);
+}
+
+int OpenAIClient::get_cache_ttl() const {
+    return response_cache->get_default_ttl();
+}
+
+void OpenAIClient::set_cache_capacity(size_t max_entries, size_t max_bytes) {
+    response_cache->set_memory_capacity(max_entries, max_bytes);
+}
+
+void OpenAIClient::clear_cache() {
+    response_cache->clear();
+}
+
+ResponseCacheStats OpenAIClient::get_cache_stats() const {
+    return response_cache->get_stats();
+}
+
+//looks the keyed request up, marks it cacheable on a miss
+bool OpenAIClient::try_cached_response(OpenAIRequest& request, const RequestOptions& options, HTTPResponse& response) {
+    if (!cache_enabled || options.bypass_cache) {
+        return false;
+    }
+
+    request.cache_ttl_seconds = options.cache_ttl_seconds;
+
+    CachedResponse cached;
+    if (!response_cache->lookup(request.content_key, cached)) {
+        request.cacheable = true;
+        return false;
+    }
+
+    response.status_code = cached.status_code;
+    response.body = std::move(cached.body);
+    response.content = std::move(cached.content);
+    response.success = true;
+    return true;
+}
+
+//attaches the caller to an identical pending request, if there is one
+bool OpenAIClient::join_coalesced_request(const OpenAIRequest& request, const RequestOptions& options) {
+    auto group = coalesced_groups.find(request.content_key);
+    if (group == coalesced_groups.end()) {
+        return false;
+    }
+
+    //a more urgent caller must not wait at the class of whoever asked first
+    promote_queued_request(request.content_key, options.priority, deadline_from(options, RequestClock::now()));
+
+    group->second.callbacks.push_back(request.callback);
+    if (request.on_chunk) {
+        //delivered counts from zero so the text streamed so far is replayed with the next chunk
+        group->second.chunk_subscribers.push_back({request.on_chunk, 0});
+    }
+    coalesced_requests++;
+    return true;
+}
+
+//moves a still queued request up to the joiner's class and earlier deadline,
+//a request already on a worker is left alone
+void OpenAIClient::promote_queued_request(uint64_t key, RequestPriority priority, RequestClock::time_point deadline) {
+    int target = static_cast<int>(priority);
+
+    //waiting out a retry backoff, it re-enters the queue with whatever class it has then
+    for (auto& delayed : delayed_retries) {
+        if (delayed.content_key == key && !delayed.probe) {
+            if (target < static_cast<int>(delayed.priority)) {
+                delayed.priority = priority;
+            }
+            delayed.deadline = std::min(delayed.deadline, deadline);
+            return;
+        }
+    }
+
+    for (int current = 0; current < REQUEST_PRIORITY_COUNT; current++) {
+        std::vector<OpenAIRequest>& queue = request_queues[current];
+        auto found = std::find_if(queue.begin(), queue.end(), [key](const OpenAIRequest& queued) {
+            return queued.content_key == key && !queued.probe;
+        });
+        if (found == queue.end()) {
+            continue;
+        }
+
+        bool raise_class = target < current;
+        bool tighten_deadline = deadline < found->deadline;
+        if (!raise_class && !tighten_deadline) {
+            return;
+        }
+        if (tighten_deadline) {
+            found->deadline = deadline;
+        }
+        if (!raise_class) {
+            std::make_heap(queue.begin(), queue.end(), scheduled_after);
+            return;
+        }
+
+        OpenAIRequest promoted = std::move(*found);
+        queue.erase(found);
+        std::make_heap(queue.begin(), queue.end(), scheduled_after);
+        queue_stats[current].queued = static_cast<int>(queue.size());
+
+        promoted.priority = priority;
+        std::vector<OpenAIRequest>& target_queue = request_queues[target];
+        target_queue.push_back(std::move(promoted));
+        std::push_heap(target_queue.begin(), target_queue.end(), scheduled_after);
+        queue_stats[target].queued = static_cast<int>(target_queue.size());
+        return;
+    }
+}
+
+//routes the request's callbacks through a group later callers can join
+void OpenAIClient::begin_coalesced_request(OpenAIRequest& request) {
+    uint64_t key = request.content_key;
+    CoalescedGroup& group = coalesced_groups[key];
+    group.callbacks.push_back(std::move(request.callback));
+    request.callback = [this, key](const HTTPResponse& response) {
+        finish_coalesced_request(key, response);
+    };
+
+    if (request.on_chunk) {
+        group.chunk_subscribers.push_back({std::move(request.on_chunk), 0});
+        request.on_chunk = [this, key](const std::string& text) {
+            deliver_coalesced_chunk(key, text);
+        };
+    }
+}
+
+void OpenAIClient::deliver_coalesced_chunk(uint64_t key, const std::string& text) {
+    auto group = coalesced_groups.find(key);
+    if (group == coalesced_groups.end()) {
+        return;
+    }
+
+    CoalescedGroup& shared = group->second;
+    shared.streamed += text;
+    for (auto& subscriber : shared.chunk_subscribers) {
+        if (subscriber.delivered < shared.streamed.size()) {
+            subscriber.on_chunk(shared.streamed.substr(subscriber.delivered));
+            subscriber.delivered = shared.streamed.size();
+        }
+    }
+}
+
+void OpenAIClient::finish_coalesced_request(uint64_t key, const HTTPResponse& response) {
+    auto found = coalesced_groups.find(key);
+    if (found == coalesced_groups.end()) {
+        return; //dropped by clear_queue
+    }
+
+    //taken out first so callbacks that re-request start a fresh call
+    CoalescedGroup group = std::move(found->second);
+    coalesced_groups.erase(found);
+
+    //late subscribers that joined after the last chunk still get the full text
+    for (auto& subscriber : group.chunk_subscribers) {
+        if (subscriber.delivered < group.streamed.size()) {
+            subscriber.on_chunk(group.streamed.substr(subscriber.delivered));
+        }
+    }
+    for (auto& callback : group.callbacks) {
+        if (callback) {
+            callback(response);
+        }
+    }
+}
+
+//runs on an io worker, only successful responses with content are kept
+void OpenAIClient::store_cached_response(const OpenAIRequest& request, const HTTPResponse& response) {
+    if (!request.cacheable || !response.success) {
+        return;
+    }
+    if (request.extract_content && response.content.empty()) {
+        return;
+    }
+
+    response_cache->store(request.content_key, {response.status_code, response.body, response.content},
+                          request.cache_ttl_seconds);
+}
+
+void OpenAIClient::build_chat_completion_body(std::string& out,
+                                              const std::vector<ChatMessage>& messages,
+                                              std::string_view model,
+                                              float temperature,
+                                              int max_tokens,
+                                              bool stream) {
+    //reserve for the worst case seen in practice so a prompt needs one allocation at most
+    size_t estimate = 96 + model.size();
+    for (const ChatMessage& message : messages) {
+        estimate += 32 + message.role.size() + message.content.size() + message.content.size() / 8;
+    }
+    out.clear();
+    out.reserve(estimate);
+
+    JSONWriter writer(out);
+    writer.begin_object();
+    writer.key("model");
+    writer.value(model);
+    writer.key("messages");
+    writer.begin_array();
+    for (const ChatMessage& message : messages) {
+        writer.begin_object();
+        writer.key("role");
+        writer.value(message.role);
+        writer.key("content");
+        writer.value(message.content);
+        writer.end_object();
+    }
+    writer.end_array();
+    writer.key("temperature");
+    writer.value(temperature);
+    writer.key("max_tokens");
+    writer.value(max_tokens);
+    if (stream) {
+        writer.key("stream");
+        writer.value(true);
+    }
+    writer.end_object();
 }
 
 std::string OpenAIClient::build_image_generation_body(const String& prompt,
                                                       const String& model,
                                                       const String& size,
                                                       int n) {
-    Dictionary body;
-    body[Variant("model")] = Variant(model);
-    body[Variant("prompt")] = Variant(prompt);
-    body[Variant("size")] = Variant(size);
-    body[Variant("n")] = Variant(n);
-    
-    return JSONUtils::stringify_json(body);
+    std::string body;
+    JSONWriter writer(body);
+    writer.begin_object();
+    writer.key("model");
+    writer.value(std::string_view(model.utf8().get_data()));
+    writer.key("prompt");
+    writer.value(std::string_view(prompt.utf8().get_data()));
+    writer.key("size");
+    writer.value(std::string_view(size.utf8().get_data()));
+    writer.key("n");
+    writer.value(n);
+    writer.end_object();
+    return body;
+}
+
+void OpenAIClient::prepare_request(OpenAIRequest& request) const {
+    //snapshot config here so workers never read it while the game changes it
+    request.headers["Authorization"] = "Bearer " + api_key;
+    request.headers["Content-Type"] = "application/json";
+    request.url = base_url + request.endpoint;
 }
 
+//runs on an io worker (or the caller's thread for sync requests)
 HTTPResponse OpenAIClient::send_http_request(const OpenAIRequest& request) {
-    HTTPClient client;
-    client.set_timeout(30);
-    
-    std::map<std::string, std::string> headers = request.headers;
-    headers["Authorization"] = "Bearer " + api_key;
-    headers["Content-Type"] = "application/json";
+    if (request.stream) {
+        return send_streaming_request(request);
+    }
     
-    std::string url = base_url + request.endpoint;
     SimpleHTTPResponse simple_response;
     
     if (request.method == "POST") {
-        simple_response = client.post(url, headers, request.body);
+        simple_response = http_client->post(request.url, request.headers, request.body);
     } else if (request.method == "GET") {
-        simple_response = client.get(url, headers);
+        simple_response = http_client->get(request.url, request.headers);
     }
     
     HTTPResponse response;
     response.status_code = simple_response.status_code;
-    response.body = simple_response.body;
-    response.headers = simple_response.headers;
+    response.body = std::move(simple_response.body);
+    response.headers = std::move(simple_response.headers);
     response.success = simple_response.success;
     response.error_message = simple_response.error;
     
+    if (response.success && request.extract_content) {
+        extract_completion(response);
+    }
+    
     return response;
 }
 
-void OpenAIClient::chat_completion(const Array& messages,
-                                  const String& model,
+//runs on an io worker, parses sse events as the body arrives
+HTTPResponse OpenAIClient::send_streaming_request(const OpenAIRequest& request) {
+    HTTPResponse response;
+    SSEParser parser;
+    bool saw_event = false;
+    
+    auto on_event = [&](const std::string& data) {
+        saw_event = true;
+        if (data == "[DONE]") {
+            return;
+        }
+        
+        std::string delta;
+        extract_delta(data, delta, response);
+        if (delta.empty()) {
+            return;
+        }
+        response.content += delta;
+        
+        if (request.on_chunk) {
+            std::lock_guard<std::mutex> lock(worker_mutex);
+            stream_chunks.push_back({request.on_chunk, std::move(delta)});
+        }
+    };
+    
+    HTTPClient::BodyCallback on_data = [&](const char* data, size_t size) {
+        response.body.append(data, size);
+        parser.feed(data, size, on_event);
+    };
+    
+    SimpleHTTPResponse simple_response = http_client->post_stream(request.url, request.headers, request.body, on_data);
+    parser.finish(on_event);
+    
+    response.status_code = simple_response.status_code;
+    response.headers = std::move(simple_response.headers);
+    response.success = simple_response.success;
+    response.error_message = simple_response.error;
+    if (!simple_response.body.empty()) {
+        response.body = std::move(simple_response.body); //error body
+    }
+    
+    //server ignored stream:true and answered with a plain completion
+    if (response.success && !saw_event) {
+        extract_completion(response);
+    }
+    
+    return response;
+}
+
+//both run on io workers, so they use JSONReader rather than godot's JSON
+void OpenAIClient::extract_delta(const std::string& event_json, std::string& delta, HTTPResponse& response) {
+    JSONReader reader(event_json);
+    reader.get_string("choices/0/delta/content", delta);
+    
+    //only the last event carries usage, and only when the request asked for it
+    std::string_view usage;
+    if (reader.find("usage", usage)) {
+        read_usage(usage, response);
+    }
+}
+
+void OpenAIClient::extract_completion(HTTPResponse& response) {
+    JSONReader reader(response.body);
+    reader.get_string("choices/0/message/content", response.content);
+    
+    std::string_view usage;
+    if (reader.find("usage", usage)) {
+        read_usage(usage, response);
+    }
+}
+
+//usage is a small object, so its fields are read from it instead of rescanning the body
+void OpenAIClient::read_usage(std::string_view usage_json, HTTPResponse& response) {
+    JSONReader usage(usage_json);
+    int64_t tokens;
+    if (usage.get_int("prompt_tokens", tokens)) {
+        response.prompt_tokens = static_cast<int>(tokens);
+    }
+    if (usage.get_int("completion_tokens", tokens)) {
+        response.completion_tokens = static_cast<int>(tokens);
+    }
+    if (usage.get_int("prompt_tokens_details/cached_tokens", tokens)) {
+        response.cached_prompt_tokens = static_cast<int>(tokens);
+    }
+}
+
+void OpenAIClient::chat_completion(const std::vector<ChatMessage>& messages,
+                                  std::string_view model,
                                   float temperature,
                                   int max_tokens,
-                                  std::function<void(const HTTPResponse&)> callback) {
+                                  std::function<void(const HTTPResponse&)> callback,
+                                  const RequestOptions& options) {
     OpenAIRequest request;
-    request.endpoint = "/chat/completions";
+    request.endpoint = CHAT_COMPLETIONS_ENDPOINT;
     request.method = "POST";
-    request.body = build_chat_completion_body(messages, model, temperature, max_tokens);
+    build_chat_completion_body(request.body, messages, model, temperature, max_tokens, options.stream);
     request.callback = callback;
+    request.extract_content = true;
+    request.stream = options.stream;
+    request.on_chunk = options.on_chunk;
+    //rough prompt size (~4 bytes per token) plus the completion budget
+    request.estimated_tokens = static_cast<int>(request.body.size() / 4) + max_tokens;
+    //the body carries model, messages and sampling parameters, the api key stays out of the key
+    request.content_key = ResponseCache::compute_key(request.method, request.endpoint, request.body);
     
-    request_queue.push(request);
+    //hits skip the rate limiter and the workers, delivered on the next process_queue
+    HTTPResponse cached;
+    if (try_cached_response(request, options, cached)) {
+        if (request.on_chunk && !cached.content.empty()) {
+            cached_chunks.push_back({request.on_chunk, cached.content});
+        }
+        cached_completions.push_back({std::move(request.callback), std::move(cached)});
+        return;
+    }
+    
+    //upstream is down, fail without queueing (services check is_circuit_open first for instant fallback)
+    if (circuit_breaker.is_open(request.endpoint)) {
+        circuit_breaker.record_fast_failure(request.endpoint);
+        cached_completions.push_back({std::move(request.callback), make_circuit_open_response()});
+        return;
+    }
+    
+    //an identical request is already on its way, share its response
+    if (options.coalesce) {
+        if (join_coalesced_request(request, options)) {
+            return;
+        }
+        begin_coalesced_request(request);
+    }
+    
+    enqueue_request(request, options);
 }
 
 void OpenAIClient::image_generation(const String& prompt,
                                    const String& model,
                                    const String& size,
                                    int n,
-                                   std::function<void(const HTTPResponse&)> callback) {
+                                   std::function<void(const HTTPResponse&)> callback,
+                                   const RequestOptions& options) {
     OpenAIRequest request;
     request.endpoint = "/images/generations";
     request.method = "POST";
     request.body = build_image_generation_body(prompt, model, size, n);
     request.callback = callback;
     
-    request_queue.push(request);
+    enqueue_request(request, options);
+}
+
+void OpenAIClient::enqueue_request(OpenAIRequest& request, const RequestOptions& options) {
+    request.priority = options.priority;
+    request.enqueued_at = RequestClock::now();
+    request.deadline = deadline_from(options, request.enqueued_at);
+    request.sequence = next_sequence++;
+    
+    int priority = static_cast<int>(request.priority);
+    std::vector<OpenAIRequest>& queue = request_queues[priority];
+    queue.push_back(std::move(request));
+    std::push_heap(queue.begin(), queue.end(), scheduled_after);
+    queue_stats[priority].queued = static_cast<int>(queue.size());
+}
+
+RequestClock::time_point OpenAIClient::deadline_from(const RequestOptions& options, RequestClock::time_point now) {
+    if (options.deadline_seconds <= 0.0) {
+        return RequestClock::time_point::max();
+    }
+    return now + std::chrono::duration_cast<RequestClock::duration>(std::chrono::duration<double>(options.deadline_seconds));
+}
+
+//heap order: earliest deadline on top, then first come first served
+bool OpenAIClient::scheduled_after(const OpenAIRequest& a, const OpenAIRequest& b) {
+    if (a.deadline != b.deadline) {
+        return a.deadline > b.deadline;
+    }
+    return a.sequence > b.sequence;
+}
+
+HTTPResponse OpenAIClient::make_circuit_open_response() {
+    HTTPResponse response;
+    response.status_code = 0;
+    response.success = false;
+    response.error_message = "Service unavailable (circuit open), try again shortly";
+    return response;
+}
+
+//any answer below 500 means the server is there, whatever it thought of the request
+bool OpenAIClient::is_upstream_up(int status_code) {
+    return status_code != 0 && status_code < 500;
+}
+
+//timeouts, dropped connections, throttling and server errors are worth another try
+bool OpenAIClient::is_transient_status(int status_code) {
+    return status_code == 0 || status_code == 408 || status_code == 429 ||
+           status_code == 500 || status_code == 502 || status_code == 503 || status_code == 504;
+}
+
+//retry-after-ms, or retry-after as delay-seconds or an http-date
+//false when there is no usable hint (garbage, negative or not finite)
+bool OpenAIClient::parse_retry_after(const std::map<std::string, std::string>& headers, double& seconds) {
+    double scale = 0.001;
+    auto it = headers.find("retry-after-ms");
+    if (it == headers.end()) {
+        scale = 1.0;
+        it = headers.find("retry-after");
+    }
+    if (it == headers.end() || it->second.empty()) {
+        return false;
+    }
+
+    const char* text = it->second.c_str();
+    char* end = nullptr;
+    double value = std::strtod(text, &end);
+    if (end != text && *end == '\0') {
+        if (!std::isfinite(value) || value < 0.0) {
+            return false;
+        }
+        seconds = value * scale;
+        return true;
+    }
+    if (scale != 1.0) {
+        return false;
+    }
+
+    //imf-fixdate, "Wed, 21 Oct 2015 07:28:00 GMT"
+    std::tm date = {};
+    std::istringstream stream(it->second);
+    stream.imbue(std::locale::classic());
+    stream >> std::get_time(&date, "%a, %d %b %Y %H:%M:%S GMT");
+    if (stream.fail()) {
+        return false;
+    }
+
+    //days since the unix epoch for a utc civil date, without relying on timegm
+    int64_t year = date.tm_year + 1900 - (date.tm_mon < 2 ? 1 : 0);
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t year_of_era = year - era * 400;
+    int64_t month = date.tm_mon + 1;
+    int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + date.tm_mday - 1;
+    int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    int64_t days = era * 146097 + day_of_era - 719468;
+    int64_t at = days * 86400 + date.tm_hour * 3600 + date.tm_min * 60 + date.tm_sec;
+
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    seconds = at > now ? static_cast<double>(at - now) : 0.0;
+    return true;
+}
+
+//requeues the request after an exponential backoff with jitter, or the server's retry-after
+bool OpenAIClient::schedule_retry(CompletedRequest& done) {
+    OpenAIRequest& request = done.request;
+    if (request.attempts >= max_retries || circuit_breaker.is_open(request.endpoint)) {
+        return false;
+    }
+
+    //equal jitter: half the backoff fixed, half random, so clients that failed together spread out
+    double backoff = std::min(retry_max_delay, retry_base_delay * static_cast<double>(1 << request.attempts));
+    std::uniform_real_distribution<double> jitter(0.0, backoff * 0.5);
+    double delay = backoff * 0.5 + jitter(retry_rng);
+
+    //the server's hint is capped, a huge one would otherwise park the retry for good
+    double retry_after = 0.0;
+    if (parse_retry_after(done.response.headers, retry_after)) {
+        delay = std::max(delay, std::min(retry_after, retry_max_delay * 4.0));
+    }
+
+    RequestClock::time_point not_before = RequestClock::now() +
+        std::chrono::duration_cast<RequestClock::duration>(std::chrono::duration<double>(delay));
+    if (not_before >= request.deadline) {
+        return false; //would only expire in the queue
+    }
+
+    request.attempts++;
+    request.not_before = not_before;
+    request.callback = std::move(done.callback);
+    delayed_retries.push_back(std::move(request));
+    retried_requests++;
+    return true;
+}
+
+void OpenAIClient::release_due_retries(RequestClock::time_point now) {
+    for (size_t i = 0; i < delayed_retries.size();) {
+        if (delayed_retries[i].not_before > now) {
+            i++;
+            continue;
+        }
+
+        //keeps its sequence, so it goes ahead of newer requests of its class
+        OpenAIRequest request = std::move(delayed_retries[i]);
+        delayed_retries[i] = std::move(delayed_retries.back());
+        delayed_retries.pop_back();
+
+        int priority = static_cast<int>(request.priority);
+        std::vector<OpenAIRequest>& queue = request_queues[priority];
+        queue.push_back(std::move(request));
+        std::push_heap(queue.begin(), queue.end(), scheduled_after);
+        queue_stats[priority].queued = static_cast<int>(queue.size());
+    }
+}
+
+void OpenAIClient::record_upstream_result(const CompletedRequest& done) {
+    if (!done.from_worker || done.request.probe) {
+        return;
+    }
+
+    int status = done.response.status_code;
+    if (!is_upstream_up(status)) {
+        circuit_breaker.record_failure(done.request.endpoint);
+    } else if (status != 429) {
+        //any other answer means the upstream is up (429 is the rate limiter's business)
+        circuit_breaker.record_success(done.request.endpoint);
+    }
+}
+
+//one cheap request per circuit whose cooldown is over
+void OpenAIClient::send_due_probes() {
+    for (const std::string& endpoint : circuit_breaker.take_due_probes()) {
+        OpenAIRequest probe;
+        probe.endpoint = "/models";
+        probe.method = "GET";
+        probe.probe = true;
+        //scored like any other request: a 404 from a server without /models still means it is up
+        probe.callback = [this, endpoint](const HTTPResponse& response) {
+            circuit_breaker.record_probe_result(endpoint, is_upstream_up(response.status_code));
+        };
+
+        RequestOptions options;
+        options.priority = RequestPriority::BACKGROUND;
+        enqueue_request(probe, options);
+    }
+}
+
+void OpenAIClient::set_max_retries(int retries) {
+    max_retries = std::max(0, std::min(retries, 10));
+}
+
+void OpenAIClient::set_retry_delay(double base_seconds, double max_seconds) {
+    retry_base_delay = std::max(base_seconds, 0.01);
+    retry_max_delay = std::max(max_seconds, retry_base_delay);
+}
+
+bool OpenAIClient::is_circuit_open(const std::string& endpoint) const {
+    return circuit_breaker.is_open(endpoint);
+}
+
+CircuitStats OpenAIClient::get_circuit_stats(const std::string& endpoint) const {
+    return circuit_breaker.get_stats(endpoint);
+}
+
+HTTPResponse OpenAIClient::make_expired_response() {
+    HTTPResponse response;
+    response.status_code = 0;
+    response.success = false;
+    response.error_message = "Request deadline passed before it was sent";
+    return response;
+}
+
+void OpenAIClient::drop_expired_requests(RequestClock::time_point now) {
+    //expired requests are always on top of their heap
+    std::vector<std::function<void(const HTTPResponse&)>> expired_callbacks;
+    for (int priority = 0; priority < REQUEST_PRIORITY_COUNT; priority++) {
+        std::vector<OpenAIRequest>& queue = request_queues[priority];
+        while (!queue.empty() && queue.front().deadline <= now) {
+            std::pop_heap(queue.begin(), queue.end(), scheduled_after);
+            expired_callbacks.push_back(std::move(queue.back().callback));
+            queue.pop_back();
+            queue_stats[priority].expired++;
+        }
+        queue_stats[priority].queued = static_cast<int>(queue.size());
+    }
+    
+    //fired after the sweep, callbacks may queue new requests
+    HTTPResponse expired = make_expired_response();
+    for (auto& callback : expired_callbacks) {
+        if (callback) {
+            callback(expired);
+        }
+    }
 }
 
-HTTPResponse OpenAIClient::chat_completion_sync(const Array& messages,
-                                                const String& model,
+HTTPResponse OpenAIClient::chat_completion_sync(const std::vector<ChatMessage>& messages,
+                                                std::string_view model,
                                                 float temperature,
-                                                int max_tokens) {
+                                                int max_tokens,
+                                                const RequestOptions& options) {
     OpenAIRequest request;
-    request.endpoint = "/chat/completions";
+    request.endpoint = CHAT_COMPLETIONS_ENDPOINT;
     request.method = "POST";
-    request.body = build_chat_completion_body(messages, model, temperature, max_tokens);
+    build_chat_completion_body(request.body, messages, model, temperature, max_tokens, false);
+    request.extract_content = true;
+    request.content_key = ResponseCache::compute_key(request.method, request.endpoint, request.body);
+    
+    HTTPResponse response;
+    if (try_cached_response(request, options, response)) {
+        return response;
+    }
+    if (circuit_breaker.is_open(request.endpoint)) {
+        circuit_breaker.record_fast_failure(request.endpoint);
+        return make_circuit_open_response();
+    }
     
-    return send_http_request(request);
+    prepare_request(request);
+    response = send_http_request(request);
+    prompt_tokens_used += response.prompt_tokens;
+    completion_tokens_used += response.completion_tokens;
+    cached_prompt_tokens_used += response.cached_prompt_tokens;
+    store_cached_response(request, response);
+    return response;
 }
 
 void OpenAIClient::process_queue() {
-    if (processing || request_queue.empty() || !can_make_request()) {
-        return;
+    reap_retired_workers();
+
+    //hand streamed deltas and finished requests back to the main thread
+    //(a request's chunks are always queued before its completion)
+    std::deque<StreamChunk> chunks;
+    std::deque<CompletedRequest> finished;
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex);
+        chunks.swap(stream_chunks);
+        finished.swap(completed_requests);
     }
     
-    processing = true;
-    OpenAIRequest request = request_queue.front();
-    request_queue.pop();
+    for (auto& chunk : chunks) {
+        chunk.on_chunk(chunk.text);
+    }
     
-    HTTPResponse response = send_http_request(request);
+    for (auto& done : finished) {
+        in_flight--;
+        if (done.expired) {
+            queue_stats[static_cast<int>(done.priority)].expired++;
+        }
+        rate_limiter.on_response(done.response.status_code, done.response.headers);
+        prompt_tokens_used += done.response.prompt_tokens;
+        completion_tokens_used += done.response.completion_tokens;
+        cached_prompt_tokens_used += done.response.cached_prompt_tokens;
+        record_upstream_result(done);
+        if (done.retryable && schedule_retry(done)) {
+            continue;
+        }
+        if (done.callback) {
+            done.callback(done.response);
+        }
+    }
+    
+    //cache hits never went through a worker, so they don't count as in flight
+    //(swapped out first, callbacks may queue new hits for the next frame)
+    std::deque<StreamChunk> hit_chunks;
+    std::deque<CompletedRequest> hits;
+    hit_chunks.swap(cached_chunks);
+    hits.swap(cached_completions);
+    
+    for (auto& chunk : hit_chunks) {
+        chunk.on_chunk(chunk.text);
+    }
     
-    if (request.callback) {
-        request.callback(response);
+    for (auto& done : hits) {
+        if (done.callback) {
+            done.callback(done.response);
+        }
     }
     
-    current_request_count++;
-    processing = false;
+    RequestClock::time_point now = RequestClock::now();
+    release_due_retries(now);
+    send_due_probes();
+    drop_expired_requests(now);
+    
+    //dispatch by class as far as the in-flight cap and rate limit allow,
+    //a lower class never overtakes a higher one that is waiting on the limiter
+    bool dispatched = false;
+    while (in_flight < max_in_flight) {
+        int priority = 0;
+        while (priority < REQUEST_PRIORITY_COUNT && request_queues[priority].empty()) {
+            priority++;
+        }
+        if (priority == REQUEST_PRIORITY_COUNT) {
+            break;
+        }
+        
+        //background work leaves one slot free so a player-facing request never waits on it
+        if (priority == static_cast<int>(RequestPriority::BACKGROUND) &&
+            max_in_flight > 1 && in_flight >= max_in_flight - 1) {
+            break;
+        }
+        
+        std::vector<OpenAIRequest>& queue = request_queues[priority];
+        //the circuit opened while this one was queued, fail it without spending budget
+        bool fail_fast = !queue.front().probe && circuit_breaker.is_open(queue.front().endpoint);
+        if (!fail_fast && !rate_limiter.try_acquire(queue.front().estimated_tokens)) {
+            break;
+        }
+        
+        std::pop_heap(queue.begin(), queue.end(), scheduled_after);
+        OpenAIRequest request = std::move(queue.back());
+        queue.pop_back();
+        
+        if (fail_fast) {
+            circuit_breaker.record_fast_failure(request.endpoint);
+            cached_completions.push_back({std::move(request.callback), make_circuit_open_response()});
+            queue_stats[priority].queued = static_cast<int>(queue.size());
+            continue;
+        }
+        
+        QueueClassStats& stats = queue_stats[priority];
+        //(requests queued by expiry callbacks above can be newer than now)
+        double waited = std::max(0.0, std::chrono::duration<double>(now - request.enqueued_at).count());
+        stats.dispatched++;
+        stats.total_wait_seconds += waited;
+        stats.max_wait_seconds = std::max(stats.max_wait_seconds, waited);
+        stats.queued = static_cast<int>(queue.size());
+        
+        prepare_request(request);
+        
+        {
+            std::lock_guard<std::mutex> lock(worker_mutex);
+            dispatched_requests.push_back(std::move(request));
+        }
+        
+        in_flight++;
+        dispatched = true;
+    }
+    
+    if (dispatched) {
+        if (workers.empty()) {
+            start_workers();
+        }
+        worker_cv.notify_all();
+    }
 }
 
 bool OpenAIClient::has_pending_requests() const {
-    return !request_queue.empty();
+    return get_queued_count() > 0 || in_flight > 0 || !cached_completions.empty() || !delayed_retries.empty();
+}
+
+int OpenAIClient::get_queued_count() const {
+    int queued = 0;
+    for (const auto& queue : request_queues) {
+        queued += static_cast<int>(queue.size());
+    }
+    return queued;
+}
+
+QueueClassStats OpenAIClient::get_queue_stats(RequestPriority priority) const {
+    return queue_stats[static_cast<int>(priority)];
 }
 
 void OpenAIClient::clear_queue() {
-    while (!request_queue.empty()) {
-        request_queue.pop();
+    for (int priority = 0; priority < REQUEST_PRIORITY_COUNT; priority++) {
+        request_queues[priority].clear();
+        queue_stats[priority].queued = 0;
     }
+    cached_chunks.clear();
+    cached_completions.clear();
+    coalesced_groups.clear();
+    delayed_retries.clear();
+    
+    //requests not yet picked up by a worker are dropped too
+    std::lock_guard<std::mutex> lock(worker_mutex);
+    in_flight -= static_cast<int>(dispatched_requests.size());
+    dispatched_requests.clear();
 }
 
-bool OpenAIClient::can_make_request() const {
-    return current_request_count < max_requests_per_minute;
+void OpenAIClient::set_rate_limits(double requests_per_minute, double tokens_per_minute) {
+    rate_limiter.set_limits(requests_per_minute, tokens_per_minute);
+}
+
+RateLimiterStats OpenAIClient::get_rate_limit_stats() const {
+    return rate_limiter.get_stats();
 }
 
 void OpenAIClient::update_rate_limit(double delta_time) {
-    last_reset_time += delta_time;
-    
-    //reset counter every minute
-    if (last_reset_time >= 60.0) {
-        current_request_count = 0;
-        last_reset_time = 0.0;
-    }
+    //refill both budgets, the server's headers adjust the rates as responses come back
+    rate_limiter.update(delta_time);
 }
 
 } // namespace necronomicore
@@ -0,0 +1,310 @@
+#include "procedural_item_generator.h"
+#include "item_generation_service.h"
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+
+namespace necronomicore {
+
+namespace {
+
+struct Term {
+    const char* text;
+    int weight;
+};
+
+//a suffix and the modifier it grants, scaled by rarity
+struct Affix {
+    const char* text;
+    int weight;
+    const char* modifier;
+    float value;
+};
+
+//weighted choices, the total is summed once when the table is defined
+template <typename T>
+struct Table {
+    const T* entries;
+    int count;
+    uint32_t total;
+
+    template <size_t N>
+    constexpr Table(const T (&table)[N]) : entries(table), count(static_cast<int>(N)), total(0) {
+        for (size_t i = 0; i < N; i++) {
+            total += static_cast<uint32_t>(table[i].weight);
+        }
+    }
+};
+
+//base nouns per ItemType
+const Term WEAPON_NOUNS[] = {
+    {"Blade", 4}, {"Cleaver", 3}, {"Spear", 3}, {"Sickle", 3}, {"Dagger", 3},
+    {"Mace", 2}, {"Flail", 2}, {"Harpoon", 1}, {"Scythe", 1}
+};
+const Term ARMOR_NOUNS[] = {
+    {"Cuirass", 3}, {"Hood", 3}, {"Gauntlets", 3}, {"Greaves", 3},
+    {"Mantle", 2}, {"Cowl", 2}, {"Shell", 1}, {"Carapace", 1}
+};
+const Term CONSUMABLE_NOUNS[] = {
+    {"Tincture", 3}, {"Spore Draught", 3}, {"Salve", 3}, {"Tonic", 2},
+    {"Poultice", 2}, {"Broth", 2}, {"Cap", 1}
+};
+const Term RELIC_NOUNS[] = {
+    {"Idol", 3}, {"Charm", 3}, {"Reliquary", 2}, {"Sigil", 2},
+    {"Fetish", 2}, {"Totem", 2}, {"Rosary", 1}
+};
+const Term ARTIFACT_NOUNS[] = {
+    {"Lantern", 3}, {"Codex", 2}, {"Orb", 2}, {"Mirror", 2},
+    {"Bell", 2}, {"Crown", 1}, {"Astrolabe", 1}
+};
+const Table<Term> NOUNS[ItemStore::TYPE_COUNT] = {
+    WEAPON_NOUNS, ARMOR_NOUNS, CONSUMABLE_NOUNS, RELIC_NOUNS, ARTIFACT_NOUNS
+};
+const Term TYPE_TERMS[] = {{"weapon", 3}, {"armor", 3}, {"consumable", 2}, {"relic", 1}, {"artifact", 1}};
+const Table<Term> TYPES(TYPE_TERMS);
+
+//name prefixes per ItemRarity
+const Term COMMON_PREFIXES[] = {
+    {"Rusty", 3}, {"Mouldy", 3}, {"Damp", 3}, {"Chipped", 2}, {"Crude", 2}, {"Rotting", 2}, {"Patched", 1}
+};
+const Term UNCOMMON_PREFIXES[] = {
+    {"Spore-Kissed", 3}, {"Tarnished", 2}, {"Lichen-Bound", 2}, {"Pale", 2}, {"Brine-Soaked", 2}, {"Mottled", 2}
+};
+const Term RARE_PREFIXES[] = {
+    {"Eldritch", 3}, {"Whispering", 3}, {"Gilled", 2}, {"Luminous", 2}, {"Mycelial", 2}, {"Fathomless", 1}
+};
+const Term EPIC_PREFIXES[] = {
+    {"Abyssal", 3}, {"Star-Born", 2}, {"Dreaming", 2}, {"Sunken", 2}, {"Non-Euclidean", 1}, {"Thousand-Eyed", 1}
+};
+const Term LEGENDARY_PREFIXES[] = {
+    {"Elder", 3}, {"Cyclopean", 2}, {"Primordial", 2}, {"Black-Sun", 1}
+};
+const Term CURSED_PREFIXES[] = {
+    {"Blighted", 3}, {"Hungering", 3}, {"Accursed", 2}, {"Weeping", 2}, {"Festering", 2}, {"Unblinking", 1}
+};
+const Table<Term> PREFIXES[ItemStore::RARITY_COUNT] = {
+    COMMON_PREFIXES, UNCOMMON_PREFIXES, RARE_PREFIXES, EPIC_PREFIXES, LEGENDARY_PREFIXES, CURSED_PREFIXES
+};
+
+//legendary items are sometimes named for whoever carried them
+const Term OWNER_TERMS[] = {
+    {"The Sleeper's", 2}, {"The Spore Mother's", 2}, {"The Pale Bishop's", 2}, {"Old Vaskin's", 1}, {"Ib-Tharr's", 1}
+};
+const Table<Term> OWNERS(OWNER_TERMS);
+
+const Affix SUFFIX_AFFIXES[] = {
+    {" of the Deep", 3, "defense_bonus", 0.05f},
+    {" of Mycelium", 3, "regeneration", 0.5f},
+    {" of Quiet Feet", 2, "speed", 0.1f},
+    {" of Creeping Rot", 2, "poison_damage", 2.0f},
+    {" of the Hollow Moon", 2, "luck", 0.1f},
+    {" of Unseen Stars", 1, "crit_chance", 0.05f},
+    {" of the Drowned King", 1, "lifesteal", 0.05f}
+};
+const Table<Affix> SUFFIXES(SUFFIX_AFFIXES);
+//chance of a suffix per rarity
+const float SUFFIX_CHANCE[ItemStore::RARITY_COUNT] = {0.0f, 0.35f, 0.6f, 0.85f, 1.0f, 0.7f};
+
+const Term WEAPON_EFFECTS[] = {
+    {"poisons on hit", 3}, {"causes bleeding", 3}, {"spore burst on kill", 2},
+    {"pierces armor", 2}, {"drains sanity from the target", 1}, {"strikes twice in darkness", 1}
+};
+const Term ARMOR_EFFECTS[] = {
+    {"resists spores", 3}, {"reflects part of melee damage", 2}, {"regenerates slowly", 2},
+    {"muffles footsteps", 2}, {"hardens when struck", 1}
+};
+const Term CONSUMABLE_EFFECTS[] = {
+    {"restores sanity", 3}, {"cures poison", 3}, {"grants night vision", 2},
+    {"briefly hastens", 2}, {"reveals hidden doors", 1}
+};
+const Term RELIC_EFFECTS[] = {
+    {"increases luck", 3}, {"wards off madness", 2}, {"glows near secrets", 2},
+    {"calms hostile creatures", 1}, {"reveals the floor map", 1}
+};
+const Term ARTIFACT_EFFECTS[] = {
+    {"opens sealed doors", 2}, {"whispers the way forward", 2}, {"bends nearby light", 2},
+    {"summons a spore familiar", 2}, {"stops time briefly", 1}
+};
+const Table<Term> EFFECTS[ItemStore::TYPE_COUNT] = {
+    WEAPON_EFFECTS, ARMOR_EFFECTS, CONSUMABLE_EFFECTS, RELIC_EFFECTS, ARTIFACT_EFFECTS
+};
+const Term CURSE_EFFECT_TERMS[] = {
+    {"cannot be unequipped", 3}, {"slowly drains sanity", 3}, {"whispers your name at night", 2},
+    {"attracts the hungry", 2}, {"spreads rot to other items", 1}
+};
+const Table<Term> CURSE_EFFECTS(CURSE_EFFECT_TERMS);
+//effects per rarity, a cursed item also carries one curse
+const int EFFECT_COUNT[ItemStore::RARITY_COUNT] = {0, 1, 1, 2, 3, 1};
+
+const Term ORIGIN_TERMS[] = {
+    {" pulled from a flooded crypt.", 3}, {" grown rather than forged.", 3},
+    {" traded from the mushroom folk.", 2}, {" found clutched in a petrified hand.", 2},
+    {" dredged from the black lake.", 2}, {" left as an offering at a fungal shrine.", 2}
+};
+const Table<Term> ORIGINS(ORIGIN_TERMS);
+
+const Term FLAVOR_TERMS[] = {
+    {"Even decay has its uses.", 2},
+    {"It hums when the lights go out.", 2},
+    {"The spores remember every hand that held it.", 2},
+    {"Its last owner was found overgrown.", 2},
+    {"Damp to the touch, no matter how long it dries.", 2},
+    {"Something beneath the floor wants it back.", 1},
+    {"The old priests buried these for a reason.", 1},
+    {"It smells faintly of a sea that isn't there.", 1},
+    {"Stars no one has named are reflected in it.", 1}
+};
+const Table<Term> FLAVORS(FLAVOR_TERMS);
+const Term CURSED_FLAVOR_TERMS[] = {
+    {"It was not made to be let go.", 2},
+    {"You hear it breathing at night.", 2},
+    {"Every owner thought it was a gift.", 2},
+    {"The rot spreads from wherever it rests.", 1}
+};
+const Table<Term> CURSED_FLAVORS(CURSED_FLAVOR_TERMS);
+
+const char* const PALETTES[ItemStore::RARITY_COUNT] = {
+    "moss-grey", "lichen-green", "deep blue", "bruise-purple", "tarnished gold", "black and festering red"
+};
+
+//stat budget per rarity before difficulty and floor scaling, clamped afterwards
+const float BASE_POWER[ItemStore::RARITY_COUNT] = {8.0f, 14.0f, 24.0f, 38.0f, 55.0f, 45.0f};
+
+//[0, 1) from the top 24 bits of a draw
+inline float unit(std::mt19937_64& rng) {
+    return static_cast<float>(rng() >> 40) * (1.0f / 16777216.0f);
+}
+
+//multiply-shift on the high 32 bits instead of a 64-bit modulo, several picks per item
+template <typename T>
+const T& pick(std::mt19937_64& rng, const Table<T>& table) {
+    int64_t roll = static_cast<int64_t>(((rng() >> 32) * table.total) >> 32);
+    for (int i = 0; i < table.count; i++) {
+        roll -= table.entries[i].weight;
+        if (roll < 0) {
+            return table.entries[i];
+        }
+    }
+    return table.entries[table.count - 1];
+}
+
+//one allocation for the whole string
+void assign_joined(std::string& out, std::initializer_list<std::string_view> parts) {
+    size_t length = 0;
+    for (std::string_view part : parts) {
+        length += part.size();
+    }
+    out.reserve(length);
+    for (std::string_view part : parts) {
+        out.append(part.data(), part.size());
+    }
+}
+
+void lower_ascii(std::string& text, size_t from) {
+    for (size_t i = from; i < text.size(); i++) {
+        if (text[i] >= 'A' && text[i] <= 'Z') {
+            text[i] = static_cast<char>(text[i] - 'A' + 'a');
+        }
+    }
+}
+
+} // anonymous namespace
+
+ItemDefinition ProceduralItemGenerator::generate(std::mt19937_64& rng,
+                                                 ItemRarity rarity,
+                                                 int type,
+                                                 int difficulty,
+                                                 int floor,
+                                                 std::string_view theme) {
+    int r = std::clamp(static_cast<int>(rarity), 0, ItemStore::RARITY_COUNT - 1);
+    int t = type;
+    if (t < 0 || t >= ItemStore::TYPE_COUNT) {
+        t = static_cast<int>(&pick(rng, TYPES) - TYPE_TERMS);
+    }
+
+    ItemDefinition item;
+    item.rarity = static_cast<ItemRarity>(r);
+    item.type = static_cast<ItemType>(t);
+    const char* noun = pick(rng, NOUNS[t]).text;
+
+    //name: prefix or owner, noun, sometimes a suffix that also grants a modifier
+    const char* lead = (item.rarity == ItemRarity::LEGENDARY && unit(rng) < 0.5f) ?
+        pick(rng, OWNERS).text : pick(rng, PREFIXES[r]).text;
+    const Affix* suffix = unit(rng) < SUFFIX_CHANCE[r] ? &pick(rng, SUFFIXES) : nullptr;
+    assign_joined(item.name, {lead, " ", noun, suffix ? suffix->text : ""});
+    if (suffix) {
+        item.modifiers[suffix->modifier] = suffix->value * (1.0f + 0.5f * static_cast<float>(std::min(r, 4)));
+    }
+
+    if (!theme.empty() && unit(rng) < 0.25f) {
+        assign_joined(item.description, {noun, " found deep in the ", theme, "."});
+    } else {
+        assign_joined(item.description, {noun, pick(rng, ORIGINS).text});
+    }
+
+    item.flavor_text = item.rarity == ItemRarity::CURSED ? pick(rng, CURSED_FLAVORS).text : pick(rng, FLAVORS).text;
+
+    const char* glow = r >= static_cast<int>(ItemRarity::EPIC) ? " with a faint glow" : "";
+    assign_joined(item.sprite_hint, {PALETTES[r], " ", noun, glow});
+    lower_ascii(item.sprite_hint, std::strlen(PALETTES[r]));
+
+    //distinct effects, a few redraws at most since the tables are small
+    item.effects.reserve(EFFECT_COUNT[r] + 1);
+    for (int attempt = 0; static_cast<int>(item.effects.size()) < EFFECT_COUNT[r] && attempt < 8; attempt++) {
+        const char* effect = pick(rng, EFFECTS[t]).text;
+        if (std::find(item.effects.begin(), item.effects.end(), effect) == item.effects.end()) {
+            item.effects.emplace_back(effect);
+        }
+    }
+    if (item.rarity == ItemRarity::CURSED) {
+        item.effects.emplace_back(pick(rng, CURSE_EFFECTS).text);
+    }
+
+    //difficulty and depth raise the budget, the jitter keeps two items of a kind apart
+    float scale = 1.0f + 0.15f * static_cast<float>(std::max(difficulty, 1) - 1) +
+        0.1f * static_cast<float>(std::max(floor, 1) - 1);
+    float power = BASE_POWER[r] * scale * (0.8f + 0.4f * unit(rng));
+    switch (item.type) {
+        case ItemType::WEAPON:
+            item.damage = static_cast<int>(power);
+            item.cooldown = 0.6f + unit(rng);
+            break;
+        case ItemType::ARMOR:
+            item.defense = static_cast<int>(power);
+            break;
+        case ItemType::CONSUMABLE:
+            item.healing = static_cast<int>(power * 2.0f);
+            break;
+        case ItemType::RELIC:
+            item.damage = static_cast<int>(power / 3.0f);
+            item.defense = static_cast<int>(power / 2.0f);
+            break;
+        case ItemType::ARTIFACT:
+            item.damage = static_cast<int>(power / 2.0f);
+            item.cooldown = 5.0f + 15.0f * unit(rng);
+            break;
+    }
+
+    ItemGenerationService::validate_and_clamp_item(item);
+    return item;
+}
+
+void ProceduralItemGenerator::generate_pool(std::mt19937_64& rng,
+                                            const int* counts,
+                                            int difficulty,
+                                            int floor,
+                                            std::string_view theme,
+                                            std::vector<ItemDefinition>& out) {
+    int total = 0;
+    for (int r = 0; r < ItemStore::RARITY_COUNT; r++) {
+        total += std::max(counts[r], 0);
+    }
+    out.reserve(out.size() + total);
+    for (int r = 0; r < ItemStore::RARITY_COUNT; r++) {
+        for (int i = 0; i < counts[r]; i++) {
+            out.push_back(generate(rng, static_cast<ItemRarity>(r), ANY_TYPE, difficulty, floor, theme));
+        }
+    }
+}
+
+} // namespace necronomicore
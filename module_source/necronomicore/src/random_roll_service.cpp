@@ -15,7 +15,7 @@ Dictionary RollResult::to_dictionary() const {
     dict["min_range"] = min_range;
     dict["max_range"] = max_range;
     dict["context"] = String(context.c_str());
-    dict["flavor_text"] = String(flavor_text.c_str());
+    dict["flavor_text"] = String::utf8(flavor_text.data(), flavor_text.size());
     dict["critical_success"] = critical_success;
     dict["critical_failure"] = critical_failure;
     return dict;
@@ -60,7 +60,8 @@ std::string RandomRollService::generate_roll_flavor_text(const RollResult& resul
         return "The die is cast.";
     }
     
-    // AI-generated flavor (would need to be async in real implementation)
+    // AI-generated flavor (would need to be async in real implementation,
+    // queued as RequestPriority::GAMEPLAY so it never delays NPC dialog)
     return "The cosmic forces stir...";
 }
 
@@ -0,0 +1,203 @@
+#include "rate_limiter.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace necronomicore {
+
+void RateLimiter::Bucket::refill(double seconds) {
+    level = std::min(capacity, level + rate * seconds);
+}
+
+bool RateLimiter::Bucket::has(double amount) const {
+    return level >= amount;
+}
+
+void RateLimiter::Bucket::set_rate(double per_second, double burst) {
+    rate = per_second;
+    capacity = std::max(1.0, per_second * burst);
+    level = std::min(level, capacity);
+}
+
+RateLimiter::RateLimiter()
+    : burst_seconds(5.0),
+      pause_remaining(0.0),
+      throttled_responses(0) {
+    requests.level = 0.0;
+    tokens.level = 0.0;
+    set_limits(60.0, 40000.0);
+    //start with a full burst
+    requests.level = requests.capacity;
+    tokens.level = tokens.capacity;
+}
+
+void RateLimiter::set_limits(double requests_per_minute, double tokens_per_minute) {
+    requests.set_rate(std::max(requests_per_minute, 1.0) / 60.0, burst_seconds);
+    tokens.set_rate(std::max(tokens_per_minute, 1.0) / 60.0, burst_seconds);
+}
+
+void RateLimiter::set_burst_seconds(double seconds) {
+    burst_seconds = std::max(seconds, 0.1);
+    requests.set_rate(requests.rate, burst_seconds);
+    tokens.set_rate(tokens.rate, burst_seconds);
+}
+
+void RateLimiter::update(double delta_seconds) {
+    if (delta_seconds <= 0.0) {
+        return;
+    }
+
+    //nothing refills while the server asked us to back off
+    if (pause_remaining > 0.0) {
+        double paused = std::min(pause_remaining, delta_seconds);
+        pause_remaining -= paused;
+        delta_seconds -= paused;
+    }
+
+    requests.refill(delta_seconds);
+    tokens.refill(delta_seconds);
+}
+
+bool RateLimiter::try_acquire(int estimated_tokens) {
+    if (pause_remaining > 0.0) {
+        return false;
+    }
+
+    double needed = std::min(static_cast<double>(std::max(estimated_tokens, 0)), tokens.capacity);
+    if (!requests.has(1.0) || !tokens.has(needed)) {
+        return false;
+    }
+
+    requests.level -= 1.0;
+    tokens.level -= needed;
+    return true;
+}
+
+//"1s", "6m0s", "20ms", "1h2m3.5s" or a plain number of seconds
+double RateLimiter::parse_duration(const std::string& value) {
+    double total = 0.0;
+    const char* p = value.c_str();
+    while (*p) {
+        while (*p && std::isspace(static_cast<unsigned char>(*p))) {
+            p++;
+        }
+        char* end = nullptr;
+        double amount = std::strtod(p, &end);
+        if (end == p) {
+            break;
+        }
+        p = end;
+
+        if (p[0] == 'm' && p[1] == 's') {
+            total += amount / 1000.0;
+            p += 2;
+        } else if (*p == 'h') {
+            total += amount * 3600.0;
+            p++;
+        } else if (*p == 'm') {
+            total += amount * 60.0;
+            p++;
+        } else {
+            total += amount;
+            if (*p == 's') {
+                p++;
+            }
+        }
+    }
+    return total;
+}
+
+bool RateLimiter::read_number(const std::map<std::string, std::string>& headers, const std::string& key, double& out) {
+    auto it = headers.find(key);
+    if (it == headers.end() || it->second.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    out = std::strtod(it->second.c_str(), &end);
+    return end != it->second.c_str();
+}
+
+void RateLimiter::adapt_bucket(Bucket& bucket, double burst,
+                               bool has_limit, double limit,
+                               bool has_remaining, double remaining,
+                               double reset_seconds) {
+    if (has_limit && limit > 0.0) {
+        //the server refills what has been used by the time the window resets,
+        //which tells us the real refill rate whatever the window length is
+        double per_second = limit / 60.0;
+        if (has_remaining && reset_seconds > 0.0 && remaining < limit) {
+            per_second = (limit - remaining) / reset_seconds;
+        }
+        bucket.set_rate(std::min(per_second, limit), burst);
+    }
+
+    //the server also counts requests we didn't make (other clients on the key)
+    if (has_remaining) {
+        bucket.level = std::min(bucket.level, std::max(remaining, 0.0));
+    }
+}
+
+void RateLimiter::on_response(int status_code, const std::map<std::string, std::string>& headers) {
+    double limit_requests = 0.0, remaining_requests = 0.0;
+    double limit_tokens = 0.0, remaining_tokens = 0.0;
+    bool has_limit_requests = read_number(headers, "x-ratelimit-limit-requests", limit_requests);
+    bool has_remaining_requests = read_number(headers, "x-ratelimit-remaining-requests", remaining_requests);
+    bool has_limit_tokens = read_number(headers, "x-ratelimit-limit-tokens", limit_tokens);
+    bool has_remaining_tokens = read_number(headers, "x-ratelimit-remaining-tokens", remaining_tokens);
+
+    double reset_requests = 0.0, reset_tokens = 0.0;
+    auto reset = headers.find("x-ratelimit-reset-requests");
+    if (reset != headers.end()) {
+        reset_requests = parse_duration(reset->second);
+    }
+    reset = headers.find("x-ratelimit-reset-tokens");
+    if (reset != headers.end()) {
+        reset_tokens = parse_duration(reset->second);
+    }
+
+    adapt_bucket(requests, burst_seconds, has_limit_requests, limit_requests,
+                 has_remaining_requests, remaining_requests, reset_requests);
+    adapt_bucket(tokens, burst_seconds, has_limit_tokens, limit_tokens,
+                 has_remaining_tokens, remaining_tokens, reset_tokens);
+
+    if (status_code != 429 && status_code != 503) {
+        return;
+    }
+
+    //back off for as long as the server says, then restart from empty buckets
+    //so dispatch ramps up at the refill rate instead of bursting again
+    double wait = 0.0;
+    double retry_after_ms = 0.0;
+    if (read_number(headers, "retry-after-ms", retry_after_ms)) {
+        wait = retry_after_ms / 1000.0;
+    } else if (!read_number(headers, "retry-after", wait)) {
+        //no hint (or an http-date), wait for whichever budget ran out
+        wait = std::max(reset_requests, reset_tokens);
+    }
+
+    if (status_code == 429) {
+        throttled_responses++;
+        if (wait <= 0.0) {
+            wait = 1.0;
+        }
+    }
+
+    if (wait > 0.0) {
+        pause_remaining = std::max(pause_remaining, wait);
+        requests.level = 0.0;
+        tokens.level = 0.0;
+    }
+}
+
+RateLimiterStats RateLimiter::get_stats() const {
+    RateLimiterStats stats;
+    stats.requests_available = requests.level;
+    stats.tokens_available = tokens.level;
+    stats.requests_per_second = requests.rate;
+    stats.tokens_per_second = tokens.rate;
+    stats.paused_seconds = pause_remaining;
+    stats.throttled_responses = throttled_responses;
+    return stats;
+}
+
+} // namespace necronomicore
@@ -0,0 +1,480 @@
+#include "response_cache.h"
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <filesystem>
+
+namespace necronomicore {
+
+namespace {
+
+//disk layout:
+//  file header  "NCRC" + u32 version
+//  record       u32 magic, u64 key, i64 expires_at, i32 status,
+//               u32 body_len, u32 content_len, u32 checksum, body, content
+//records are only ever appended, the newest record for a key wins.
+//the checksum covers everything in the record except magic and itself,
+//a record that fails it is never served.
+//host byte order, the file is a local cache and not meant to be shared
+const char FILE_MAGIC[4] = {'N', 'C', 'R', 'C'};
+const uint32_t FILE_VERSION = 2;
+const uint32_t RECORD_MAGIC = 0x4E435245; //"NCRE"
+const size_t FILE_HEADER_SIZE = 8;
+const size_t RECORD_HEADER_SIZE = 36;
+const size_t CHECKSUM_OFFSET = 32;
+
+//rewrite the file once it is mostly dead records
+const uint64_t COMPACT_MIN_BYTES = 4 * 1024 * 1024;
+
+int64_t now_seconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+template <typename T>
+void put(std::vector<char>& out, T value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T get(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+struct RecordHeader {
+    uint32_t magic;
+    uint64_t key;
+    int64_t expires_at;
+    int32_t status;
+    uint32_t body_len;
+    uint32_t content_len;
+    uint32_t checksum;
+};
+
+RecordHeader decode_header(const char* data) {
+    RecordHeader header;
+    header.magic = get<uint32_t>(data);
+    header.key = get<uint64_t>(data + 4);
+    header.expires_at = get<int64_t>(data + 12);
+    header.status = get<int32_t>(data + 20);
+    header.body_len = get<uint32_t>(data + 24);
+    header.content_len = get<uint32_t>(data + 28);
+    header.checksum = get<uint32_t>(data + CHECKSUM_OFFSET);
+    return header;
+}
+
+//fnv-1a 32 over a whole encoded record, skipping magic and the checksum field
+uint32_t record_checksum(const char* record, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 4; i < size; i++) {
+        if (i == CHECKSUM_OFFSET) {
+            i += sizeof(uint32_t) - 1;
+            continue;
+        }
+        hash ^= static_cast<unsigned char>(record[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool write_file_header(std::FILE* file) {
+    return std::fwrite(FILE_MAGIC, 1, 4, file) == 4 &&
+           std::fwrite(&FILE_VERSION, sizeof(FILE_VERSION), 1, file) == 1;
+}
+
+} // namespace
+
+ResponseCache::ResponseCache()
+    : max_memory_entries(256),
+      max_memory_bytes(8 * 1024 * 1024),
+      memory_bytes(0),
+      disk_file(nullptr),
+      disk_live_bytes(0),
+      disk_file_bytes(0),
+      default_ttl_seconds(24 * 60 * 60) {
+}
+
+ResponseCache::~ResponseCache() {
+    close_disk_tier();
+}
+
+uint64_t ResponseCache::compute_key(const std::string& method,
+                                    const std::string& endpoint,
+                                    const std::string& body) {
+    //fnv-1a 64 over method, endpoint and the full request body
+    //(model, messages and sampling parameters all live in the body)
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const std::string& part) {
+        for (unsigned char c : part) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        hash ^= 0xFF; //separator so "ab"+"c" != "a"+"bc"
+        hash *= 1099511628211ULL;
+    };
+    mix(method);
+    mix(endpoint);
+    mix(body);
+    return hash;
+}
+
+bool ResponseCache::lookup(uint64_t key, CachedResponse& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    int64_t now = now_seconds();
+
+    auto mem_it = memory_index.find(key);
+    if (mem_it != memory_index.end()) {
+        auto entry = mem_it->second;
+        if (entry->expires_at > now) {
+            lru.splice(lru.begin(), lru, entry);
+            out = entry->response;
+            stats.memory_hits++;
+            return true;
+        }
+        memory_bytes -= entry->bytes;
+        lru.erase(entry);
+        memory_index.erase(mem_it);
+    }
+
+    auto disk_it = disk_index.find(key);
+    if (disk_it != disk_index.end()) {
+        DiskEntry entry = disk_it->second;
+        if (entry.expires_at > now && read_disk_entry(entry, key, out)) {
+            insert_memory(key, out, entry.expires_at);
+            stats.disk_hits++;
+            return true;
+        }
+        disk_live_bytes -= entry.size;
+        disk_index.erase(disk_it);
+    }
+
+    stats.misses++;
+    return false;
+}
+
+void ResponseCache::store(uint64_t key, const CachedResponse& response, int ttl_seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    int ttl = ttl_seconds > 0 ? ttl_seconds : default_ttl_seconds;
+    int64_t expires_at = now_seconds() + ttl;
+
+    insert_memory(key, response, expires_at);
+    if (disk_file) {
+        append_disk_entry(key, response, expires_at);
+    }
+    stats.stores++;
+}
+
+void ResponseCache::insert_memory(uint64_t key, const CachedResponse& response, int64_t expires_at) {
+    auto existing = memory_index.find(key);
+    if (existing != memory_index.end()) {
+        memory_bytes -= existing->second->bytes;
+        lru.erase(existing->second);
+        memory_index.erase(existing);
+    }
+
+    size_t bytes = sizeof(MemoryEntry) + response.body.size() + response.content.size();
+    if (bytes > max_memory_bytes) {
+        return; //never fits, the disk tier still has it
+    }
+
+    lru.push_front({key, response, expires_at, bytes});
+    memory_index[key] = lru.begin();
+    memory_bytes += bytes;
+    evict_to_capacity();
+}
+
+void ResponseCache::evict_to_capacity() {
+    while (!lru.empty() && (lru.size() > max_memory_entries || memory_bytes > max_memory_bytes)) {
+        MemoryEntry& oldest = lru.back();
+        memory_bytes -= oldest.bytes;
+        memory_index.erase(oldest.key);
+        lru.pop_back();
+        stats.evictions++;
+    }
+}
+
+bool ResponseCache::read_disk_entry(const DiskEntry& entry, uint64_t key, CachedResponse& out) {
+    if (!disk_file) {
+        return false;
+    }
+
+    if (entry.size < RECORD_HEADER_SIZE) {
+        return false;
+    }
+
+    std::vector<char> record(entry.size);
+    if (std::fseek(disk_file, static_cast<long>(entry.offset), SEEK_SET) != 0 ||
+        std::fread(record.data(), 1, record.size(), disk_file) != record.size()) {
+        return false;
+    }
+
+    RecordHeader header = decode_header(record.data());
+    if (header.magic != RECORD_MAGIC || header.key != key ||
+        RECORD_HEADER_SIZE + static_cast<uint64_t>(header.body_len) + header.content_len != entry.size ||
+        header.checksum != record_checksum(record.data(), record.size())) {
+        return false;
+    }
+
+    const char* payload = record.data() + RECORD_HEADER_SIZE;
+    out.status_code = header.status;
+    out.body.assign(payload, header.body_len);
+    out.content.assign(payload + header.body_len, header.content_len);
+    return true;
+}
+
+void ResponseCache::append_disk_entry(uint64_t key, const CachedResponse& response, int64_t expires_at) {
+    std::vector<char> record;
+    record.reserve(RECORD_HEADER_SIZE + response.body.size() + response.content.size());
+    put<uint32_t>(record, RECORD_MAGIC);
+    put<uint64_t>(record, key);
+    put<int64_t>(record, expires_at);
+    put<int32_t>(record, response.status_code);
+    put<uint32_t>(record, static_cast<uint32_t>(response.body.size()));
+    put<uint32_t>(record, static_cast<uint32_t>(response.content.size()));
+    put<uint32_t>(record, 0);
+    record.insert(record.end(), response.body.begin(), response.body.end());
+    record.insert(record.end(), response.content.begin(), response.content.end());
+    uint32_t checksum = record_checksum(record.data(), record.size());
+    std::memcpy(record.data() + CHECKSUM_OFFSET, &checksum, sizeof(checksum));
+
+    if (std::fseek(disk_file, 0, SEEK_END) != 0) {
+        return;
+    }
+    uint64_t offset = disk_file_bytes;
+    if (std::fwrite(record.data(), 1, record.size(), disk_file) != record.size()) {
+        return;
+    }
+    std::fflush(disk_file);
+    disk_file_bytes += record.size();
+
+    auto existing = disk_index.find(key);
+    if (existing != disk_index.end()) {
+        disk_live_bytes -= existing->second.size;
+    }
+    disk_index[key] = {offset, static_cast<uint32_t>(record.size()), expires_at};
+    disk_live_bytes += record.size();
+
+    if (disk_file_bytes > COMPACT_MIN_BYTES && disk_live_bytes * 2 < disk_file_bytes) {
+        compact_disk_file();
+    }
+}
+
+bool ResponseCache::load_disk_index() {
+    disk_index.clear();
+    disk_live_bytes = 0;
+
+    char file_header[FILE_HEADER_SIZE];
+    std::fseek(disk_file, 0, SEEK_SET);
+    bool valid = std::fread(file_header, 1, FILE_HEADER_SIZE, disk_file) == FILE_HEADER_SIZE &&
+                 std::memcmp(file_header, FILE_MAGIC, 4) == 0 &&
+                 get<uint32_t>(file_header + 4) == FILE_VERSION;
+    if (!valid) {
+        //new file or an older format, start over
+        std::fclose(disk_file);
+        disk_file = std::fopen(disk_path.c_str(), "w+b");
+        if (!disk_file || !write_file_header(disk_file)) {
+            return false;
+        }
+        std::fflush(disk_file);
+        disk_file_bytes = FILE_HEADER_SIZE;
+        return true;
+    }
+
+    //seeking past eof succeeds, so records are checked against the real length
+    if (std::fseek(disk_file, 0, SEEK_END) != 0) {
+        return false;
+    }
+    long end = std::ftell(disk_file);
+    if (end < 0) {
+        return false;
+    }
+    uint64_t file_length = static_cast<uint64_t>(end);
+
+    //scan records, stopping at a torn tail left by a crash mid-append
+    int64_t now = now_seconds();
+    uint64_t offset = FILE_HEADER_SIZE;
+    char header_bytes[RECORD_HEADER_SIZE];
+    while (offset + RECORD_HEADER_SIZE <= file_length) {
+        if (std::fseek(disk_file, static_cast<long>(offset), SEEK_SET) != 0 ||
+            std::fread(header_bytes, 1, RECORD_HEADER_SIZE, disk_file) != RECORD_HEADER_SIZE) {
+            break;
+        }
+        RecordHeader header = decode_header(header_bytes);
+        if (header.magic != RECORD_MAGIC) {
+            break;
+        }
+        uint64_t size = RECORD_HEADER_SIZE + static_cast<uint64_t>(header.body_len) + header.content_len;
+        if (offset + size > file_length) {
+            break;
+        }
+
+        auto existing = disk_index.find(header.key);
+        if (existing != disk_index.end()) {
+            disk_live_bytes -= existing->second.size;
+            disk_index.erase(existing);
+        }
+        if (header.expires_at > now) {
+            disk_index[header.key] = {offset, static_cast<uint32_t>(size), header.expires_at};
+            disk_live_bytes += size;
+        }
+        offset += size;
+    }
+    disk_file_bytes = offset;
+
+    //drop the torn tail so new records append right after the last good one,
+    //the file only ever shrinks here
+    if (file_length > disk_file_bytes) {
+        std::fclose(disk_file);
+        std::error_code ec;
+        std::filesystem::resize_file(disk_path, disk_file_bytes, ec);
+        disk_file = std::fopen(disk_path.c_str(), "r+b");
+        if (!disk_file) {
+            return false;
+        }
+    }
+
+    if (disk_file_bytes > COMPACT_MIN_BYTES && disk_live_bytes * 2 < disk_file_bytes) {
+        compact_disk_file();
+    }
+    return disk_file != nullptr;
+}
+
+void ResponseCache::compact_disk_file() {
+    std::string temp_path = disk_path + ".tmp";
+    std::FILE* out = std::fopen(temp_path.c_str(), "wb");
+    if (!out || !write_file_header(out)) {
+        if (out) {
+            std::fclose(out);
+        }
+        return;
+    }
+
+    std::unordered_map<uint64_t, DiskEntry> compacted;
+    uint64_t offset = FILE_HEADER_SIZE;
+    std::vector<char> record;
+    bool ok = true;
+    for (const auto& pair : disk_index) {
+        const DiskEntry& entry = pair.second;
+        record.resize(entry.size);
+        if (std::fseek(disk_file, static_cast<long>(entry.offset), SEEK_SET) != 0 ||
+            std::fread(record.data(), 1, record.size(), disk_file) != record.size() ||
+            std::fwrite(record.data(), 1, record.size(), out) != record.size()) {
+            ok = false;
+            break;
+        }
+        compacted[pair.first] = {offset, entry.size, entry.expires_at};
+        offset += entry.size;
+    }
+    std::fclose(out);
+
+    if (!ok) {
+        std::remove(temp_path.c_str());
+        return;
+    }
+
+    std::fclose(disk_file);
+    std::error_code ec;
+    std::filesystem::rename(temp_path, disk_path, ec);
+    disk_file = std::fopen(disk_path.c_str(), "r+b");
+    if (ec || !disk_file) {
+        //old file is still intact (or gone), rebuild from whatever is there
+        disk_index.clear();
+        disk_live_bytes = 0;
+        disk_file_bytes = 0;
+        if (disk_file) {
+            load_disk_index();
+        }
+        return;
+    }
+
+    disk_index.swap(compacted);
+    disk_live_bytes = offset - FILE_HEADER_SIZE;
+    disk_file_bytes = offset;
+}
+
+void ResponseCache::set_memory_capacity(size_t max_entries, size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    max_memory_entries = max_entries;
+    max_memory_bytes = max_bytes;
+    evict_to_capacity();
+}
+
+void ResponseCache::set_default_ttl(int seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    default_ttl_seconds = seconds > 0 ? seconds : 1;
+}
+
+int ResponseCache::get_default_ttl() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return default_ttl_seconds;
+}
+
+bool ResponseCache::open_disk_tier(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (disk_file) {
+        std::fclose(disk_file);
+        disk_file = nullptr;
+    }
+
+    disk_path = path;
+    disk_file = std::fopen(path.c_str(), "r+b");
+    if (!disk_file) {
+        disk_file = std::fopen(path.c_str(), "w+b");
+    }
+    if (!disk_file) {
+        return false;
+    }
+
+    if (!load_disk_index()) {
+        if (disk_file) {
+            std::fclose(disk_file);
+            disk_file = nullptr;
+        }
+        disk_index.clear();
+        return false;
+    }
+    return true;
+}
+
+void ResponseCache::close_disk_tier() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (disk_file) {
+        std::fclose(disk_file);
+        disk_file = nullptr;
+    }
+    disk_index.clear();
+    disk_live_bytes = 0;
+    disk_file_bytes = 0;
+}
+
+void ResponseCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    lru.clear();
+    memory_index.clear();
+    memory_bytes = 0;
+
+    if (disk_file) {
+        std::fclose(disk_file);
+        disk_file = std::fopen(disk_path.c_str(), "w+b");
+        if (disk_file && write_file_header(disk_file)) {
+            std::fflush(disk_file);
+        }
+    }
+    disk_index.clear();
+    disk_live_bytes = 0;
+    disk_file_bytes = FILE_HEADER_SIZE;
+}
+
+ResponseCacheStats ResponseCache::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    ResponseCacheStats result = stats;
+    result.memory_entries = lru.size();
+    result.memory_bytes = memory_bytes;
+    result.disk_entries = disk_index.size();
+    return result;
+}
+
+} // namespace necronomicore
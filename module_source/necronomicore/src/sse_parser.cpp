@@ -0,0 +1,82 @@
+#include "sse_parser.h"
+
+namespace necronomicore {
+
+SSEParser::SSEParser() : has_data(false) {
+}
+
+void SSEParser::feed(const char* data, size_t size, const std::function<void(const std::string&)>& on_event) {
+    size_t start = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] != '\n') {
+            continue;
+        }
+        
+        line_buffer.append(data + start, i - start);
+        start = i + 1;
+        
+        //lines may end in \r\n
+        if (!line_buffer.empty() && line_buffer.back() == '\r') {
+            line_buffer.pop_back();
+        }
+        handle_line(line_buffer, on_event);
+        line_buffer.clear();
+    }
+    
+    //keep the partial line for the next chunk
+    line_buffer.append(data + start, size - start);
+}
+
+void SSEParser::handle_line(const std::string& line, const std::function<void(const std::string&)>& on_event) {
+    //blank line dispatches the event
+    if (line.empty()) {
+        if (has_data) {
+            on_event(event_data);
+        }
+        event_data.clear();
+        has_data = false;
+        return;
+    }
+    
+    //comment / keep-alive
+    if (line[0] == ':') {
+        return;
+    }
+    
+    size_t colon = line.find(':');
+    std::string field = line.substr(0, colon);
+    if (field != "data") {
+        return; //event, id and retry fields are not used by the api
+    }
+    
+    size_t value_start = colon == std::string::npos ? line.size() : colon + 1;
+    if (value_start < line.size() && line[value_start] == ' ') {
+        value_start++;
+    }
+    
+    //multiple data lines join with newlines
+    if (has_data) {
+        event_data += '\n';
+    }
+    event_data.append(line, value_start, std::string::npos);
+    has_data = true;
+}
+
+void SSEParser::finish(const std::function<void(const std::string&)>& on_event) {
+    if (!line_buffer.empty()) {
+        handle_line(line_buffer, on_event);
+        line_buffer.clear();
+    }
+    if (has_data) {
+        on_event(event_data);
+    }
+    reset();
+}
+
+void SSEParser::reset() {
+    line_buffer.clear();
+    event_data.clear();
+    has_data = false;
+}
+
+} // namespace necronomicore